@@ -0,0 +1,504 @@
+/*
+ * Throughput benchmark for the HW9 engine.
+ *
+ * Runs hw9() with pacing disabled in each requested mode over generated inputs of each requested word count and each
+ * requested thread count, and in each requested claim lock kind for the modes that serialize claims with a lock. Every
+ * configuration is run a number of times for warm-up, then timed repeatedly. With --pool, every run shares one
+ * persistent thread pool instead of creating its threads, as a long-lived caller would. The report gives the median
+ * wall time with a distribution-free confidence interval for it (taken from the order statistics of the samples), along
+ * with the throughput in words and bytes per second at the median.
+ */
+
+#include "../include/hw9.h"
+
+#include "../include/util/lists.h"
+#include "../include/util/memory.h"
+#include "../include/util/string.h"
+#include "../include/util/file.h"
+#include "../include/util/random.h"
+#include "../include/util/time.h"
+#include "../include/util/guard.h"
+#include "../include/util/error.h"
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <limits.h>
+#include <string.h>
+#include <stdio.h>
+#include <errno.h>
+#include <time.h>
+#include <getopt.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+/**
+ * The median of a set of timing samples and a confidence interval for it.
+ */
+struct MedianEstimate {
+    double median;
+    double lowerBound;
+    double upperBound;
+    /** The probability that the interval covers the true median. */
+    double confidence;
+};
+
+static void printUsage(FILE *stream, char const *programName);
+static SizeList parseSizeList(char const *text, bool allowZero);
+static SizeList parseModeList(char const *text);
+static SizeList parseLockKindList(char const *text);
+static bool modeUsesClaimLock(enum HW9Mode mode);
+static size_t parsePositiveSize(char const *text);
+
+static char *generateInput(char const *directoryPath, size_t wordCount, size_t *byteCountOutPtr);
+static double timeRun(
+    char const *inFilePath,
+    char const *outFilePath,
+    struct HW9Options const *options
+);
+static struct MedianEstimate estimateMedian(double *samples, size_t sampleCount, double targetConfidence);
+static int compareDoubles(void const *aPtr, void const *bPtr);
+
+static char const * const allModeNames = "mutex,nomutex,ordered,batched,lockfree,sharded,stealing,pipeline";
+static double const benchmarkConfidence = (double)95 / 100;
+
+int main(int const argc, char ** const argv) {
+    static struct option const longOptions[] = {
+        {"modes", required_argument, NULL, 'm'},
+        {"locks", required_argument, NULL, 'l'},
+        {"words", required_argument, NULL, 'w'},
+        {"threads", required_argument, NULL, 't'},
+        {"warmup", required_argument, NULL, 'u'},
+        {"repeat", required_argument, NULL, 'r'},
+        {"dir", required_argument, NULL, 'd'},
+        {"pool", no_argument, NULL, 'p'},
+        {"help", no_argument, NULL, 'h'},
+        {NULL, 0, NULL, 0}
+    };
+
+    char const *modesText = allModeNames;
+    char const *lockKindsText = "pthread";
+    char const *wordCountsText = "10000,100000";
+    char const *threadCountsText = "1,2,4,8";
+    size_t warmupCount = 1;
+    size_t repeatCount = 7;
+    bool usePool = false;
+    char const *parentDirectoryPath = getenv("TMPDIR");
+    if (parentDirectoryPath == NULL) {
+        parentDirectoryPath = "/tmp";
+    }
+
+    while (true) {
+        int const option = getopt_long(argc, argv, "m:l:w:t:u:r:d:ph", longOptions, NULL);
+        if (option == -1) {
+            break;
+        }
+
+        switch (option) {
+            case 'm':
+                modesText = optarg;
+                break;
+            case 'l':
+                lockKindsText = optarg;
+                break;
+            case 'w':
+                wordCountsText = optarg;
+                break;
+            case 't':
+                threadCountsText = optarg;
+                break;
+            case 'u': {
+                SizeList const values = parseSizeList(optarg, true);
+                guard(SizeList_count(values) == 1, "hw9-bench: --warmup takes a single count");
+                warmupCount = SizeList_get(values, 0);
+                SizeList_destroy(values);
+                break;
+            }
+            case 'r':
+                repeatCount = parsePositiveSize(optarg);
+                break;
+            case 'd':
+                parentDirectoryPath = optarg;
+                break;
+            case 'p':
+                usePool = true;
+                break;
+            case 'h':
+                printUsage(stdout, argv[0]);
+                return EXIT_SUCCESS;
+            default:
+                printUsage(stderr, argv[0]);
+                return EXIT_FAILURE;
+        }
+    }
+    if (optind != argc) {
+        printUsage(stderr, argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    SizeList const modes = parseModeList(modesText);
+    SizeList const lockKinds = parseLockKindList(lockKindsText);
+    SizeList const wordCounts = parseSizeList(wordCountsText, false);
+    SizeList const threadCounts = parseSizeList(threadCountsText, false);
+
+    char * const directoryPath = formatString("%s/hw9-bench-XXXXXX", parentDirectoryPath);
+    if (mkdtemp(directoryPath) == NULL) {
+        int const mkdtempErrorCode = errno;
+        char const * const mkdtempErrorMessage = strerror(mkdtempErrorCode);
+        abortWithErrorFmt(
+            "hw9-bench: Failed to create work directory \"%s\" using mkdtemp (error code: %d; error message: \"%s\")",
+            directoryPath,
+            mkdtempErrorCode,
+            mkdtempErrorMessage
+        );
+    }
+
+    double * const samples = safeMalloc(sizeof *samples * repeatCount, "hw9-bench");
+
+    // The pool needs a thread for every thread of the largest run, including the pipeline's reader and writer
+    ThreadPool pool = NULL;
+    if (usePool) {
+        size_t maxThreadCount = 0;
+        for (size_t i = 0; i < SizeList_count(threadCounts); i += 1) {
+            if (SizeList_get(threadCounts, i) > maxThreadCount) {
+                maxThreadCount = SizeList_get(threadCounts, i);
+            }
+        }
+        pool = ThreadPool_create(maxThreadCount + 2, maxThreadCount + 2, 0, false, "hw9-bench");
+    }
+
+    printf(
+        "%-9s %-8s %10s %7s %12s %25s %14s %10s\n",
+        "mode", "lock", "words", "threads", "median (ms)", "CI (ms)", "words/s", "MB/s"
+    );
+    for (size_t wordCountIndex = 0; wordCountIndex < SizeList_count(wordCounts); wordCountIndex += 1) {
+        size_t const wordCount = SizeList_get(wordCounts, wordCountIndex);
+        size_t byteCount;
+        char * const inFilePath = generateInput(directoryPath, wordCount, &byteCount);
+
+        for (size_t modeIndex = 0; modeIndex < SizeList_count(modes); modeIndex += 1) {
+            size_t const modeValue = SizeList_get(modes, modeIndex);
+            enum HW9Mode const mode = (enum HW9Mode)modeValue;
+            char * const outFilePath = formatString("%s/out.%s", directoryPath, HW9Mode_name(mode));
+
+            // Modes without a claim lock run once, whichever lock kinds were requested
+            size_t const modeLockKindCount = modeUsesClaimLock(mode) ? SizeList_count(lockKinds) : 1;
+            for (size_t lockKindIndex = 0; lockKindIndex < modeLockKindCount; lockKindIndex += 1) {
+                size_t const lockKindValue = SizeList_get(lockKinds, lockKindIndex);
+                enum HW9LockKind const lockKind = (enum HW9LockKind)lockKindValue;
+
+                for (
+                    size_t threadCountIndex = 0;
+                    threadCountIndex < SizeList_count(threadCounts);
+                    threadCountIndex += 1
+                ) {
+                    size_t const threadCount = SizeList_get(threadCounts, threadCountIndex);
+                    guardFmt(threadCount <= UINT_MAX, "hw9-bench: thread count %zu is too large", threadCount);
+
+                    struct HW9Options options = HW9Options_default();
+                    options.mode = mode;
+                    options.lockKind = lockKind;
+                    options.threadCount = (unsigned int)threadCount;
+                    options.pacing.kind = PacingKind_None;
+                    options.threadPool = pool;
+
+                    for (size_t i = 0; i < warmupCount; i += 1) {
+                        timeRun(inFilePath, outFilePath, &options);
+                    }
+                    for (size_t i = 0; i < repeatCount; i += 1) {
+                        samples[i] = timeRun(inFilePath, outFilePath, &options);
+                    }
+
+                    struct MedianEstimate const estimate = estimateMedian(samples, repeatCount, benchmarkConfidence);
+                    char * const intervalText = formatString(
+                        "%.3f-%.3f (%.1f%%)",
+                        estimate.lowerBound * 1000,
+                        estimate.upperBound * 1000,
+                        estimate.confidence * 100
+                    );
+                    printf(
+                        "%-9s %-8s %10zu %7zu %12.3f %25s %14.0f %10.2f\n",
+                        HW9Mode_name(mode),
+                        modeUsesClaimLock(mode) ? HW9LockKind_name(lockKind) : "-",
+                        wordCount,
+                        threadCount,
+                        estimate.median * 1000,
+                        intervalText,
+                        (double)wordCount / estimate.median,
+                        (double)byteCount / estimate.median / 1000000
+                    );
+                    fflush(stdout);
+                    free(intervalText);
+                }
+            }
+
+            remove(outFilePath);
+            free(outFilePath);
+        }
+
+        remove(inFilePath);
+        free(inFilePath);
+    }
+
+    if (pool != NULL) {
+        ThreadPool_destroy(pool);
+    }
+    free(samples);
+    rmdir(directoryPath);
+    free(directoryPath);
+    SizeList_destroy(modes);
+    SizeList_destroy(lockKinds);
+    SizeList_destroy(wordCounts);
+    SizeList_destroy(threadCounts);
+    return EXIT_SUCCESS;
+}
+
+/**
+ * Print the benchmark's usage.
+ *
+ * @param stream The stream to print to.
+ * @param programName The name the program was invoked as.
+ */
+static void printUsage(FILE * const stream, char const * const programName) {
+    fprintf(
+        stream,
+        "Usage: %s [options]\n"
+        "\n"
+        "Options:\n"
+        "  -m, --modes LIST      Comma-separated modes to run (default: all)\n"
+        "  -l, --locks LIST      Comma-separated claim lock kinds (pthread, adaptive, ticket, mcs) for the mutex,\n"
+        "                        ordered, and batched modes (default: pthread)\n"
+        "  -w, --words LIST      Comma-separated input sizes in words (default: 10000,100000)\n"
+        "  -t, --threads LIST    Comma-separated thread counts (default: 1,2,4,8)\n"
+        "  -u, --warmup N        Untimed runs before each measurement (default: 1)\n"
+        "  -r, --repeat N        Timed runs per measurement (default: 7)\n"
+        "  -d, --dir PATH        Directory for generated inputs and outputs (default: $TMPDIR or /tmp)\n"
+        "  -p, --pool            Run every measurement on one persistent thread pool\n"
+        "  -h, --help            Print this message\n",
+        programName
+    );
+}
+
+/**
+ * Parse a comma-separated list of non-negative decimal integers, aborting if it is malformed.
+ *
+ * @param text The text to parse.
+ * @param allowZero Whether 0 is a valid element.
+ *
+ * @returns The parsed values. The caller is responsible for freeing this memory.
+ */
+static SizeList parseSizeList(char const * const text, bool const allowZero) {
+    SizeList const values = SizeList_create();
+
+    char const *elementStart = text;
+    while (true) {
+        char *elementEnd;
+        errno = 0;
+        unsigned long long const value = strtoull(elementStart, &elementEnd, 10);
+        guardFmt(
+            elementEnd != elementStart
+                && elementStart[0] >= '0' && elementStart[0] <= '9'
+                && errno == 0
+                && value <= SIZE_MAX
+                && (allowZero || value > 0)
+                && (*elementEnd == ',' || *elementEnd == '\0'),
+            "hw9-bench: invalid number list \"%s\"",
+            text
+        );
+        SizeList_add(values, (size_t)value);
+
+        if (*elementEnd == '\0') {
+            break;
+        }
+        elementStart = elementEnd + 1;
+    }
+
+    return values;
+}
+
+/**
+ * Parse a comma-separated list of mode names, aborting on an unknown name.
+ *
+ * @param text The text to parse.
+ *
+ * @returns The parsed modes, stored as size_t. The caller is responsible for freeing this memory.
+ */
+static SizeList parseModeList(char const * const text) {
+    SizeList const modes = SizeList_create();
+
+    char * const textCopy = formatString("%s", text);
+    char *savePtr = NULL;
+    for (char *name = strtok_r(textCopy, ",", &savePtr); name != NULL; name = strtok_r(NULL, ",", &savePtr)) {
+        enum HW9Mode const mode = HW9Mode_parse(name);
+        SizeList_add(modes, (size_t)mode);
+    }
+    free(textCopy);
+
+    guardFmt(SizeList_count(modes) > 0, "hw9-bench: no modes given in \"%s\"", text);
+    return modes;
+}
+
+/**
+ * Parse a comma-separated list of claim lock kind names, aborting on an unknown name.
+ *
+ * @param text The text to parse.
+ *
+ * @returns The parsed lock kinds, stored as size_t. The caller is responsible for freeing this memory.
+ */
+static SizeList parseLockKindList(char const * const text) {
+    SizeList const lockKinds = SizeList_create();
+
+    char * const textCopy = formatString("%s", text);
+    char *savePtr = NULL;
+    for (char *name = strtok_r(textCopy, ",", &savePtr); name != NULL; name = strtok_r(NULL, ",", &savePtr)) {
+        enum HW9LockKind const lockKind = HW9LockKind_parse(name);
+        SizeList_add(lockKinds, (size_t)lockKind);
+    }
+    free(textCopy);
+
+    guardFmt(SizeList_count(lockKinds) > 0, "hw9-bench: no lock kinds given in \"%s\"", text);
+    return lockKinds;
+}
+
+/**
+ * Get whether the mode serializes claims with the lock selected by HW9Options.lockKind.
+ *
+ * @param mode The mode.
+ *
+ * @returns Whether the lock kind affects the mode.
+ */
+static bool modeUsesClaimLock(enum HW9Mode const mode) {
+    return mode == HW9Mode_Mutex || mode == HW9Mode_Ordered || mode == HW9Mode_Batched;
+}
+
+/**
+ * Parse a single positive decimal integer, aborting if it is malformed.
+ *
+ * @param text The text to parse.
+ *
+ * @returns The parsed value.
+ */
+static size_t parsePositiveSize(char const * const text) {
+    SizeList const values = parseSizeList(text, false);
+    guardFmt(SizeList_count(values) == 1, "hw9-bench: expected a single number, got \"%s\"", text);
+    size_t const value = SizeList_get(values, 0);
+    SizeList_destroy(values);
+    return value;
+}
+
+/**
+ * Write an input file of random lowercase words, one per line.
+ *
+ * @param directoryPath The directory to create the file in.
+ * @param wordCount The number of words to write.
+ * @param byteCountOutPtr Where to store the size of the file in bytes.
+ *
+ * @returns The path of the new file. The caller is responsible for freeing this memory.
+ */
+static char *generateInput(char const * const directoryPath, size_t const wordCount, size_t * const byteCountOutPtr) {
+    char * const filePath = formatString("%s/words-%zu.data", directoryPath, wordCount);
+    FILE * const file = safeFopen(filePath, "w", "hw9-bench generateInput");
+
+    initializeRandom((unsigned int)wordCount);
+    size_t byteCount = 0;
+    for (size_t i = 0; i < wordCount; i += 1) {
+        int const wordLength = randomInt(3, 11);
+        for (int j = 0; j < wordLength; j += 1) {
+            fputc('a' + randomInt(0, 26), file);
+        }
+        fputc('\n', file);
+        byteCount += (size_t)wordLength + 1;
+    }
+
+    fclose(file);
+    *byteCountOutPtr = byteCount;
+    return filePath;
+}
+
+/**
+ * Run hw9 once and measure its wall time.
+ *
+ * @param inFilePath The input file.
+ * @param outFilePath The output file.
+ * @param options The run options.
+ *
+ * @returns The wall time in seconds.
+ */
+static double timeRun(
+    char const * const inFilePath,
+    char const * const outFilePath,
+    struct HW9Options const * const options
+) {
+    struct timespec const startTime = safeClockGettime(CLOCK_MONOTONIC, "hw9-bench timeRun");
+    hw9(inFilePath, outFilePath, options);
+    struct timespec const endTime = safeClockGettime(CLOCK_MONOTONIC, "hw9-bench timeRun");
+
+    return nanosecondsToSeconds(elapsedNanoseconds(startTime, endTime));
+}
+
+/**
+ * Estimate the median of the distribution the samples were drawn from. The interval is the narrowest pair of order
+ * statistics symmetric about the middle whose binomial coverage is at least the target confidence; with too few
+ * samples to reach it, the interval is the whole sample range and the reported confidence is what that range achieves.
+ *
+ * @param samples The samples. These are sorted in place.
+ * @param sampleCount The number of samples. Must be positive.
+ * @param targetConfidence The desired coverage probability, between 0 and 1.
+ *
+ * @returns The estimate.
+ */
+static struct MedianEstimate estimateMedian(
+    double * const samples,
+    size_t const sampleCount,
+    double const targetConfidence
+) {
+    guard(sampleCount > 0, "estimateMedian: sampleCount must be positive");
+    qsort(samples, sampleCount, sizeof *samples, compareDoubles);
+
+    double const median = sampleCount % 2 == 1
+        ? samples[sampleCount / 2]
+        : (samples[sampleCount / 2 - 1] + samples[sampleCount / 2]) / 2;
+
+    // The interval [x(k), x(n - 1 - k)] (0-based order statistics) misses the median exactly when fewer than k + 1
+    // samples fall on one side of it, so its coverage is 1 - 2 * P(Binomial(n, 1/2) <= k)
+    double binomialProbability = 1;
+    for (size_t i = 0; i < sampleCount; i += 1) {
+        binomialProbability /= 2;
+    }
+    double cumulativeProbability = binomialProbability;
+    size_t lowerIndex = 0;
+    double confidence = 1 - 2 * cumulativeProbability;
+    for (size_t k = 1; k < sampleCount / 2; k += 1) {
+        binomialProbability *= (double)(sampleCount - k + 1) / (double)k;
+        double const nextCumulativeProbability = cumulativeProbability + binomialProbability;
+        double const nextConfidence = 1 - 2 * nextCumulativeProbability;
+        if (nextConfidence < targetConfidence) {
+            break;
+        }
+        cumulativeProbability = nextCumulativeProbability;
+        confidence = nextConfidence;
+        lowerIndex = k;
+    }
+
+    return (struct MedianEstimate){
+        .median = median,
+        .lowerBound = samples[lowerIndex],
+        .upperBound = samples[sampleCount - 1 - lowerIndex],
+        .confidence = confidence
+    };
+}
+
+/**
+ * Compare two doubles for qsort.
+ *
+ * @param aPtr The first double.
+ * @param bPtr The second double.
+ *
+ * @returns A negative number, zero, or a positive number as the first double is less than, equal to, or greater than
+ *          the second.
+ */
+static int compareDoubles(void const * const aPtr, void const * const bPtr) {
+    double const a = *(double const *)aPtr;
+    double const b = *(double const *)bPtr;
+    return (a > b) - (a < b);
+}
@@ -1,9 +1,122 @@
 #pragma once
 
+#include "./util/Pacer.h"
+#include "./util/thread.h"
+
+#include <stdlib.h>
+#include <stdbool.h>
+
 enum HW9Mode {
     HW9Mode_Mutex,
-    HW9Mode_NoMutex
+    HW9Mode_NoMutex,
+    HW9Mode_Ordered,
+    HW9Mode_Batched,
+    HW9Mode_LockFree,
+    HW9Mode_Sharded,
+    HW9Mode_WorkStealing,
+    HW9Mode_Pipeline
 };
 enum HW9Mode HW9Mode_parse(char const *name);
+char const *HW9Mode_name(enum HW9Mode mode);
+
+enum HW9LockKind {
+    HW9LockKind_Pthread,
+    HW9LockKind_Adaptive,
+    HW9LockKind_Ticket,
+    HW9LockKind_Mcs
+};
+enum HW9LockKind HW9LockKind_parse(char const *name);
+char const *HW9LockKind_name(enum HW9LockKind kind);
+
+enum HW9IoBackend {
+    HW9IoBackend_Stdio,
+    HW9IoBackend_IoUring,
+    HW9IoBackend_Async
+};
+enum HW9IoBackend HW9IoBackend_parse(char const *name);
+char const *HW9IoBackend_name(enum HW9IoBackend backend);
+
+enum HW9OutputFormat {
+    HW9OutputFormat_Text,
+    HW9OutputFormat_Columnar
+};
+enum HW9OutputFormat HW9OutputFormat_parse(char const *name);
+char const *HW9OutputFormat_name(enum HW9OutputFormat format);
+
+enum HW9FileOutput {
+    HW9FileOutput_Concatenated,
+    HW9FileOutput_PerFile
+};
+enum HW9FileOutput HW9FileOutput_parse(char const *name);
+char const *HW9FileOutput_name(enum HW9FileOutput fileOutput);
+
+/**
+ * Tuning options for a HW9 run. Obtain the defaults from HW9Options_default and override individual fields.
+ */
+struct HW9Options {
+    /** Which synchronization scheme the threads use. */
+    enum HW9Mode mode;
+    /** The number of threads to launch. */
+    unsigned int threadCount;
+    /** Batched mode: the number of words claimed per lock acquisition, or 0 to adapt it to lock wait time. */
+    size_t batchSize;
+    /**
+     * Read the input through a memory mapping, claiming each word as a span into it instead of copying it through
+     * stdio. The LockFree, Sharded, and WorkStealing modes always do this; NoMutex mode does not support it.
+     */
+    bool mappedInput;
+    /** WorkStealing mode: the number of words per chunk, or 0 to give each thread several chunks. */
+    size_t chunkSize;
+    /** Pipeline mode: the most items each of the word and line queues can hold. */
+    size_t queueCapacity;
+    /** Pin each thread to its own CPU, wrapping around when there are more threads than CPUs. */
+    bool pinThreads;
+    /** How each worker thread is delayed after each word. Use PacingKind_None to measure the processing itself. */
+    struct PacingPolicy pacing;
+    /** Where to write a JSON report of each worker's counters and resource usage, or null for no report. */
+    char const *statsFilePath;
+    /** Mutex, Ordered, Batched modes: which lock serializes word claims. */
+    enum HW9LockKind lockKind;
+    /**
+     * How the input is read and the output written. IoUring reads the whole input with batched io_uring reads (except
+     * in NoMutex mode, which keeps reading through stdio) and writes each buffered output block with an io_uring write.
+     * If the kernel does not provide io_uring, or the output is not a regular file, this falls back to Stdio. Async
+     * reads like Stdio but copies output into one of two in-memory buffers, which a background thread writes to the
+     * file, and fsyncs the file at the end if it is a regular file.
+     */
+    enum HW9IoBackend ioBackend;
+    /**
+     * The layout of the output file. Text writes a "word\tthread" line per word. Columnar collects those lines in
+     * memory and writes them at the end as a dictionary of distinct words, a fixed-width word ID per line, and the
+     * thread numbers as bit-packed runs; ColumnarOutput_writeText converts it back to text.
+     */
+    enum HW9OutputFormat outputFormat;
+    /**
+     * hw9Files: where each input file's lines go. Concatenated writes them all to the output file, in input file order.
+     * PerFile writes each input file's lines to its own output file, named after the output file plus "." and the
+     * input file's 1-based position.
+     */
+    enum HW9FileOutput fileOutput;
+    /**
+     * The characters that separate words, e.g. " \t\r\n", or null to read one word per line. Words are separated by
+     * any run of these characters, so blank lines, repeated spaces, and CRLF line endings produce no empty words. The
+     * input is always read through a tokenizer when this is set; NoMutex mode does not support it.
+     */
+    char const *wordDelimiters;
+    /**
+     * The thread pool to run the worker threads on, or null to create and join threads on every call. A long-lived
+     * caller can reuse one pool across calls so that thread startup is not paid per call. The pool must have a free
+     * thread for every thread the mode runs at once (threadCount, plus 2 in Pipeline mode), since they wait on each
+     * other. pinThreads is not used with a pool; create the pool pinned instead.
+     */
+    ThreadPool threadPool;
+};
+struct HW9Options HW9Options_default(void);
 
-void hw9(char const *inFilePath, char const *outFilePath, enum HW9Mode mode, unsigned int threadCount);
+void hw9(char const *inFilePath, char const *outFilePath, struct HW9Options const *options);
+void hw9Files(
+    char const * const *inFilePaths,
+    size_t inFilePathCount,
+    char const *outFilePath,
+    struct HW9Options const *options
+);
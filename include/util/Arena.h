@@ -0,0 +1,16 @@
+#pragma once
+
+#include <stdlib.h>
+#include <stdbool.h>
+
+typedef struct Arena * Arena;
+typedef struct Arena const * ConstArena;
+
+Arena Arena_create(size_t blockCapacity, bool hugePages);
+void Arena_destroy(Arena arena);
+
+void *Arena_alloc(Arena arena, size_t size);
+void *Arena_allocAligned(Arena arena, size_t size, size_t alignment);
+void *Arena_grow(Arena arena, void *memory, size_t oldSize, size_t newSize);
+char *Arena_copyChars(Arena arena, char const *chars, size_t length);
+void Arena_reset(Arena arena);
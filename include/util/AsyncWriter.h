@@ -0,0 +1,15 @@
+#pragma once
+
+#include <stdlib.h>
+#include <stdio.h>
+
+struct AsyncWriter;
+typedef struct AsyncWriter * AsyncWriter;
+typedef struct AsyncWriter const * ConstAsyncWriter;
+
+AsyncWriter AsyncWriter_open(char const *filePath, size_t bufferCapacity, char const *callerDescription);
+void AsyncWriter_close(AsyncWriter writer);
+
+void AsyncWriter_write(AsyncWriter writer, char const *chars, size_t length);
+
+FILE *AsyncWriter_openStream(char const *filePath, size_t bufferCapacity, char const *callerDescription);
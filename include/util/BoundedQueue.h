@@ -0,0 +1,15 @@
+#pragma once
+
+#include <stdlib.h>
+#include <stdbool.h>
+
+struct BoundedQueue;
+typedef struct BoundedQueue * BoundedQueue;
+typedef struct BoundedQueue const * ConstBoundedQueue;
+
+BoundedQueue BoundedQueue_create(size_t capacity);
+void BoundedQueue_destroy(BoundedQueue queue);
+
+void BoundedQueue_push(BoundedQueue queue, void *item);
+bool BoundedQueue_pop(BoundedQueue queue, void **itemOutPtr);
+void BoundedQueue_close(BoundedQueue queue);
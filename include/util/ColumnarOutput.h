@@ -0,0 +1,6 @@
+#pragma once
+
+#include <stdio.h>
+
+FILE *ColumnarOutput_openStream(FILE *binaryFile, char const *callerDescription);
+void ColumnarOutput_writeText(FILE *binaryFile, FILE *textFile, char const *callerDescription);
@@ -0,0 +1,22 @@
+#pragma once
+
+#include "./string.h"
+#include "./delimiterScan.h"
+
+#include <stdlib.h>
+#include <stdbool.h>
+
+struct LineTokenizer;
+typedef struct LineTokenizer * LineTokenizer;
+typedef struct LineTokenizer const * ConstLineTokenizer;
+
+LineTokenizer LineTokenizer_create(char const *chars, size_t length);
+LineTokenizer LineTokenizer_createWords(
+    char const *chars,
+    size_t length,
+    struct DelimiterSet const *wordDelimitersPtr
+);
+void LineTokenizer_destroy(LineTokenizer tokenizer);
+
+bool LineTokenizer_next(LineTokenizer tokenizer, struct StringSpan *lineOutPtr);
+void LineTokenizer_reset(LineTokenizer tokenizer);
@@ -0,0 +1,13 @@
+#pragma once
+
+#include <stdlib.h>
+
+struct MappedFile;
+typedef struct MappedFile * MappedFile;
+typedef struct MappedFile const * ConstMappedFile;
+
+MappedFile MappedFile_open(char const *filePath, char const *callerDescription);
+void MappedFile_destroy(MappedFile file);
+
+char const *MappedFile_chars(ConstMappedFile file);
+size_t MappedFile_length(ConstMappedFile file);
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+enum PacingKind {
+    PacingKind_None,
+    PacingKind_Fixed,
+    PacingKind_Uniform,
+    PacingKind_Exponential,
+    PacingKind_Pareto,
+    PacingKind_TokenBucket
+};
+
+/**
+ * How a Pacer delays each unit of work.
+ */
+struct PacingPolicy {
+    /** Which kind of delay to apply. */
+    enum PacingKind kind;
+    /**
+     * Fixed: the delay. Uniform: the exclusive upper bound of the delay. Exponential: the mean delay. Pareto: the scale
+     * (the smallest possible delay).
+     */
+    uint64_t delayNanoseconds;
+    /** Pareto: the shape (tail index). Smaller values give heavier tails. Must be positive. */
+    double paretoShape;
+    /** TokenBucket: the rate, in units of work per second, shared by all threads. Must be positive. */
+    double ratePerSecond;
+    /** TokenBucket: the most units of work that may run back to back without waiting. Must be positive. */
+    unsigned int burst;
+    /** Uniform, Exponential, Pareto: the seed for every thread's random stream, or 0 to seed from the current time. */
+    unsigned int seed;
+};
+bool PacingPolicy_parse(char const *text, struct PacingPolicy *policyInOutPtr);
+
+struct Pacer;
+typedef struct Pacer * Pacer;
+typedef struct Pacer const * ConstPacer;
+
+Pacer Pacer_create(struct PacingPolicy const *policy, unsigned int threadCount);
+void Pacer_destroy(Pacer pacer);
+
+uint64_t Pacer_pace(Pacer pacer, unsigned int threadIndex);
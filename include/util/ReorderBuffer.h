@@ -0,0 +1,17 @@
+#pragma once
+
+#include <stdlib.h>
+#include <stdio.h>
+
+/**
+ * Writes lines submitted out of order in sequence-number order. At most a fixed number of lines, set when the buffer is
+ * created, are held at once: a line submitted too far ahead of the next line due blocks until that line is written.
+ */
+struct ReorderBuffer;
+typedef struct ReorderBuffer * ReorderBuffer;
+typedef struct ReorderBuffer const * ConstReorderBuffer;
+
+ReorderBuffer ReorderBuffer_create(FILE *outFile, size_t capacity);
+void ReorderBuffer_destroy(ReorderBuffer buffer);
+
+void ReorderBuffer_submit(ReorderBuffer buffer, size_t sequenceNumber, char *line);
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <stdlib.h>
+#include <stdarg.h>
+#include <stdio.h>
+
+struct Shard;
+typedef struct Shard * Shard;
+typedef struct Shard const * ConstShard;
+
+Shard Shard_create(char const *filePath);
+void Shard_destroy(Shard shard);
+
+size_t Shard_appendFmt(Shard shard, size_t sequenceNumber, char const *lineFormat, ...);
+size_t Shard_appendFmtVA(Shard shard, size_t sequenceNumber, char const *lineFormat, va_list lineFormatArgs);
+void Shard_finish(Shard shard);
+
+void Shard_mergeRange(
+    ConstShard const *shards,
+    size_t shardCount,
+    size_t sequenceStart,
+    size_t sequenceEnd,
+    FILE *outFile
+);
@@ -0,0 +1,22 @@
+#pragma once
+
+#include "./string.h"
+#include "./delimiterScan.h"
+
+#include <stdlib.h>
+#include <stdbool.h>
+
+struct StreamTokenizer;
+typedef struct StreamTokenizer * StreamTokenizer;
+typedef struct StreamTokenizer const * ConstStreamTokenizer;
+
+StreamTokenizer StreamTokenizer_create(int fileDescriptor, size_t windowCapacity, char const *filePath);
+StreamTokenizer StreamTokenizer_createWords(
+    int fileDescriptor,
+    size_t windowCapacity,
+    char const *filePath,
+    struct DelimiterSet const *wordDelimitersPtr
+);
+void StreamTokenizer_destroy(StreamTokenizer tokenizer);
+
+bool StreamTokenizer_next(StreamTokenizer tokenizer, struct StringSpan *lineOutPtr);
@@ -32,6 +32,7 @@ void StringBuilder_insertFmtVA(StringBuilder builder, size_t index, char const *
 
 void StringBuilder_removeAt(StringBuilder builder, size_t index);
 void StringBuilder_removeManyAt(StringBuilder builder, size_t startIndex, size_t count);
+void StringBuilder_clear(StringBuilder builder);
 
 char *StringBuilder_toString(ConstStringBuilder builder);
 char *StringBuilder_toStringAndDestroy(StringBuilder builder);
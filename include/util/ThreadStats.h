@@ -0,0 +1,56 @@
+#pragma once
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <pthread.h>
+
+/**
+ * A thread's CPU time and context switches, from getrusage(RUSAGE_THREAD).
+ */
+struct ThreadUsage {
+    uint64_t userCpuNanoseconds;
+    uint64_t systemCpuNanoseconds;
+    uint64_t voluntaryContextSwitches;
+    uint64_t involuntaryContextSwitches;
+};
+
+/**
+ * Counters describing one worker thread's run. Only the owning thread updates them; they are read once the thread has
+ * been joined.
+ */
+struct ThreadStats {
+    uint64_t wordCount;
+    uint64_t byteCount;
+    uint64_t lockWaitNanoseconds;
+    uint64_t maxLockWaitNanoseconds;
+    uint64_t lockHoldNanoseconds;
+    uint64_t sleepNanoseconds;
+
+    /**
+     * From getrusage(RUSAGE_THREAD), as of the thread's last ThreadStats_captureUsage call, less the usage when
+     * ThreadStats_beginUsage was first called (so that a pooled thread's earlier work is not counted).
+     */
+    uint64_t userCpuNanoseconds;
+    uint64_t systemCpuNanoseconds;
+    uint64_t voluntaryContextSwitches;
+    uint64_t involuntaryContextSwitches;
+
+    /** When the lock currently held was acquired, from cycleCount. */
+    uint64_t lockAcquireCycles;
+    bool usageBegun;
+    struct ThreadUsage usageBaseline;
+};
+
+void ThreadStats_init(struct ThreadStats *statsOutPtr);
+
+void ThreadStats_lockMutex(struct ThreadStats *statsPtr, pthread_mutex_t *mutexPtr, char const *callerDescription);
+void ThreadStats_unlockMutex(struct ThreadStats *statsPtr, pthread_mutex_t *mutexPtr, char const *callerDescription);
+void ThreadStats_addLockTimes(struct ThreadStats *statsPtr, uint64_t waitNanoseconds, uint64_t holdNanoseconds);
+void ThreadStats_addWords(struct ThreadStats *statsPtr, uint64_t wordCount, uint64_t byteCount);
+void ThreadStats_addSleep(struct ThreadStats *statsPtr, uint64_t sleepNanoseconds);
+void ThreadStats_beginUsage(struct ThreadStats *statsPtr);
+void ThreadStats_captureUsage(struct ThreadStats *statsPtr);
+
+void ThreadStats_writeJson(struct ThreadStats const *statsPtr, unsigned int threadNumber, FILE *outFile);
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * A set of delimiter characters, classified by scanDelimiterSet. Initialize with DelimiterSet_init.
+ */
+struct DelimiterSet {
+    /** One bit per character value, set for the delimiters. */
+    uint64_t members[4];
+    /** Indexed by low nibble: the buckets of the delimiters with that low nibble. */
+    uint8_t lowNibbleBuckets[16];
+    /** Indexed by high nibble: the bucket of the delimiters with that high nibble, or 0 if there are none. */
+    uint8_t highNibbleBuckets[16];
+    /** Whether the nibble tables describe the set exactly, i.e. the delimiters have at most 8 distinct high nibbles. */
+    bool vectorizable;
+};
+
+size_t scanDelimiters(
+    char const *chars,
+    size_t length,
+    char delimiter,
+    size_t *offsetsOut,
+    size_t offsetCapacity,
+    size_t *scannedLengthOutPtr
+);
+char const *delimiterScanImplementation(void);
+
+void DelimiterSet_init(struct DelimiterSet *setOutPtr, char const *delimiters, size_t delimiterCount);
+bool DelimiterSet_has(struct DelimiterSet const *setPtr, char c);
+size_t scanDelimiterSet(
+    char const *chars,
+    size_t length,
+    struct DelimiterSet const *delimitersPtr,
+    size_t *offsetsOut,
+    size_t offsetCapacity,
+    size_t *scannedLengthOutPtr
+);
@@ -1,7 +1,10 @@
 #pragma once
 
+#include "./Arena.h"
+
 #include <stdbool.h>
 #include <stdarg.h>
+#include <stdlib.h>
 #include <stdio.h>
 
 FILE *safeFopen(char const *filePath, char const *modes, char const *callerDescription);
@@ -18,13 +21,18 @@ unsigned int safeVfprintf(
     va_list formatArgs,
     char const *callerDescription
 );
+void safeFwrite(void const *chars, size_t length, FILE *file, char const *callerDescription);
+void safeFclose(FILE *file, char const *callerDescription);
 
 bool safeFgetc(char *charPtr, FILE *file, char const *callerDescription);
 bool safeFgets(char *buffer, size_t bufferLength, FILE *file, char const *callerDescription);
 
 char *readFileLine(FILE *file);
+char *readFileLineIntoArena(FILE *file, Arena arena);
 
 char *readAllFileText(char const *filePath);
+char *readAllFileDescriptor(int fileDescriptor, char const *filePath, size_t *lengthOutPtr);
+void appendFileContents(FILE *outFile, char const *filePath);
 
 int safeFscanf(
     FILE *file,
@@ -0,0 +1,7 @@
+#pragma once
+
+#include <stdlib.h>
+#include <stdio.h>
+
+char *ioUringReadAllFile(char const *filePath, size_t *lengthOutPtr, char const *callerDescription);
+FILE *ioUringFopenWrite(char const *filePath, char const *callerDescription);
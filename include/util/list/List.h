@@ -214,7 +214,7 @@
         guardNotNull(list, "list", STRINGIFY(TList##_removeAt)); \
         TList##_guardIndexInRange(list, index, STRINGIFY(TList##_removeAt)); \
         \
-        for (size_t i = index; i < list->count; i += 1) { \
+        for (size_t i = index; i < list->count - 1; i += 1) { \
             /* Shift each item at an index > the target index one to the left */ \
             list->items[i] = list->items[i + 1]; \
         } \
@@ -225,7 +225,7 @@
         guardNotNull(list, "list", STRINGIFY(TList##_removeManyAt)); \
         TList##_guardStartIndexAndCountInRange(list, startIndex, count, STRINGIFY(TList##_removeManyAt)); \
         \
-        for (size_t i = startIndex; i < list->count; i += 1) { \
+        for (size_t i = startIndex; i < list->count - count; i += 1) { \
             /* Shift each item at an index > the start index count to the left */ \
             list->items[i] = list->items[i + count]; \
         } \
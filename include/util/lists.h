@@ -4,3 +4,4 @@
 
 DECLARE_LIST(CharList, char)
 DECLARE_LIST(StringList, char *)
+DECLARE_LIST(SizeList, size_t)
@@ -2,5 +2,12 @@
 
 #include <stdlib.h>
 
+/**
+ * The assumed size of a CPU cache line, in bytes. Data written by different threads is aligned to this so that it never
+ * shares a line (false sharing).
+ */
+#define CACHE_LINE_SIZE 64
+
 void *safeMalloc(size_t size, char const *callerDescription);
 void *safeRealloc(void *memory, size_t newSize, char const *callerDescription);
+void *safeAlignedAlloc(size_t alignment, size_t size, char const *callerDescription);
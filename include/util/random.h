@@ -1,5 +1,25 @@
 #pragma once
 
+#include <stdlib.h>
+#include <stdint.h>
+
+/**
+ * The state of an xoshiro256** pseudo-random number generator. Each thread should own its own state, so that drawing a
+ * number touches no shared memory and takes no lock. Initialize it with Random_seed.
+ */
+struct Random {
+    uint64_t state[4];
+};
+
+void Random_seed(struct Random *randomOutPtr, uint64_t seed, uint64_t streamIndex);
+uint64_t Random_next(struct Random *randomPtr);
+uint64_t Random_nextBelow(struct Random *randomPtr, uint64_t bound);
+int Random_nextInt(struct Random *randomPtr, int minInclusive, int maxExclusive);
+double Random_nextDouble(struct Random *randomPtr);
+void Random_fill(struct Random *randomPtr, uint64_t *valuesOut, size_t valueCount);
+void Random_fillInts(struct Random *randomPtr, int *valuesOut, size_t valueCount, int minInclusive, int maxExclusive);
+
 void initializeRandom(unsigned int seed);
+void initializeThreadRandom(unsigned int threadIndex);
 
 int randomInt(int minInclusive, int maxExclusive);
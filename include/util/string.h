@@ -3,6 +3,14 @@
 #include <stdlib.h>
 #include <stdarg.h>
 
+/**
+ * A run of characters inside a larger buffer which the span does not own. The characters are not null-terminated.
+ */
+struct StringSpan {
+    char const *chars;
+    size_t length;
+};
+
 size_t safeSnprintf(
     char *buffer,
     size_t bufferLength,
@@ -1,7 +1,12 @@
 #pragma once
 
 #include "./callback.h"
+#include "./memory.h"
 
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdalign.h>
+#include <stdatomic.h>
 #include <pthread.h>
 
 DECLARE_FUNC(PthreadCreateStartRoutine, void *, void *)
@@ -14,6 +19,13 @@ pthread_t safePthreadCreate(
 );
 void *safePthreadJoin(pthread_t threadId, char const *callerDescription);
 
+void safePthreadAttrInit(pthread_attr_t *attributesOutPtr, char const *callerDescription);
+void safePthreadAttrSetCpu(pthread_attr_t *attributesPtr, size_t cpuSlot, char const *callerDescription);
+void safePthreadAttrSetStackSize(pthread_attr_t *attributesPtr, size_t stackSize, char const *callerDescription);
+void safePthreadAttrDestroy(pthread_attr_t *attributesPtr, char const *callerDescription);
+
+unsigned int availableCpuCount(void);
+
 void safeMutexInit(
     pthread_mutex_t *mutexOutPtr,
     pthread_mutexattr_t const *attributes,
@@ -23,15 +35,94 @@ void safeMutexLock(pthread_mutex_t *mutexPtr, char const *callerDescription);
 void safeMutexUnlock(pthread_mutex_t *mutexPtr, char const *callerDescription);
 void safeMutexDestroy(pthread_mutex_t *mutexPtr, char const *callerDescription);
 
+/**
+ * A mutex for short critical sections: a contended lock spins with exponential backoff for a number of iterations
+ * tuned to how long recent acquisitions took, and only then parks the thread on a futex. Use the safeAdaptiveMutex
+ * functions rather than the fields.
+ */
+struct AdaptiveMutex {
+    /** 0 when unlocked, 1 when locked, 2 when locked and a thread may be parked waiting for it. */
+    atomic_int state;
+    /** How many backoff iterations a contended lock spins for before parking. */
+    atomic_uint spinLimit;
+};
+
+void safeAdaptiveMutexInit(struct AdaptiveMutex *mutexOutPtr, char const *callerDescription);
+void safeAdaptiveMutexLock(struct AdaptiveMutex *mutexPtr, char const *callerDescription);
+void safeAdaptiveMutexUnlock(struct AdaptiveMutex *mutexPtr, char const *callerDescription);
+void safeAdaptiveMutexDestroy(struct AdaptiveMutex *mutexPtr, char const *callerDescription);
+
+/**
+ * A FIFO spin lock: each locking thread takes the next ticket and waits until it is being served, so the lock is handed
+ * to waiters in the order they arrived. Use the TicketLock functions rather than the fields.
+ */
+struct TicketLock {
+    alignas(CACHE_LINE_SIZE) atomic_uint nextTicket;
+    alignas(CACHE_LINE_SIZE) atomic_uint nowServing;
+};
+
+void TicketLock_init(struct TicketLock *lockOutPtr);
+void TicketLock_lock(struct TicketLock *lockPtr);
+void TicketLock_unlock(struct TicketLock *lockPtr);
+void TicketLock_destroy(struct TicketLock *lockPtr, char const *callerDescription);
+
+/**
+ * A waiting thread's place in an McsLock queue. Each thread passes its own node when locking and the same node when
+ * unlocking, and spins only on that node's cache line.
+ */
+struct McsLockNode {
+    alignas(CACHE_LINE_SIZE) _Atomic(struct McsLockNode *) next;
+    atomic_bool locked;
+};
+
+/**
+ * A FIFO queue lock (Mellor-Crummey and Scott): waiters form a linked queue of their own nodes, and each unlock hands
+ * the lock directly to the next waiter by writing to that waiter's node. Use the McsLock functions rather than the
+ * fields.
+ */
+struct McsLock {
+    alignas(CACHE_LINE_SIZE) _Atomic(struct McsLockNode *) tail;
+};
+
+void McsLock_init(struct McsLock *lockOutPtr);
+void McsLock_lock(struct McsLock *lockPtr, struct McsLockNode *nodePtr);
+void McsLock_unlock(struct McsLock *lockPtr, struct McsLockNode *nodePtr);
+void McsLock_destroy(struct McsLock *lockPtr, char const *callerDescription);
+
 void safeConditionInit(
     pthread_cond_t *conditionOutPtr,
     pthread_condattr_t const *attributes,
     char const *callerDescription
 );
 void safeConditionSignal(pthread_cond_t *conditionPtr, char const *callerDescription);
+void safeConditionBroadcast(pthread_cond_t *conditionPtr, char const *callerDescription);
 void safeConditionWait(
     pthread_cond_t *conditionPtr,
     pthread_mutex_t *mutexPtr,
     char const *callerDescription
 );
 void safeConditionDestroy(pthread_cond_t *conditionPtr, char const *callerDescription);
+
+struct ThreadPool;
+typedef struct ThreadPool * ThreadPool;
+typedef struct ThreadPool const * ConstThreadPool;
+
+ThreadPool ThreadPool_create(
+    size_t threadCount,
+    size_t queueCapacity,
+    size_t stackSize,
+    bool pinThreads,
+    char const *callerDescription
+);
+void ThreadPool_destroy(ThreadPool pool);
+
+size_t ThreadPool_threadCount(ConstThreadPool pool);
+void ThreadPool_submit(ThreadPool pool, PthreadCreateStartRoutine task, void *taskArg);
+void ThreadPool_submitBatch(
+    ThreadPool pool,
+    PthreadCreateStartRoutine task,
+    void *taskArgs,
+    size_t taskArgSize,
+    size_t taskCount
+);
+void ThreadPool_waitAll(ThreadPool pool);
@@ -1,5 +1,22 @@
 #pragma once
 
+#include <stdint.h>
 #include <time.h>
+#include <sys/time.h>
 
 time_t safeTime(char const *callerDescription);
+
+struct timespec safeClockGettime(clockid_t clockId, char const *callerDescription);
+void safeClockNanosleepUntil(clockid_t clockId, struct timespec wakeTime, char const *callerDescription);
+uint64_t monotonicNanoseconds(void);
+uint64_t threadCpuNanoseconds(void);
+
+uint64_t timespecToNanoseconds(struct timespec time);
+uint64_t timevalToNanoseconds(struct timeval time);
+uint64_t elapsedNanoseconds(struct timespec startTime, struct timespec endTime);
+double nanosecondsToSeconds(uint64_t nanoseconds);
+
+void calibrateCycleCounter(void);
+uint64_t cycleCount(void);
+uint64_t cyclesToNanoseconds(uint64_t cycles);
+uint64_t elapsedCycleNanoseconds(uint64_t startCycles, uint64_t endCycles);
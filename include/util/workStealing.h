@@ -0,0 +1,19 @@
+#pragma once
+
+#include "./callback.h"
+#include "./thread.h"
+
+#include <stdlib.h>
+#include <pthread.h>
+
+DECLARE_ACTION(WorkStealingRangeCallback, void *, unsigned int, size_t, size_t)
+
+void runWorkStealing(
+    size_t itemCount,
+    size_t chunkSize,
+    unsigned int workerCount,
+    pthread_attr_t const *workerAttributes,
+    ThreadPool workerPool,
+    void *state,
+    WorkStealingRangeCallback callback
+);
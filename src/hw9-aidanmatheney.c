@@ -24,23 +24,310 @@
  * when removing this sleep, the thread numbers continued to be inconsistent from run to run (however, without the
  * sleep, the thread numbers were less randomly distributed and more clustered, since constant processing allows a
  * thread to sometimes immediately reacquire the mutex after releasing it).
+ *
+ * Ordered mode keeps the input order of mutex mode while letting threads process words concurrently. A thread holds the
+ * mutex only long enough to read a word and take its sequence number, and a reorder buffer holds finished lines until
+ * every earlier line has been written.
  */
 
 #include "../include/hw9.h"
 
+#include "../include/util/ColumnarOutput.h"
+#include "../include/util/string.h"
+#include "../include/util/thread.h"
+#include "../include/util/file.h"
+#include "../include/util/lists.h"
+
 #include <stdlib.h>
+#include <stdbool.h>
 #include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <stdint.h>
+#include <limits.h>
+#include <getopt.h>
+
+static void printUsage(FILE *stream, char const *programName);
+static bool parseSize(char const *text, size_t *valueOutPtr);
+static bool parseThreadCount(char const *text, unsigned int *threadCountOutPtr);
 
 int main(int const argc, char ** const argv) {
-    if (argc != 2) {
-        fprintf(stderr, "Usage: %s mutex|nomutex\n", argv[0]);
+    static struct option const longOptions[] = {
+        {"input", required_argument, NULL, 'i'},
+        {"output", required_argument, NULL, 'o'},
+        {"threads", required_argument, NULL, 't'},
+        {"pin", no_argument, NULL, 'p'},
+        {"mapped", no_argument, NULL, 'm'},
+        {"no-pacing", no_argument, NULL, 'n'},
+        {"pacing", required_argument, NULL, 'P'},
+        {"seed", required_argument, NULL, 's'},
+        {"stats", required_argument, NULL, 'S'},
+        {"batch-size", required_argument, NULL, 'b'},
+        {"chunk-size", required_argument, NULL, 'c'},
+        {"queue-capacity", required_argument, NULL, 'q'},
+        {"lock", required_argument, NULL, 'l'},
+        {"io", required_argument, NULL, 'u'},
+        {"format", required_argument, NULL, 'f'},
+        {"to-text", required_argument, NULL, 'T'},
+        {"file-output", required_argument, NULL, 'O'},
+        {"words", no_argument, NULL, 'w'},
+        {"delimiters", required_argument, NULL, 'W'},
+        {"help", no_argument, NULL, 'h'},
+        {NULL, 0, NULL, 0}
+    };
+
+    struct HW9Options hw9Options = HW9Options_default();
+    StringList const inFilePaths = StringList_create();
+    char const *outFilePathOption = NULL;
+    char const *columnarFilePath = NULL;
+    bool splitWords = false;
+    char const *extraWordDelimiters = "";
+
+    while (true) {
+        int const option = getopt_long(argc, argv, "i:o:t:pmnP:s:S:b:c:q:l:u:f:T:O:wW:h", longOptions, NULL);
+        if (option == -1) {
+            break;
+        }
+
+        bool valid = true;
+        switch (option) {
+            case 'i':
+                StringList_add(inFilePaths, optarg);
+                break;
+            case 'o':
+                outFilePathOption = optarg;
+                break;
+            case 't':
+                valid = parseThreadCount(optarg, &hw9Options.threadCount);
+                break;
+            case 'p':
+                hw9Options.pinThreads = true;
+                break;
+            case 'm':
+                hw9Options.mappedInput = true;
+                break;
+            case 'n':
+                hw9Options.pacing.kind = PacingKind_None;
+                break;
+            case 'P':
+                valid = PacingPolicy_parse(optarg, &hw9Options.pacing);
+                break;
+            case 's': {
+                size_t seed;
+                valid = parseSize(optarg, &seed) && seed <= UINT_MAX;
+                if (valid) {
+                    hw9Options.pacing.seed = (unsigned int)seed;
+                }
+                break;
+            }
+            case 'S':
+                hw9Options.statsFilePath = optarg;
+                break;
+            case 'b':
+                valid = parseSize(optarg, &hw9Options.batchSize);
+                break;
+            case 'c':
+                valid = parseSize(optarg, &hw9Options.chunkSize);
+                break;
+            case 'q':
+                valid = parseSize(optarg, &hw9Options.queueCapacity) && hw9Options.queueCapacity > 0;
+                break;
+            case 'l':
+                hw9Options.lockKind = HW9LockKind_parse(optarg);
+                break;
+            case 'u':
+                hw9Options.ioBackend = HW9IoBackend_parse(optarg);
+                break;
+            case 'f':
+                hw9Options.outputFormat = HW9OutputFormat_parse(optarg);
+                break;
+            case 'T':
+                columnarFilePath = optarg;
+                break;
+            case 'O':
+                hw9Options.fileOutput = HW9FileOutput_parse(optarg);
+                break;
+            case 'w':
+                splitWords = true;
+                break;
+            case 'W':
+                splitWords = true;
+                extraWordDelimiters = optarg;
+                break;
+            case 'h':
+                printUsage(stdout, argv[0]);
+                return EXIT_SUCCESS;
+            default:
+                printUsage(stderr, argv[0]);
+                return EXIT_FAILURE;
+        }
+
+        if (!valid) {
+            fprintf(stderr, "%s: invalid value \"%s\" for option -%c\n", argv[0], optarg, option);
+            printUsage(stderr, argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (columnarFilePath != NULL) {
+        if (argc - optind != 0) {
+            printUsage(stderr, argv[0]);
+            return EXIT_FAILURE;
+        }
+
+        FILE * const columnarFile = safeFopen(columnarFilePath, "rb", "main");
+        FILE * const textFile = outFilePathOption != NULL ? safeFopen(outFilePathOption, "w", "main") : stdout;
+        ColumnarOutput_writeText(columnarFile, textFile, "main");
+        fclose(columnarFile);
+        if (textFile != stdout) {
+            fclose(textFile);
+        }
+        return EXIT_SUCCESS;
+    }
+
+    if (argc - optind != 1) {
+        printUsage(stderr, argv[0]);
+        return EXIT_FAILURE;
+    }
+    if (StringList_empty(inFilePaths)) {
+        static char defaultInFilePath[] = "hw9.data";
+        StringList_add(inFilePaths, defaultInFilePath);
+    }
+
+    char *wordDelimiters = NULL;
+    if (splitWords) {
+        wordDelimiters = formatString(" \t\r\n%s", extraWordDelimiters);
+        hw9Options.wordDelimiters = wordDelimiters;
+    }
+
+    // Files mode takes whole input files (or directories of them) from a shared queue instead of words
+    if (strcmp(argv[optind], "files") == 0) {
+        char * const outFilePath = formatString("%s", outFilePathOption != NULL ? outFilePathOption : "hw9.files");
+        hw9Files(
+            (char const * const *)StringList_items(inFilePaths),
+            StringList_count(inFilePaths),
+            outFilePath,
+            &hw9Options
+        );
+        free(outFilePath);
+        free(wordDelimiters);
+        StringList_destroy(inFilePaths);
+        return EXIT_SUCCESS;
+    }
+
+    hw9Options.mode = HW9Mode_parse(argv[optind]);
+    if (StringList_count(inFilePaths) != 1) {
+        fprintf(stderr, "%s: only files mode accepts more than one input\n", argv[0]);
         return EXIT_FAILURE;
     }
-    enum HW9Mode const hw9Mode = HW9Mode_parse(argv[1]);
 
-    static char const * const inFilePath = "hw9.data";
-    char const * const outFilePath = hw9Mode == HW9Mode_Mutex ? "hw9.mutex" : "hw9.nomutex";
+    char * const outFilePath = outFilePathOption != NULL
+        ? formatString("%s", outFilePathOption)
+        : formatString("hw9.%s", HW9Mode_name(hw9Options.mode));
 
-    hw9(inFilePath, outFilePath, hw9Mode, 10);
+    hw9(StringList_get(inFilePaths, 0), outFilePath, &hw9Options);
+    free(outFilePath);
+    free(wordDelimiters);
+    StringList_destroy(inFilePaths);
     return EXIT_SUCCESS;
 }
+
+/**
+ * Print the program's usage.
+ *
+ * @param stream The stream to print to.
+ * @param programName The name the program was invoked as.
+ */
+static void printUsage(FILE * const stream, char const * const programName) {
+    fprintf(
+        stream,
+        "Usage: %s [options] mutex|nomutex|ordered|batched|lockfree|sharded|stealing|pipeline|files\n"
+        "       %s [-o PATH] --to-text COLUMNAR_PATH\n"
+        "\n"
+        "Options:\n"
+        "  -i, --input PATH          Read words from PATH, or - for standard input (default: hw9.data). Pipes and\n"
+        "                              standard input are streamed through a fixed-size window, except in the\n"
+        "                              lockfree, sharded, and stealing modes, which read them in full. Files mode\n"
+        "                              takes -i once per input file or directory; each thread processes whole files\n"
+        "  -o, --output PATH         Write lines to PATH (default: hw9.<mode>)\n"
+        "  -t, --threads N|auto      Launch N threads, or one per available CPU (default: 10)\n"
+        "  -p, --pin                 Pin each thread to its own CPU\n"
+        "  -m, --mapped              Read the input through a memory mapping\n"
+        "  -n, --no-pacing           Do not sleep after each word (same as --pacing none)\n"
+        "  -P, --pacing POLICY       How to sleep after each word (default: uniform:1000000000):\n"
+        "                              none, fixed:NS, uniform:MAX_NS, exponential:MEAN_NS,\n"
+        "                              pareto:SCALE_NS:SHAPE, or rate:WORDS_PER_SECOND[:BURST] shared by all threads\n"
+        "  -s, --seed N              Seed for the random pacing policies, 0 for the current time (default: 0)\n"
+        "  -S, --stats PATH          Write a JSON report of per-thread counters to PATH\n"
+        "  -b, --batch-size N        Batched mode: words per lock acquisition, 0 to adapt (default: 0)\n"
+        "  -c, --chunk-size N        Stealing mode: words per chunk, 0 for automatic (default: 0)\n"
+        "  -q, --queue-capacity N    Pipeline mode: items per queue (default: 256)\n"
+        "  -l, --lock KIND           Mutex, ordered, batched modes: the lock serializing claims (default: pthread):\n"
+        "                              pthread, adaptive (spin with backoff, then park on a futex),\n"
+        "                              ticket (FIFO ticket spin lock), or mcs (FIFO queue lock)\n"
+        "  -u, --io BACKEND          How to read the input and write the output (default: stdio):\n"
+        "                              stdio, uring (batched io_uring reads and writes, falling back to stdio\n"
+        "                              without kernel support), or async (output double-buffered in memory and\n"
+        "                              written by a background thread, then fsynced)\n"
+        "  -f, --format FORMAT       The output file layout (default: text): text (word<tab>thread lines), or\n"
+        "                              columnar (a word dictionary, fixed-width word IDs, and run-length-encoded\n"
+        "                              thread numbers)\n"
+        "  -T, --to-text PATH        Convert the columnar output at PATH to text lines, written to the -o PATH or\n"
+        "                              standard output, then exit\n"
+        "  -O, --file-output POLICY  Files mode: where each input file's lines go (default: concat): concat (one\n"
+        "                              output, in input file order), or per-file (output PATH.1, PATH.2, ...)\n"
+        "  -w, --words               Split the input into words separated by spaces, tabs, and line endings (CR, LF),\n"
+        "                              rather than reading one word per line. Not supported in nomutex mode\n"
+        "  -W, --delimiters CHARS    Like -w, but also separate words on each of the characters in CHARS\n"
+        "  -h, --help                Print this message\n",
+        programName,
+        programName
+    );
+}
+
+/**
+ * Parse a non-negative decimal integer.
+ *
+ * @param text The text to parse.
+ * @param valueOutPtr Where to store the parsed value.
+ *
+ * @returns Whether the whole text was a valid size.
+ */
+static bool parseSize(char const * const text, size_t * const valueOutPtr) {
+    if (text[0] < '0' || text[0] > '9') {
+        return false;
+    }
+
+    char *end;
+    errno = 0;
+    unsigned long long const value = strtoull(text, &end, 10);
+    if (errno != 0 || *end != '\0' || value > SIZE_MAX) {
+        return false;
+    }
+
+    *valueOutPtr = (size_t)value;
+    return true;
+}
+
+/**
+ * Parse a thread count: a positive decimal integer, or "auto" for the number of CPUs available to the process.
+ *
+ * @param text The text to parse.
+ * @param threadCountOutPtr Where to store the parsed thread count.
+ *
+ * @returns Whether the text was a valid thread count.
+ */
+static bool parseThreadCount(char const * const text, unsigned int * const threadCountOutPtr) {
+    if (strcmp(text, "auto") == 0) {
+        *threadCountOutPtr = availableCpuCount();
+        return true;
+    }
+
+    size_t threadCount;
+    if (!parseSize(text, &threadCount) || threadCount == 0 || threadCount > UINT_MAX) {
+        return false;
+    }
+
+    *threadCountOutPtr = (unsigned int)threadCount;
+    return true;
+}
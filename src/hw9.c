@@ -1,120 +1,748 @@
 #include "../include/hw9.h"
 
+#include "../include/util/ReorderBuffer.h"
+#include "../include/util/MappedFile.h"
+#include "../include/util/LineTokenizer.h"
+#include "../include/util/StreamTokenizer.h"
+#include "../include/util/delimiterScan.h"
+#include "../include/util/Shard.h"
+#include "../include/util/workStealing.h"
+#include "../include/util/BoundedQueue.h"
+#include "../include/util/Pacer.h"
+#include "../include/util/ThreadStats.h"
+#include "../include/util/StringBuilder.h"
+#include "../include/util/Arena.h"
+#include "../include/util/lists.h"
 #include "../include/util/memory.h"
 #include "../include/util/thread.h"
+#include "../include/util/string.h"
 #include "../include/util/file.h"
-#include "../include/util/random.h"
+#include "../include/util/ioUring.h"
+#include "../include/util/AsyncWriter.h"
+#include "../include/util/ColumnarOutput.h"
+#include "../include/util/time.h"
 #include "../include/util/guard.h"
 #include "../include/util/error.h"
 
 #include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <stdalign.h>
+#include <stdatomic.h>
 #include <string.h>
+#include <errno.h>
 #include <stdio.h>
 #include <time.h>
 #include <pthread.h>
 #include <assert.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <dirent.h>
+
+/**
+ * The shared input that words are claimed from: either a stdio stream read with readFileLine, a tokenizer over the
+ * memory-mapped file (or the file read in full) which yields spans without copying, or, for standard input and other
+ * inputs that are not regular files, a tokenizer reading through a fixed-size window. Claims from either tokenizer must
+ * be serialized by the caller.
+ */
+struct WordInput {
+    FILE *file;
+    MappedFile mappedFile;
+    char *readChars;
+    LineTokenizer tokenizer;
+    int streamFileDescriptor;
+    StreamTokenizer streamTokenizer;
+};
+static void openWordInput(struct WordInput *inputOutPtr, char const *filePath, struct HW9Options const *options);
+static LineTokenizer createInputTokenizer(
+    char const *chars,
+    size_t length,
+    struct DelimiterSet const *wordDelimitersPtr
+);
+static int openStreamInput(char const *filePath);
+static void closeWordInput(struct WordInput *inputPtr);
+
+/**
+ * A word claimed from a WordInput. ownedChars is the copy that must be freed after use, or null if the span points
+ * directly into the mapped input or into the claiming thread's word arena.
+ */
+struct ClaimedWord {
+    struct StringSpan span;
+    char *ownedChars;
+};
+static bool claimWord(struct WordInput *inputPtr, Arena wordArena, struct ClaimedWord *wordOutPtr);
+static void releaseWord(struct ClaimedWord *wordPtr);
+
+/**
+ * The lock that serializes claims in the Mutex, Ordered, and Batched modes. Only the member matching kind is
+ * initialized.
+ */
+struct ClaimLock {
+    enum HW9LockKind kind;
+    pthread_mutex_t mutex;
+    struct AdaptiveMutex adaptiveMutex;
+    struct TicketLock ticketLock;
+    struct McsLock mcsLock;
+};
+static void initClaimLock(struct ClaimLock *lockOutPtr, enum HW9LockKind kind, char const *callerDescription);
+static void acquireClaimLock(struct ClaimLock *lockPtr, struct ThreadStats *statsPtr, char const *callerDescription);
+static void releaseClaimLock(struct ClaimLock *lockPtr, struct ThreadStats *statsPtr, char const *callerDescription);
+static void destroyClaimLock(struct ClaimLock *lockPtr, char const *callerDescription);
+
+/** The calling thread's node in an MCS claim lock queue. A thread holds at most one claim lock at a time. */
+static _Thread_local struct McsLockNode claimLockMcsNode;
 
 struct ProcessWordsWithMutexThreadStartArg {
-    unsigned int threadNumber;
-    FILE *inFile;
+    alignas(CACHE_LINE_SIZE) unsigned int threadNumber;
+    struct WordInput *inputPtr;
     FILE *outFile;
-    pthread_mutex_t *fileMutexPtr;
+    struct ClaimLock *claimLockPtr;
+    Pacer pacer;
+    struct ThreadStats stats;
 };
 static void *processWordsWithMutexThreadStart(void *argAsVoidPtr);
 
 struct ProcessWordsWithoutMutexThreadStartArg {
-    unsigned int threadNumber;
-    FILE *inFile;
+    alignas(CACHE_LINE_SIZE) unsigned int threadNumber;
+    struct WordInput *inputPtr;
     FILE *outFile;
+    Pacer pacer;
+    struct ThreadStats stats;
 };
 static void *processWordsWithoutMutexThreadStart(void *argAsVoidPtr);
 
+struct ProcessWordsOrderedThreadStartArg {
+    alignas(CACHE_LINE_SIZE) unsigned int threadNumber;
+    struct WordInput *inputPtr;
+    struct ClaimLock *claimLockPtr;
+    size_t *nextSequenceNumberPtr;
+    ReorderBuffer reorderBuffer;
+    Pacer pacer;
+    struct ThreadStats stats;
+};
+static void *processWordsOrderedThreadStart(void *argAsVoidPtr);
+
+struct ProcessWordsBatchedThreadStartArg {
+    alignas(CACHE_LINE_SIZE) unsigned int threadNumber;
+    struct WordInput *inputPtr;
+    FILE *outFile;
+    struct ClaimLock *claimLockPtr;
+    size_t batchSize;
+    Pacer pacer;
+    struct ThreadStats stats;
+};
+static void *processWordsBatchedThreadStart(void *argAsVoidPtr);
+static size_t adaptBatchSize(size_t batchSize, uint64_t lockWaitNanoseconds, uint64_t lockHoldNanoseconds);
+
+struct ProcessWordsLockFreeThreadStartArg {
+    alignas(CACHE_LINE_SIZE) unsigned int threadNumber;
+    struct StringSpan const *words;
+    size_t wordCount;
+    atomic_size_t *nextWordIndexPtr;
+    FILE *outFile;
+    Pacer pacer;
+    struct ThreadStats stats;
+};
+static void *processWordsLockFreeThreadStart(void *argAsVoidPtr);
+static struct StringSpan *indexWords(LineTokenizer tokenizer, size_t *wordCountOutPtr);
+
+struct ProcessWordsShardedThreadStartArg {
+    alignas(CACHE_LINE_SIZE) unsigned int threadNumber;
+    struct StringSpan const *words;
+    size_t wordCount;
+    atomic_size_t *nextWordIndexPtr;
+    Shard shard;
+    Pacer pacer;
+    struct ThreadStats stats;
+};
+static void *processWordsShardedThreadStart(void *argAsVoidPtr);
+
+struct MergeShardsThreadStartArg {
+    ConstShard const *shards;
+    size_t shardCount;
+    size_t sequenceStart;
+    size_t sequenceEnd;
+    char *partFilePath;
+};
+static void mergeShards(
+    ConstShard const *shards,
+    size_t shardCount,
+    size_t sequenceCount,
+    unsigned int maxMergeThreadCount,
+    ThreadPool mergePool,
+    FILE *outFile,
+    char const *outFilePath
+);
+static void *mergeShardsThreadStart(void *argAsVoidPtr);
+
+struct ProcessWordsWorkStealingWorker {
+    alignas(CACHE_LINE_SIZE) struct ThreadStats stats;
+};
+struct ProcessWordsWorkStealingState {
+    struct StringSpan const *words;
+    FILE *outFile;
+    Pacer pacer;
+    struct ProcessWordsWorkStealingWorker *workers;
+};
+static void processWordRangeWorkStealing(
+    void *stateAsVoidPtr,
+    unsigned int workerIndex,
+    size_t wordStart,
+    size_t wordEnd
+);
+static size_t autoChunkSize(size_t wordCount, unsigned int threadCount);
+
+struct ReadWordsPipelineThreadStartArg {
+    struct WordInput *inputPtr;
+    BoundedQueue wordQueue;
+};
+static void *readWordsPipelineThreadStart(void *argAsVoidPtr);
+
+struct ProcessWordsPipelineThreadStartArg {
+    alignas(CACHE_LINE_SIZE) unsigned int threadNumber;
+    BoundedQueue wordQueue;
+    BoundedQueue lineQueue;
+    atomic_uint *runningWorkerCountPtr;
+    Pacer pacer;
+    struct ThreadStats stats;
+};
+static void *processWordsPipelineThreadStart(void *argAsVoidPtr);
+
+struct WriteLinesPipelineThreadStartArg {
+    BoundedQueue lineQueue;
+    FILE *outFile;
+};
+static void *writeLinesPipelineThreadStart(void *argAsVoidPtr);
+
+static void writeStatsReport(
+    char const *statsFilePath,
+    char const *modeName,
+    struct HW9Options const *options,
+    uint64_t wallNanoseconds,
+    struct ThreadStats const * const *threadStatsPtrs
+);
+
+struct ProcessFilesThreadStartArg {
+    alignas(CACHE_LINE_SIZE) unsigned int threadNumber;
+    ConstStringList filePaths;
+    atomic_size_t *nextFileIndexPtr;
+    /** FileOutput Concatenated: orders each file's block of lines by file index. Null for FileOutput PerFile. */
+    ReorderBuffer reorderBuffer;
+    char const *outFilePath;
+    struct HW9Options const *options;
+    Pacer pacer;
+    struct ThreadStats stats;
+};
+static void *processFilesThreadStart(void *argAsVoidPtr);
+static StringList expandInputPaths(char const * const *paths, size_t pathCount);
+static int compareStrings(void const *aAsVoidPtr, void const *bAsVoidPtr);
+
+static FILE *openOutputFile(char const *filePath, struct HW9Options const *options, char const *callerDescription);
+static bool modeRequiresMappedInput(enum HW9Mode mode);
+/**
+ * Launches the threads of one run, either as new threads or as tasks on the caller's thread pool, and waits for them.
+ */
+struct ThreadLauncher {
+    ThreadPool pool;
+    /** The per-thread attributes, or null to use the default attributes. Not used with a pool. */
+    pthread_attr_t *threadAttributes;
+    size_t maxThreadCount;
+    pthread_t *threadIds;
+    size_t launchedThreadCount;
+};
+static void initThreadLauncher(
+    struct ThreadLauncher *launcherOutPtr,
+    size_t maxThreadCount,
+    struct HW9Options const *options,
+    char const *callerDescription
+);
+static void launchThread(
+    struct ThreadLauncher *launcherPtr,
+    PthreadCreateStartRoutine startRoutine,
+    void *startRoutineArg,
+    char const *callerDescription
+);
+static void joinLaunchedThreads(struct ThreadLauncher *launcherPtr, char const *callerDescription);
+static void destroyThreadLauncher(struct ThreadLauncher *launcherPtr, char const *callerDescription);
+static pthread_attr_t const *threadAttributesAt(pthread_attr_t const *threadAttributes, size_t threadIndex);
+
+
+static size_t const maxAdaptiveBatchSize = 1024;
+static size_t const minWordsPerMergeThread = 64 * 1024;
+static size_t const autoChunksPerThread = 8;
+static size_t const asyncOutputBufferCapacity = 1024 * 1024;
+static size_t const streamInputWindowCapacity = 64 * 1024;
+static size_t const wordArenaBlockCapacity = 64 * 1024;
+/** Ordered mode and hw9Files: how many completed lines or file blocks per thread may wait for an earlier one. */
+static size_t const reorderLinesPerThread = 4;
+
+/**
+ * Get the default HW9 options. The run uses 10 threads in Mutex mode. Claims are serialized with a pthread mutex. The
+ * input is read through stdio rather than memory-mapped, and the output is written through stdio. Batched mode adapts
+ * its batch size, and work stealing picks its chunk size automatically. Pipeline queues hold 256 items. Threads are not
+ * pinned to CPUs. Each thread sleeps for a uniformly random duration of up to 1 second after every word. The output is
+ * text, and hw9Files concatenates every input file's lines into the one output file. Each line of the input is one
+ * word. Threads are created and joined per call rather than taken from a pool. No stats report is written.
+ *
+ * @returns The default options.
+ */
+struct HW9Options HW9Options_default(void) {
+    return (struct HW9Options){
+        .mode = HW9Mode_Mutex,
+        .threadCount = 10,
+        .batchSize = 0,
+        .mappedInput = false,
+        .chunkSize = 0,
+        .queueCapacity = 256,
+        .pinThreads = false,
+        .pacing = {
+            .kind = PacingKind_Uniform,
+            .delayNanoseconds = 1000 * 1000 * 1000,
+            .paretoShape = 1,
+            .ratePerSecond = 1,
+            .burst = 1,
+            .seed = 0
+        },
+        .statsFilePath = NULL,
+        .lockKind = HW9LockKind_Pthread,
+        .ioBackend = HW9IoBackend_Stdio,
+        .outputFormat = HW9OutputFormat_Text,
+        .fileOutput = HW9FileOutput_Concatenated,
+        .wordDelimiters = NULL,
+        .threadPool = NULL
+    };
+}
+
 /**
  * Run CSCI 451 HW9. This launches threads which each read words from the input file and write them to the output file.
  *
  * @param inFilePath The input file.
  * @param outFilePath The output file.
- * @param mode Whether to run in Mutex or NoMutex mode.
- * @param threadCount The number of threads to launch.
+ * @param options The run options (mode, thread count, etc.).
  */
 void hw9(
     char const * const inFilePath,
     char const * const outFilePath,
-    enum HW9Mode const mode,
-    unsigned int const threadCount
+    struct HW9Options const * const options
 ) {
     guardNotNull(inFilePath, "inFilePath", "hw9");
     guardNotNull(outFilePath, "outFilePath", "hw9");
+    guardNotNull(options, "options", "hw9");
+
+    enum HW9Mode const mode = options->mode;
+    unsigned int const threadCount = options->threadCount;
     guard(threadCount > 0, "hw9: threadCount must be positive");
+    guard(
+        !(options->mappedInput && mode == HW9Mode_NoMutex),
+        "hw9: mappedInput requires a mode that serializes claims (use LockFree mode instead of NoMutex)"
+    );
+    guard(
+        !(options->wordDelimiters != NULL && mode == HW9Mode_NoMutex),
+        "hw9: wordDelimiters requires a mode that serializes claims (use LockFree mode instead of NoMutex)"
+    );
+
+    calibrateCycleCounter();
+    uint64_t const startNanoseconds = monotonicNanoseconds();
+
+    struct WordInput input;
+    openWordInput(&input, inFilePath, options);
+    FILE * const outFile = openOutputFile(outFilePath, options, "hw9");
+
+    struct ClaimLock claimLock;
+    size_t nextSequenceNumber = 0;
+    ReorderBuffer reorderBuffer = NULL;
+    struct StringSpan *words = NULL;
+    size_t wordCount = 0;
+    Shard *shards = NULL;
+    struct ProcessWordsWorkStealingWorker *workStealingWorkers = NULL;
+    atomic_size_t nextWordIndex;
+    atomic_init(&nextWordIndex, 0);
+    BoundedQueue wordQueue = NULL;
+    BoundedQueue lineQueue = NULL;
+    atomic_uint runningWorkerCount;
+    atomic_init(&runningWorkerCount, threadCount);
+    struct ReadWordsPipelineThreadStartArg readerThreadStartArg;
+    struct WriteLinesPipelineThreadStartArg writerThreadStartArg;
+
+    // Pipeline mode runs a reader and a writer thread alongside the workers
+    size_t const maxLaunchedThreadCount = (size_t)threadCount + (mode == HW9Mode_Pipeline ? 2 : 0);
+
+    struct ThreadLauncher launcher;
+    initThreadLauncher(&launcher, maxLaunchedThreadCount, options, "hw9");
 
-    FILE * const inFile = safeFopen(inFilePath, "r", "hw9");
-    FILE * const outFile = safeFopen(outFilePath, "w", "hw9");
+    Pacer const pacer = Pacer_create(&options->pacing, threadCount);
 
-    pthread_mutex_t fileMutex;
+    // Each worker's stats live in its start arg (or work-stealing worker); these point at them for the report
+    struct ThreadStats ** const threadStatsPtrs = safeMalloc(sizeof *threadStatsPtrs * threadCount, "hw9");
 
     void *threadStartArgs;
-    pthread_t * const threadIds = safeMalloc(sizeof *threadIds * threadCount, "hw9");
-    if (mode == HW9Mode_Mutex) {
-        safeMutexInit(&fileMutex, NULL, "hw9");
+    switch (mode) {
+        case HW9Mode_Mutex: {
+            initClaimLock(&claimLock, options->lockKind, "hw9");
 
-        struct ProcessWordsWithMutexThreadStartArg * const mutexThreadStartArgs = (
-            safeMalloc(sizeof *mutexThreadStartArgs * threadCount, "hw9")
-        );
-        threadStartArgs = mutexThreadStartArgs;
+            struct ProcessWordsWithMutexThreadStartArg * const mutexThreadStartArgs = (
+                safeAlignedAlloc(CACHE_LINE_SIZE, sizeof *mutexThreadStartArgs * threadCount, "hw9")
+            );
+            threadStartArgs = mutexThreadStartArgs;
 
-        for (size_t i = 0; i < threadCount; i += 1) {
-            struct ProcessWordsWithMutexThreadStartArg * const threadStartArgPtr = &mutexThreadStartArgs[i];
+            for (size_t i = 0; i < threadCount; i += 1) {
+                struct ProcessWordsWithMutexThreadStartArg * const threadStartArgPtr = &mutexThreadStartArgs[i];
 
-            threadStartArgPtr->threadNumber = (unsigned int)i + 1;
-            threadStartArgPtr->inFile = inFile;
-            threadStartArgPtr->outFile = outFile;
-            threadStartArgPtr->fileMutexPtr = &fileMutex;
+                threadStartArgPtr->threadNumber = (unsigned int)i + 1;
+                threadStartArgPtr->pacer = pacer;
+                ThreadStats_init(&threadStartArgPtr->stats);
+                threadStatsPtrs[i] = &threadStartArgPtr->stats;
+                threadStartArgPtr->inputPtr = &input;
+                threadStartArgPtr->outFile = outFile;
+                threadStartArgPtr->claimLockPtr = &claimLock;
 
-            threadIds[i] = safePthreadCreate(
-                NULL,
-                processWordsWithMutexThreadStart,
-                threadStartArgPtr,
-                "hw9"
+                launchThread(&launcher, processWordsWithMutexThreadStart, threadStartArgPtr, "hw9");
+            }
+            break;
+        }
+        case HW9Mode_NoMutex: {
+            struct ProcessWordsWithoutMutexThreadStartArg * const noMutexThreadStartArgs = (
+                safeAlignedAlloc(CACHE_LINE_SIZE, sizeof *noMutexThreadStartArgs * threadCount, "hw9")
+            );
+            threadStartArgs = noMutexThreadStartArgs;
+
+            for (size_t i = 0; i < threadCount; i += 1) {
+                struct ProcessWordsWithoutMutexThreadStartArg * const threadStartArgPtr = &noMutexThreadStartArgs[i];
+
+                threadStartArgPtr->threadNumber = (unsigned int)i + 1;
+                threadStartArgPtr->pacer = pacer;
+                ThreadStats_init(&threadStartArgPtr->stats);
+                threadStatsPtrs[i] = &threadStartArgPtr->stats;
+                threadStartArgPtr->inputPtr = &input;
+                threadStartArgPtr->outFile = outFile;
+
+                launchThread(&launcher, processWordsWithoutMutexThreadStart, threadStartArgPtr, "hw9");
+            }
+            break;
+        }
+        case HW9Mode_Ordered: {
+            initClaimLock(&claimLock, options->lockKind, "hw9");
+            reorderBuffer = ReorderBuffer_create(outFile, threadCount * reorderLinesPerThread);
+
+            struct ProcessWordsOrderedThreadStartArg * const orderedThreadStartArgs = (
+                safeAlignedAlloc(CACHE_LINE_SIZE, sizeof *orderedThreadStartArgs * threadCount, "hw9")
             );
+            threadStartArgs = orderedThreadStartArgs;
+
+            for (size_t i = 0; i < threadCount; i += 1) {
+                struct ProcessWordsOrderedThreadStartArg * const threadStartArgPtr = &orderedThreadStartArgs[i];
+
+                threadStartArgPtr->threadNumber = (unsigned int)i + 1;
+                threadStartArgPtr->pacer = pacer;
+                ThreadStats_init(&threadStartArgPtr->stats);
+                threadStatsPtrs[i] = &threadStartArgPtr->stats;
+                threadStartArgPtr->inputPtr = &input;
+                threadStartArgPtr->claimLockPtr = &claimLock;
+                threadStartArgPtr->nextSequenceNumberPtr = &nextSequenceNumber;
+                threadStartArgPtr->reorderBuffer = reorderBuffer;
+
+                launchThread(&launcher, processWordsOrderedThreadStart, threadStartArgPtr, "hw9");
+            }
+            break;
         }
-    } else { // mode == HW9Mode_NoMutex
-        struct ProcessWordsWithoutMutexThreadStartArg * const noMutexThreadStartArgs = (
-            safeMalloc(sizeof *noMutexThreadStartArgs * threadCount, "hw9")
-        );
-        threadStartArgs = noMutexThreadStartArgs;
+        case HW9Mode_Batched: {
+            initClaimLock(&claimLock, options->lockKind, "hw9");
 
-        for (size_t i = 0; i < threadCount; i += 1) {
-            struct ProcessWordsWithoutMutexThreadStartArg * const threadStartArgPtr = &noMutexThreadStartArgs[i];
+            struct ProcessWordsBatchedThreadStartArg * const batchedThreadStartArgs = (
+                safeAlignedAlloc(CACHE_LINE_SIZE, sizeof *batchedThreadStartArgs * threadCount, "hw9")
+            );
+            threadStartArgs = batchedThreadStartArgs;
+
+            for (size_t i = 0; i < threadCount; i += 1) {
+                struct ProcessWordsBatchedThreadStartArg * const threadStartArgPtr = &batchedThreadStartArgs[i];
+
+                threadStartArgPtr->threadNumber = (unsigned int)i + 1;
+                threadStartArgPtr->pacer = pacer;
+                ThreadStats_init(&threadStartArgPtr->stats);
+                threadStatsPtrs[i] = &threadStartArgPtr->stats;
+                threadStartArgPtr->inputPtr = &input;
+                threadStartArgPtr->outFile = outFile;
+                threadStartArgPtr->claimLockPtr = &claimLock;
+                threadStartArgPtr->batchSize = options->batchSize;
+
+                launchThread(&launcher, processWordsBatchedThreadStart, threadStartArgPtr, "hw9");
+            }
+            break;
+        }
+        case HW9Mode_LockFree: {
+            words = indexWords(input.tokenizer, &wordCount);
+
+            struct ProcessWordsLockFreeThreadStartArg * const lockFreeThreadStartArgs = (
+                safeAlignedAlloc(CACHE_LINE_SIZE, sizeof *lockFreeThreadStartArgs * threadCount, "hw9")
+            );
+            threadStartArgs = lockFreeThreadStartArgs;
+
+            for (size_t i = 0; i < threadCount; i += 1) {
+                struct ProcessWordsLockFreeThreadStartArg * const threadStartArgPtr = &lockFreeThreadStartArgs[i];
+
+                threadStartArgPtr->threadNumber = (unsigned int)i + 1;
+                threadStartArgPtr->pacer = pacer;
+                ThreadStats_init(&threadStartArgPtr->stats);
+                threadStatsPtrs[i] = &threadStartArgPtr->stats;
+                threadStartArgPtr->words = words;
+                threadStartArgPtr->wordCount = wordCount;
+                threadStartArgPtr->nextWordIndexPtr = &nextWordIndex;
+                threadStartArgPtr->outFile = outFile;
+
+                launchThread(&launcher, processWordsLockFreeThreadStart, threadStartArgPtr, "hw9");
+            }
+            break;
+        }
+        case HW9Mode_Sharded: {
+            words = indexWords(input.tokenizer, &wordCount);
+            shards = safeMalloc(sizeof *shards * threadCount, "hw9");
 
-            threadStartArgPtr->threadNumber = (unsigned int)i + 1;
-            threadStartArgPtr->inFile = inFile;
-            threadStartArgPtr->outFile = outFile;
+            struct ProcessWordsShardedThreadStartArg * const shardedThreadStartArgs = (
+                safeAlignedAlloc(CACHE_LINE_SIZE, sizeof *shardedThreadStartArgs * threadCount, "hw9")
+            );
+            threadStartArgs = shardedThreadStartArgs;
+
+            for (size_t i = 0; i < threadCount; i += 1) {
+                struct ProcessWordsShardedThreadStartArg * const threadStartArgPtr = &shardedThreadStartArgs[i];
+
+                char * const shardFilePath = formatString("%s.shard%zu", outFilePath, i + 1);
+                shards[i] = Shard_create(shardFilePath);
+                free(shardFilePath);
+
+                threadStartArgPtr->threadNumber = (unsigned int)i + 1;
+                threadStartArgPtr->pacer = pacer;
+                ThreadStats_init(&threadStartArgPtr->stats);
+                threadStatsPtrs[i] = &threadStartArgPtr->stats;
+                threadStartArgPtr->words = words;
+                threadStartArgPtr->wordCount = wordCount;
+                threadStartArgPtr->nextWordIndexPtr = &nextWordIndex;
+                threadStartArgPtr->shard = shards[i];
 
-            threadIds[i] = safePthreadCreate(
-                NULL,
-                processWordsWithoutMutexThreadStart,
-                threadStartArgPtr,
+                launchThread(&launcher, processWordsShardedThreadStart, threadStartArgPtr, "hw9");
+            }
+            break;
+        }
+        case HW9Mode_WorkStealing: {
+            words = indexWords(input.tokenizer, &wordCount);
+
+            workStealingWorkers = safeAlignedAlloc(
+                CACHE_LINE_SIZE,
+                sizeof *workStealingWorkers * threadCount,
                 "hw9"
             );
+            for (size_t i = 0; i < threadCount; i += 1) {
+                ThreadStats_init(&workStealingWorkers[i].stats);
+                threadStatsPtrs[i] = &workStealingWorkers[i].stats;
+            }
+
+            struct ProcessWordsWorkStealingState workStealingState = {
+                .words = words,
+                .outFile = outFile,
+                .pacer = pacer,
+                .workers = workStealingWorkers
+            };
+            size_t const chunkSize = options->chunkSize == 0
+                ? autoChunkSize(wordCount, threadCount)
+                : options->chunkSize;
+
+            // The work-stealing workers are launched and joined by runWorkStealing itself
+            threadStartArgs = NULL;
+            runWorkStealing(
+                wordCount,
+                chunkSize,
+                threadCount,
+                launcher.threadAttributes,
+                launcher.pool,
+                &workStealingState,
+                processWordRangeWorkStealing
+            );
+            break;
+        }
+        case HW9Mode_Pipeline: {
+            guard(options->queueCapacity > 0, "hw9: queueCapacity must be positive");
+            wordQueue = BoundedQueue_create(options->queueCapacity);
+            lineQueue = BoundedQueue_create(options->queueCapacity);
+
+            struct ProcessWordsPipelineThreadStartArg * const pipelineThreadStartArgs = (
+                safeAlignedAlloc(CACHE_LINE_SIZE, sizeof *pipelineThreadStartArgs * threadCount, "hw9")
+            );
+            threadStartArgs = pipelineThreadStartArgs;
+
+            for (size_t i = 0; i < threadCount; i += 1) {
+                struct ProcessWordsPipelineThreadStartArg * const threadStartArgPtr = &pipelineThreadStartArgs[i];
+
+                threadStartArgPtr->threadNumber = (unsigned int)i + 1;
+                threadStartArgPtr->pacer = pacer;
+                ThreadStats_init(&threadStartArgPtr->stats);
+                threadStatsPtrs[i] = &threadStartArgPtr->stats;
+                threadStartArgPtr->wordQueue = wordQueue;
+                threadStartArgPtr->lineQueue = lineQueue;
+                threadStartArgPtr->runningWorkerCountPtr = &runningWorkerCount;
+
+                launchThread(&launcher, processWordsPipelineThreadStart, threadStartArgPtr, "hw9");
+            }
+
+            readerThreadStartArg.inputPtr = &input;
+            readerThreadStartArg.wordQueue = wordQueue;
+            launchThread(&launcher, readWordsPipelineThreadStart, &readerThreadStartArg, "hw9");
+
+            writerThreadStartArg.lineQueue = lineQueue;
+            writerThreadStartArg.outFile = outFile;
+            launchThread(&launcher, writeLinesPipelineThreadStart, &writerThreadStartArg, "hw9");
+            break;
+        }
+        default: {
+            abortWithErrorFmt("hw9: unknown HW9Mode %d", (int)mode);
+            return;
         }
     }
 
-    for (size_t i = 0; i < threadCount; i += 1) {
-        pthread_t const threadId = threadIds[i];
-        safePthreadJoin(threadId, "hw9");
+    joinLaunchedThreads(&launcher, "hw9");
+    destroyThreadLauncher(&launcher, "hw9");
+    Pacer_destroy(pacer);
+
+    if (shards != NULL) {
+        for (size_t i = 0; i < threadCount; i += 1) {
+            Shard_finish(shards[i]);
+        }
+        mergeShards(
+            (ConstShard const *)shards,
+            threadCount,
+            wordCount,
+            threadCount,
+            options->threadPool,
+            outFile,
+            outFilePath
+        );
+        for (size_t i = 0; i < threadCount; i += 1) {
+            Shard_destroy(shards[i]);
+        }
+        free(shards);
     }
 
+    if (options->statsFilePath != NULL) {
+        uint64_t const wallNanoseconds = monotonicNanoseconds() - startNanoseconds;
+        writeStatsReport(
+            options->statsFilePath,
+            HW9Mode_name(mode),
+            options,
+            wallNanoseconds,
+            (struct ThreadStats const * const *)threadStatsPtrs
+        );
+    }
+    free(threadStatsPtrs);
     free(threadStartArgs);
-    free(threadIds);
+    free(workStealingWorkers);
 
-    if (mode == HW9Mode_Mutex) {
-        safeMutexDestroy(&fileMutex, "hw9");
+    if (reorderBuffer != NULL) {
+        ReorderBuffer_destroy(reorderBuffer);
+    }
+    if (wordQueue != NULL) {
+        BoundedQueue_destroy(wordQueue);
+        BoundedQueue_destroy(lineQueue);
+    }
+    free(words);
+    if (mode == HW9Mode_Mutex || mode == HW9Mode_Ordered || mode == HW9Mode_Batched) {
+        destroyClaimLock(&claimLock, "hw9");
     }
 
-    fclose(inFile);
+    closeWordInput(&input);
     fclose(outFile);
 }
 
+/**
+ * Run CSCI 451 HW9 over many input files at once. Worker threads take whole files from a shared queue, so thread
+ * startup is paid once for all of the files and a thread that finishes a small file moves straight on to the next.
+ * Each file's words are written by the single thread that took the file, in input order.
+ *
+ * @param inFilePaths The input files. A directory stands for the regular files directly inside it, in name order.
+ * @param inFilePathCount The number of input paths.
+ * @param outFilePath The output file with FileOutput Concatenated, or the prefix of each numbered output file with
+ *                    FileOutput PerFile.
+ * @param options The run options. The mode and the options specific to other modes are not used.
+ */
+void hw9Files(
+    char const * const * const inFilePaths,
+    size_t const inFilePathCount,
+    char const * const outFilePath,
+    struct HW9Options const * const options
+) {
+    guardNotNull(inFilePaths, "inFilePaths", "hw9Files");
+    guardNotNull(outFilePath, "outFilePath", "hw9Files");
+    guardNotNull(options, "options", "hw9Files");
+
+    unsigned int const threadCount = options->threadCount;
+    guard(threadCount > 0, "hw9Files: threadCount must be positive");
+
+    calibrateCycleCounter();
+    uint64_t const startNanoseconds = monotonicNanoseconds();
+
+    StringList const filePaths = expandInputPaths(inFilePaths, inFilePathCount);
+
+    FILE *outFile = NULL;
+    ReorderBuffer reorderBuffer = NULL;
+    if (options->fileOutput == HW9FileOutput_Concatenated) {
+        outFile = openOutputFile(outFilePath, options, "hw9Files");
+        reorderBuffer = ReorderBuffer_create(outFile, threadCount * reorderLinesPerThread);
+    }
+
+    struct ThreadLauncher launcher;
+    initThreadLauncher(&launcher, threadCount, options, "hw9Files");
+
+    Pacer const pacer = Pacer_create(&options->pacing, threadCount);
+    atomic_size_t nextFileIndex;
+    atomic_init(&nextFileIndex, 0);
+
+    struct ThreadStats ** const threadStatsPtrs = safeMalloc(sizeof *threadStatsPtrs * threadCount, "hw9Files");
+    struct ProcessFilesThreadStartArg * const threadStartArgs = (
+        safeAlignedAlloc(CACHE_LINE_SIZE, sizeof *threadStartArgs * threadCount, "hw9Files")
+    );
+    for (size_t i = 0; i < threadCount; i += 1) {
+        struct ProcessFilesThreadStartArg * const threadStartArgPtr = &threadStartArgs[i];
+
+        threadStartArgPtr->threadNumber = (unsigned int)i + 1;
+        threadStartArgPtr->filePaths = filePaths;
+        threadStartArgPtr->nextFileIndexPtr = &nextFileIndex;
+        threadStartArgPtr->reorderBuffer = reorderBuffer;
+        threadStartArgPtr->outFilePath = outFilePath;
+        threadStartArgPtr->options = options;
+        threadStartArgPtr->pacer = pacer;
+        ThreadStats_init(&threadStartArgPtr->stats);
+        threadStatsPtrs[i] = &threadStartArgPtr->stats;
+
+        launchThread(&launcher, processFilesThreadStart, threadStartArgPtr, "hw9Files");
+    }
+
+    joinLaunchedThreads(&launcher, "hw9Files");
+    destroyThreadLauncher(&launcher, "hw9Files");
+    Pacer_destroy(pacer);
+
+    if (options->statsFilePath != NULL) {
+        uint64_t const wallNanoseconds = monotonicNanoseconds() - startNanoseconds;
+        writeStatsReport(
+            options->statsFilePath,
+            "files",
+            options,
+            wallNanoseconds,
+            (struct ThreadStats const * const *)threadStatsPtrs
+        );
+    }
+    free(threadStatsPtrs);
+    free(threadStartArgs);
+
+    if (reorderBuffer != NULL) {
+        ReorderBuffer_destroy(reorderBuffer);
+        fclose(outFile);
+    }
+
+    for (size_t i = 0; i < StringList_count(filePaths); i += 1) {
+        free(StringList_get(filePaths, i));
+    }
+    StringList_destroy(filePaths);
+}
+
 enum HW9Mode HW9Mode_parse(char const * const name) {
     guardNotNull(name, "name", "HW9Mode_parse");
 
@@ -124,35 +752,194 @@ enum HW9Mode HW9Mode_parse(char const * const name) {
     if (strcmp(name, "nomutex") == 0) {
         return HW9Mode_NoMutex;
     }
+    if (strcmp(name, "ordered") == 0) {
+        return HW9Mode_Ordered;
+    }
+    if (strcmp(name, "batched") == 0) {
+        return HW9Mode_Batched;
+    }
+    if (strcmp(name, "lockfree") == 0) {
+        return HW9Mode_LockFree;
+    }
+    if (strcmp(name, "sharded") == 0) {
+        return HW9Mode_Sharded;
+    }
+    if (strcmp(name, "stealing") == 0) {
+        return HW9Mode_WorkStealing;
+    }
+    if (strcmp(name, "pipeline") == 0) {
+        return HW9Mode_Pipeline;
+    }
 
     abortWithErrorFmt("HW9Mode_parse: unknown HW9Mode name \"%s\"", name);
     return (enum HW9Mode)-1;
 }
 
+char const *HW9Mode_name(enum HW9Mode const mode) {
+    switch (mode) {
+        case HW9Mode_Mutex: return "mutex";
+        case HW9Mode_NoMutex: return "nomutex";
+        case HW9Mode_Ordered: return "ordered";
+        case HW9Mode_Batched: return "batched";
+        case HW9Mode_LockFree: return "lockfree";
+        case HW9Mode_Sharded: return "sharded";
+        case HW9Mode_WorkStealing: return "stealing";
+        case HW9Mode_Pipeline: return "pipeline";
+        default: {
+            abortWithErrorFmt("HW9Mode_name: unknown HW9Mode %d", (int)mode);
+            return NULL;
+        }
+    }
+}
+
+enum HW9LockKind HW9LockKind_parse(char const * const name) {
+    guardNotNull(name, "name", "HW9LockKind_parse");
+
+    if (strcmp(name, "pthread") == 0) {
+        return HW9LockKind_Pthread;
+    }
+    if (strcmp(name, "adaptive") == 0) {
+        return HW9LockKind_Adaptive;
+    }
+    if (strcmp(name, "ticket") == 0) {
+        return HW9LockKind_Ticket;
+    }
+    if (strcmp(name, "mcs") == 0) {
+        return HW9LockKind_Mcs;
+    }
+
+    abortWithErrorFmt("HW9LockKind_parse: unknown HW9LockKind name \"%s\"", name);
+    return (enum HW9LockKind)-1;
+}
+
+char const *HW9LockKind_name(enum HW9LockKind const kind) {
+    switch (kind) {
+        case HW9LockKind_Pthread: return "pthread";
+        case HW9LockKind_Adaptive: return "adaptive";
+        case HW9LockKind_Ticket: return "ticket";
+        case HW9LockKind_Mcs: return "mcs";
+        default: {
+            abortWithErrorFmt("HW9LockKind_name: unknown HW9LockKind %d", (int)kind);
+            return NULL;
+        }
+    }
+}
+
+enum HW9IoBackend HW9IoBackend_parse(char const * const name) {
+    guardNotNull(name, "name", "HW9IoBackend_parse");
+
+    if (strcmp(name, "stdio") == 0) {
+        return HW9IoBackend_Stdio;
+    }
+    if (strcmp(name, "uring") == 0) {
+        return HW9IoBackend_IoUring;
+    }
+    if (strcmp(name, "async") == 0) {
+        return HW9IoBackend_Async;
+    }
+
+    abortWithErrorFmt("HW9IoBackend_parse: unknown HW9IoBackend name \"%s\"", name);
+    return (enum HW9IoBackend)-1;
+}
+
+char const *HW9IoBackend_name(enum HW9IoBackend const backend) {
+    switch (backend) {
+        case HW9IoBackend_Stdio: return "stdio";
+        case HW9IoBackend_IoUring: return "uring";
+        case HW9IoBackend_Async: return "async";
+        default: {
+            abortWithErrorFmt("HW9IoBackend_name: unknown HW9IoBackend %d", (int)backend);
+            return NULL;
+        }
+    }
+}
+
+enum HW9OutputFormat HW9OutputFormat_parse(char const * const name) {
+    guardNotNull(name, "name", "HW9OutputFormat_parse");
+
+    if (strcmp(name, "text") == 0) {
+        return HW9OutputFormat_Text;
+    }
+    if (strcmp(name, "columnar") == 0) {
+        return HW9OutputFormat_Columnar;
+    }
+
+    abortWithErrorFmt("HW9OutputFormat_parse: unknown HW9OutputFormat name \"%s\"", name);
+    return (enum HW9OutputFormat)-1;
+}
+
+char const *HW9OutputFormat_name(enum HW9OutputFormat const format) {
+    switch (format) {
+        case HW9OutputFormat_Text: return "text";
+        case HW9OutputFormat_Columnar: return "columnar";
+        default: {
+            abortWithErrorFmt("HW9OutputFormat_name: unknown HW9OutputFormat %d", (int)format);
+            return NULL;
+        }
+    }
+}
+
+enum HW9FileOutput HW9FileOutput_parse(char const * const name) {
+    guardNotNull(name, "name", "HW9FileOutput_parse");
+
+    if (strcmp(name, "concat") == 0) {
+        return HW9FileOutput_Concatenated;
+    }
+    if (strcmp(name, "per-file") == 0) {
+        return HW9FileOutput_PerFile;
+    }
+
+    abortWithErrorFmt("HW9FileOutput_parse: unknown HW9FileOutput name \"%s\"", name);
+    return (enum HW9FileOutput)-1;
+}
+
+char const *HW9FileOutput_name(enum HW9FileOutput const fileOutput) {
+    switch (fileOutput) {
+        case HW9FileOutput_Concatenated: return "concat";
+        case HW9FileOutput_PerFile: return "per-file";
+        default: {
+            abortWithErrorFmt("HW9FileOutput_name: unknown HW9FileOutput %d", (int)fileOutput);
+            return NULL;
+        }
+    }
+}
+
 static void *processWordsWithMutexThreadStart(void * const argAsVoidPtr) {
     assert(argAsVoidPtr != NULL);
     struct ProcessWordsWithMutexThreadStartArg * const argPtr = argAsVoidPtr;
 
+    struct ThreadStats * const statsPtr = &argPtr->stats;
+    ThreadStats_beginUsage(statsPtr);
+    Arena const wordArena = Arena_create(wordArenaBlockCapacity, false);
+
     while (true) {
-        safeMutexLock(argPtr->fileMutexPtr, "hw9 processWordsWithMutexThreadStart");
+        acquireClaimLock(argPtr->claimLockPtr, statsPtr, "hw9 processWordsWithMutexThreadStart");
 
-        char * const word = readFileLine(argPtr->inFile);
-        if (word == NULL) {
-            safeMutexUnlock(argPtr->fileMutexPtr, "hw9 processWordsWithMutexThreadStart");
+        struct ClaimedWord word;
+        if (!claimWord(argPtr->inputPtr, wordArena, &word)) {
+            releaseClaimLock(argPtr->claimLockPtr, statsPtr, "hw9 processWordsWithMutexThreadStart");
             break;
         }
 
-        fprintf(argPtr->outFile, "%s\t%u\n", word, argPtr->threadNumber);
-        free(word);
+        unsigned int const lineLength = safeFprintf(
+            argPtr->outFile,
+            "hw9 processWordsWithMutexThreadStart",
+            "%.*s\t%u\n",
+            (int)word.span.length,
+            word.span.chars,
+            argPtr->threadNumber
+        );
+        releaseWord(&word);
+        Arena_reset(wordArena);
 
-        safeMutexUnlock(argPtr->fileMutexPtr, "hw9 processWordsWithMutexThreadStart");
+        releaseClaimLock(argPtr->claimLockPtr, statsPtr, "hw9 processWordsWithMutexThreadStart");
+        ThreadStats_addWords(statsPtr, 1, lineLength);
 
-        nanosleep(&(struct timespec){
-            .tv_sec = 0,
-            .tv_nsec = randomInt(0, 1000 * 1000 * 1000)
-        }, NULL);
+        ThreadStats_addSleep(statsPtr, Pacer_pace(argPtr->pacer, argPtr->threadNumber - 1));
     }
 
+    Arena_destroy(wordArena);
+    ThreadStats_captureUsage(statsPtr);
     return NULL;
 }
 
@@ -160,20 +947,1212 @@ static void *processWordsWithoutMutexThreadStart(void * const argAsVoidPtr) {
     assert(argAsVoidPtr != NULL);
     struct ProcessWordsWithoutMutexThreadStartArg * const argPtr = argAsVoidPtr;
 
+    struct ThreadStats * const statsPtr = &argPtr->stats;
+    ThreadStats_beginUsage(statsPtr);
+    Arena const wordArena = Arena_create(wordArenaBlockCapacity, false);
+
+    while (true) {
+        struct ClaimedWord word;
+        if (!claimWord(argPtr->inputPtr, wordArena, &word)) {
+            break;
+        }
+
+        unsigned int const lineLength = safeFprintf(
+            argPtr->outFile,
+            "hw9 processWordsWithoutMutexThreadStart",
+            "%.*s\t%u\n",
+            (int)word.span.length,
+            word.span.chars,
+            argPtr->threadNumber
+        );
+        releaseWord(&word);
+        Arena_reset(wordArena);
+        ThreadStats_addWords(statsPtr, 1, lineLength);
+
+        ThreadStats_addSleep(statsPtr, Pacer_pace(argPtr->pacer, argPtr->threadNumber - 1));
+    }
+
+    Arena_destroy(wordArena);
+    ThreadStats_captureUsage(statsPtr);
+    return NULL;
+}
+
+/**
+ * Claim a word and its sequence number while holding the claim mutex, then process the word and submit its output line
+ * to the reorder buffer without holding the claim mutex. The reorder buffer writes lines in input order regardless of
+ * which thread finishes processing first.
+ */
+static void *processWordsOrderedThreadStart(void * const argAsVoidPtr) {
+    assert(argAsVoidPtr != NULL);
+    struct ProcessWordsOrderedThreadStartArg * const argPtr = argAsVoidPtr;
+
+    struct ThreadStats * const statsPtr = &argPtr->stats;
+    ThreadStats_beginUsage(statsPtr);
+    Arena const wordArena = Arena_create(wordArenaBlockCapacity, false);
+
     while (true) {
-        char * const word = readFileLine(argPtr->inFile);
-        if (word == NULL) {
+        acquireClaimLock(argPtr->claimLockPtr, statsPtr, "hw9 processWordsOrderedThreadStart");
+
+        struct ClaimedWord word;
+        bool const claimed = claimWord(argPtr->inputPtr, wordArena, &word);
+        size_t const sequenceNumber = *argPtr->nextSequenceNumberPtr;
+        if (claimed) {
+            *argPtr->nextSequenceNumberPtr += 1;
+        }
+
+        releaseClaimLock(argPtr->claimLockPtr, statsPtr, "hw9 processWordsOrderedThreadStart");
+
+        if (!claimed) {
             break;
         }
 
-        fprintf(argPtr->outFile, "%s\t%u\n", word, argPtr->threadNumber);
-        free(word);
+        char * const line = formatString("%.*s\t%u\n", (int)word.span.length, word.span.chars, argPtr->threadNumber);
+        releaseWord(&word);
+        Arena_reset(wordArena);
+        ThreadStats_addWords(statsPtr, 1, strlen(line));
 
-        nanosleep(&(struct timespec){
-            .tv_sec = 0,
-            .tv_nsec = randomInt(0, 1000 * 1000 * 1000)
-        }, NULL);
+        ThreadStats_addSleep(statsPtr, Pacer_pace(argPtr->pacer, argPtr->threadNumber - 1));
+
+        ReorderBuffer_submit(argPtr->reorderBuffer, sequenceNumber, line);
+    }
+
+    Arena_destroy(wordArena);
+    ThreadStats_captureUsage(statsPtr);
+    return NULL;
+}
+
+/**
+ * Claim a block of consecutive words under a single lock acquisition and write their output lines as one contiguous
+ * block before releasing the lock. With an adaptive batch size, each thread grows its block while it spends longer
+ * waiting for the lock than holding it, and shrinks it again once the lock is uncontended.
+ */
+static void *processWordsBatchedThreadStart(void * const argAsVoidPtr) {
+    assert(argAsVoidPtr != NULL);
+    struct ProcessWordsBatchedThreadStartArg * const argPtr = argAsVoidPtr;
+
+    struct ThreadStats * const statsPtr = &argPtr->stats;
+    ThreadStats_beginUsage(statsPtr);
+
+    bool const adaptive = argPtr->batchSize == 0;
+    size_t batchSize = adaptive ? 1 : argPtr->batchSize;
+    StringBuilder const blockBuilder = StringBuilder_create();
+    Arena const wordArena = Arena_create(wordArenaBlockCapacity, false);
+
+    bool endOfFile = false;
+    while (!endOfFile) {
+        uint64_t const lockRequestCycles = cycleCount();
+        acquireClaimLock(argPtr->claimLockPtr, NULL, "hw9 processWordsBatchedThreadStart");
+        uint64_t const lockAcquireCycles = cycleCount();
+
+        size_t wordCount = 0;
+        while (wordCount < batchSize) {
+            struct ClaimedWord word;
+            if (!claimWord(argPtr->inputPtr, wordArena, &word)) {
+                endOfFile = true;
+                break;
+            }
+
+            StringBuilder_appendChars(blockBuilder, word.span.chars, word.span.length);
+            StringBuilder_appendFmt(blockBuilder, "\t%u\n", argPtr->threadNumber);
+            releaseWord(&word);
+            wordCount += 1;
+        }
+        Arena_reset(wordArena);
+
+        size_t const blockLength = StringBuilder_length(blockBuilder);
+        if (blockLength > 0) {
+            safeFwrite(
+                StringBuilder_chars(blockBuilder),
+                blockLength,
+                argPtr->outFile,
+                "hw9 processWordsBatchedThreadStart"
+            );
+        }
+
+        releaseClaimLock(argPtr->claimLockPtr, NULL, "hw9 processWordsBatchedThreadStart");
+        uint64_t const lockReleaseCycles = cycleCount();
+
+        StringBuilder_clear(blockBuilder);
+
+        uint64_t const lockWaitNanoseconds = elapsedCycleNanoseconds(lockRequestCycles, lockAcquireCycles);
+        uint64_t const lockHoldNanoseconds = elapsedCycleNanoseconds(lockAcquireCycles, lockReleaseCycles);
+        ThreadStats_addLockTimes(statsPtr, lockWaitNanoseconds, lockHoldNanoseconds);
+        ThreadStats_addWords(statsPtr, wordCount, blockLength);
+
+        if (adaptive) {
+            batchSize = adaptBatchSize(batchSize, lockWaitNanoseconds, lockHoldNanoseconds);
+        }
+
+        for (size_t i = 0; i < wordCount; i += 1) {
+            ThreadStats_addSleep(statsPtr, Pacer_pace(argPtr->pacer, argPtr->threadNumber - 1));
+        }
     }
 
+    Arena_destroy(wordArena);
+    StringBuilder_destroy(blockBuilder);
+    ThreadStats_captureUsage(statsPtr);
     return NULL;
 }
+
+/**
+ * Calculate the next adaptive batch size from how long the last batch waited for and held the lock. Waiting longer than
+ * holding means the lock is contended, so the batch doubles; waiting under a quarter of the hold time means it is not,
+ * so the batch halves.
+ *
+ * @param batchSize The current batch size.
+ * @param lockWaitNanoseconds How long the last lock acquisition waited.
+ * @param lockHoldNanoseconds How long the last batch held the lock.
+ *
+ * @returns The next batch size, between 1 and maxAdaptiveBatchSize.
+ */
+static size_t adaptBatchSize(
+    size_t const batchSize,
+    uint64_t const lockWaitNanoseconds,
+    uint64_t const lockHoldNanoseconds
+) {
+    if (lockWaitNanoseconds > lockHoldNanoseconds) {
+        return batchSize * 2 > maxAdaptiveBatchSize ? maxAdaptiveBatchSize : batchSize * 2;
+    }
+    if (lockWaitNanoseconds * 4 < lockHoldNanoseconds) {
+        return batchSize / 2 < 1 ? 1 : batchSize / 2;
+    }
+    return batchSize;
+}
+
+/**
+ * Take word indexes from the shared atomic counter and write each word directly from its span into the mapped input.
+ * Neither reading nor claiming a word takes a lock; only the stream lock inside fprintf serializes writes.
+ */
+static void *processWordsLockFreeThreadStart(void * const argAsVoidPtr) {
+    assert(argAsVoidPtr != NULL);
+    struct ProcessWordsLockFreeThreadStartArg * const argPtr = argAsVoidPtr;
+
+    struct ThreadStats * const statsPtr = &argPtr->stats;
+    ThreadStats_beginUsage(statsPtr);
+
+    while (true) {
+        size_t const wordIndex = atomic_fetch_add_explicit(argPtr->nextWordIndexPtr, 1, memory_order_relaxed);
+        if (wordIndex >= argPtr->wordCount) {
+            break;
+        }
+
+        struct StringSpan const word = argPtr->words[wordIndex];
+        unsigned int const lineLength = safeFprintf(
+            argPtr->outFile,
+            "hw9 processWordsLockFreeThreadStart",
+            "%.*s\t%u\n",
+            (int)word.length,
+            word.chars,
+            argPtr->threadNumber
+        );
+        ThreadStats_addWords(statsPtr, 1, lineLength);
+
+        ThreadStats_addSleep(statsPtr, Pacer_pace(argPtr->pacer, argPtr->threadNumber - 1));
+    }
+
+    ThreadStats_captureUsage(statsPtr);
+    return NULL;
+}
+
+/**
+ * Claim word indexes from the shared atomic counter like LockFree mode, but append each line to this thread's own shard
+ * tagged with the word's index as its sequence number. No output stream is shared between threads; the shards are
+ * merged back into input order once every thread has finished.
+ */
+static void *processWordsShardedThreadStart(void * const argAsVoidPtr) {
+    assert(argAsVoidPtr != NULL);
+    struct ProcessWordsShardedThreadStartArg * const argPtr = argAsVoidPtr;
+
+    struct ThreadStats * const statsPtr = &argPtr->stats;
+    ThreadStats_beginUsage(statsPtr);
+
+    while (true) {
+        size_t const wordIndex = atomic_fetch_add_explicit(argPtr->nextWordIndexPtr, 1, memory_order_relaxed);
+        if (wordIndex >= argPtr->wordCount) {
+            break;
+        }
+
+        struct StringSpan const word = argPtr->words[wordIndex];
+        size_t const lineLength = Shard_appendFmt(
+            argPtr->shard,
+            wordIndex,
+            "%.*s\t%u\n",
+            (int)word.length,
+            word.chars,
+            argPtr->threadNumber
+        );
+        ThreadStats_addWords(statsPtr, 1, lineLength);
+
+        ThreadStats_addSleep(statsPtr, Pacer_pace(argPtr->pacer, argPtr->threadNumber - 1));
+    }
+
+    ThreadStats_captureUsage(statsPtr);
+    return NULL;
+}
+
+/**
+ * Merge the finished shards into the output file in sequence order. Large outputs are split into contiguous sequence
+ * ranges which are merged concurrently into part files and then concatenated.
+ *
+ * @param shards The finished shards.
+ * @param shardCount The number of shards.
+ * @param sequenceCount The total number of lines across all shards, numbered from 0.
+ * @param maxMergeThreadCount The most threads to merge with.
+ * @param mergePool The thread pool to merge on instead of creating threads, or null.
+ * @param outFile The output file.
+ * @param outFilePath The output file's path, used to name the part files.
+ */
+static void mergeShards(
+    ConstShard const * const shards,
+    size_t const shardCount,
+    size_t const sequenceCount,
+    unsigned int const maxMergeThreadCount,
+    ThreadPool const mergePool,
+    FILE * const outFile,
+    char const * const outFilePath
+) {
+    size_t mergeThreadCount = sequenceCount / minWordsPerMergeThread;
+    if (mergeThreadCount > maxMergeThreadCount) {
+        mergeThreadCount = maxMergeThreadCount;
+    }
+    if (mergeThreadCount <= 1) {
+        Shard_mergeRange(shards, shardCount, 0, sequenceCount, outFile);
+        return;
+    }
+
+    struct MergeShardsThreadStartArg * const threadStartArgs = (
+        safeMalloc(sizeof *threadStartArgs * mergeThreadCount, "hw9 mergeShards")
+    );
+    for (size_t i = 0; i < mergeThreadCount; i += 1) {
+        struct MergeShardsThreadStartArg * const threadStartArgPtr = &threadStartArgs[i];
+
+        threadStartArgPtr->shards = shards;
+        threadStartArgPtr->shardCount = shardCount;
+        threadStartArgPtr->sequenceStart = sequenceCount * i / mergeThreadCount;
+        threadStartArgPtr->sequenceEnd = sequenceCount * (i + 1) / mergeThreadCount;
+        threadStartArgPtr->partFilePath = formatString("%s.part%zu", outFilePath, i + 1);
+    }
+
+    if (mergePool != NULL) {
+        ThreadPool_submitBatch(
+            mergePool,
+            mergeShardsThreadStart,
+            threadStartArgs,
+            sizeof *threadStartArgs,
+            mergeThreadCount
+        );
+        ThreadPool_waitAll(mergePool);
+    } else {
+        pthread_t * const threadIds = safeMalloc(sizeof *threadIds * mergeThreadCount, "hw9 mergeShards");
+        for (size_t i = 0; i < mergeThreadCount; i += 1) {
+            threadIds[i] = safePthreadCreate(NULL, mergeShardsThreadStart, &threadStartArgs[i], "hw9 mergeShards");
+        }
+        for (size_t i = 0; i < mergeThreadCount; i += 1) {
+            safePthreadJoin(threadIds[i], "hw9 mergeShards");
+        }
+        free(threadIds);
+    }
+
+    for (size_t i = 0; i < mergeThreadCount; i += 1) {
+        char * const partFilePath = threadStartArgs[i].partFilePath;
+        appendFileContents(outFile, partFilePath);
+        remove(partFilePath);
+        free(partFilePath);
+    }
+
+    free(threadStartArgs);
+}
+
+/**
+ * Merge one sequence range of the shards into its own part file.
+ */
+static void *mergeShardsThreadStart(void * const argAsVoidPtr) {
+    assert(argAsVoidPtr != NULL);
+    struct MergeShardsThreadStartArg * const argPtr = argAsVoidPtr;
+
+    FILE * const partFile = safeFopen(argPtr->partFilePath, "w", "hw9 mergeShardsThreadStart");
+    Shard_mergeRange(argPtr->shards, argPtr->shardCount, argPtr->sequenceStart, argPtr->sequenceEnd, partFile);
+    safeFclose(partFile, "hw9 mergeShardsThreadStart");
+
+    return NULL;
+}
+
+/**
+ * Process one chunk of words stolen or owned by a work-stealing worker, writing each word straight from its span.
+ */
+static void processWordRangeWorkStealing(
+    void * const stateAsVoidPtr,
+    unsigned int const workerIndex,
+    size_t const wordStart,
+    size_t const wordEnd
+) {
+    assert(stateAsVoidPtr != NULL);
+    struct ProcessWordsWorkStealingState * const statePtr = stateAsVoidPtr;
+    unsigned int const threadNumber = workerIndex + 1;
+    struct ThreadStats * const workerStatsPtr = &statePtr->workers[workerIndex].stats;
+    ThreadStats_beginUsage(workerStatsPtr);
+
+    for (size_t i = wordStart; i < wordEnd; i += 1) {
+        struct StringSpan const word = statePtr->words[i];
+        unsigned int const lineLength = safeFprintf(
+            statePtr->outFile,
+            "hw9 processWordRangeWorkStealing",
+            "%.*s\t%u\n",
+            (int)word.length,
+            word.chars,
+            threadNumber
+        );
+        ThreadStats_addWords(workerStatsPtr, 1, lineLength);
+
+        ThreadStats_addSleep(workerStatsPtr, Pacer_pace(statePtr->pacer, workerIndex));
+    }
+
+    // The worker's thread start is inside runWorkStealing, so refresh its usage after every chunk it processes
+    ThreadStats_captureUsage(workerStatsPtr);
+}
+
+/**
+ * Choose a chunk size that gives each thread several chunks, so that there is something left to steal when a thread
+ * falls behind.
+ *
+ * @param wordCount The number of words.
+ * @param threadCount The number of threads.
+ *
+ * @returns The chunk size, at least 1.
+ */
+static size_t autoChunkSize(size_t const wordCount, unsigned int const threadCount) {
+    size_t const chunkSize = wordCount / ((size_t)threadCount * autoChunksPerThread);
+    return chunkSize == 0 ? 1 : chunkSize;
+}
+
+/**
+ * The pipeline's reader stage: the only thread that touches the input. Push every word onto the word queue, then close
+ * it.
+ */
+static void *readWordsPipelineThreadStart(void * const argAsVoidPtr) {
+    assert(argAsVoidPtr != NULL);
+    struct ReadWordsPipelineThreadStartArg * const argPtr = argAsVoidPtr;
+
+    while (true) {
+        struct ClaimedWord * const wordPtr = safeMalloc(sizeof *wordPtr, "hw9 readWordsPipelineThreadStart");
+        if (!claimWord(argPtr->inputPtr, NULL, wordPtr)) {
+            free(wordPtr);
+            break;
+        }
+
+        BoundedQueue_push(argPtr->wordQueue, wordPtr);
+    }
+
+    BoundedQueue_close(argPtr->wordQueue);
+    return NULL;
+}
+
+/**
+ * The pipeline's worker stage: turn words from the word queue into output lines on the line queue. The last worker to
+ * finish closes the line queue.
+ */
+static void *processWordsPipelineThreadStart(void * const argAsVoidPtr) {
+    assert(argAsVoidPtr != NULL);
+    struct ProcessWordsPipelineThreadStartArg * const argPtr = argAsVoidPtr;
+
+    struct ThreadStats * const statsPtr = &argPtr->stats;
+    ThreadStats_beginUsage(statsPtr);
+
+    void *wordAsVoidPtr;
+    while (BoundedQueue_pop(argPtr->wordQueue, &wordAsVoidPtr)) {
+        struct ClaimedWord * const wordPtr = wordAsVoidPtr;
+
+        char * const line = formatString(
+            "%.*s\t%u\n",
+            (int)wordPtr->span.length,
+            wordPtr->span.chars,
+            argPtr->threadNumber
+        );
+        releaseWord(wordPtr);
+        free(wordPtr);
+        ThreadStats_addWords(statsPtr, 1, strlen(line));
+
+        ThreadStats_addSleep(statsPtr, Pacer_pace(argPtr->pacer, argPtr->threadNumber - 1));
+
+        BoundedQueue_push(argPtr->lineQueue, line);
+    }
+
+    if (atomic_fetch_sub(argPtr->runningWorkerCountPtr, 1) == 1) {
+        BoundedQueue_close(argPtr->lineQueue);
+    }
+    ThreadStats_captureUsage(statsPtr);
+    return NULL;
+}
+
+/**
+ * The pipeline's writer stage: the only thread that touches the output. Write lines from the line queue until it is
+ * closed and drained.
+ */
+static void *writeLinesPipelineThreadStart(void * const argAsVoidPtr) {
+    assert(argAsVoidPtr != NULL);
+    struct WriteLinesPipelineThreadStartArg * const argPtr = argAsVoidPtr;
+
+    void *lineAsVoidPtr;
+    while (BoundedQueue_pop(argPtr->lineQueue, &lineAsVoidPtr)) {
+        char * const line = lineAsVoidPtr;
+        safeFwrite(line, strlen(line), argPtr->outFile, "hw9 writeLinesPipelineThreadStart");
+        free(line);
+    }
+
+    return NULL;
+}
+
+/**
+ * Take whole files from the shared queue until it is empty. Each file's lines are collected into one block which is
+ * submitted to the reorder buffer under the file's index, or written to the file's own output file.
+ */
+static void *processFilesThreadStart(void * const argAsVoidPtr) {
+    assert(argAsVoidPtr != NULL);
+    struct ProcessFilesThreadStartArg * const argPtr = argAsVoidPtr;
+
+    struct ThreadStats * const statsPtr = &argPtr->stats;
+    ThreadStats_beginUsage(statsPtr);
+
+    // Each file is read by this thread alone, so a streamed or mapped input needs no claim lock
+    struct HW9Options inputOptions = *argPtr->options;
+    inputOptions.mode = HW9Mode_Mutex;
+    inputOptions.mappedInput = true;
+    Arena const wordArena = Arena_create(wordArenaBlockCapacity, false);
+
+    size_t const fileCount = StringList_count(argPtr->filePaths);
+    while (true) {
+        size_t const fileIndex = atomic_fetch_add(argPtr->nextFileIndexPtr, 1);
+        if (fileIndex >= fileCount) {
+            break;
+        }
+        char const * const filePath = StringList_get(argPtr->filePaths, fileIndex);
+
+        struct WordInput input;
+        openWordInput(&input, filePath, &inputOptions);
+
+        StringBuilder const blockBuilder = argPtr->reorderBuffer != NULL ? StringBuilder_create() : NULL;
+        char * const fileOutFilePath = argPtr->reorderBuffer != NULL
+            ? NULL
+            : formatString("%s.%zu", argPtr->outFilePath, fileIndex + 1);
+        FILE * const fileOutFile = fileOutFilePath != NULL
+            ? openOutputFile(fileOutFilePath, argPtr->options, "hw9 processFilesThreadStart")
+            : NULL;
+
+        struct ClaimedWord word;
+        while (claimWord(&input, wordArena, &word)) {
+            size_t lineLength;
+            if (blockBuilder != NULL) {
+                size_t const blockLength = StringBuilder_length(blockBuilder);
+                StringBuilder_appendFmt(
+                    blockBuilder,
+                    "%.*s\t%u\n",
+                    (int)word.span.length,
+                    word.span.chars,
+                    argPtr->threadNumber
+                );
+                lineLength = StringBuilder_length(blockBuilder) - blockLength;
+            } else {
+                lineLength = safeFprintf(
+                    fileOutFile,
+                    "hw9 processFilesThreadStart",
+                    "%.*s\t%u\n",
+                    (int)word.span.length,
+                    word.span.chars,
+                    argPtr->threadNumber
+                );
+            }
+            releaseWord(&word);
+            Arena_reset(wordArena);
+            ThreadStats_addWords(statsPtr, 1, lineLength);
+
+            ThreadStats_addSleep(statsPtr, Pacer_pace(argPtr->pacer, argPtr->threadNumber - 1));
+        }
+        closeWordInput(&input);
+
+        if (blockBuilder != NULL) {
+            ReorderBuffer_submit(argPtr->reorderBuffer, fileIndex, StringBuilder_toStringAndDestroy(blockBuilder));
+        } else {
+            fclose(fileOutFile);
+            free(fileOutFilePath);
+        }
+    }
+
+    Arena_destroy(wordArena);
+    ThreadStats_captureUsage(statsPtr);
+    return NULL;
+}
+
+/**
+ * Expand the input paths given to hw9Files into the list of files to process. A directory is replaced by the regular
+ * files directly inside it, sorted by name; any other path is kept as is. If a directory cannot be read, abort the
+ * program with an error message.
+ *
+ * @param paths The input paths.
+ * @param pathCount The number of input paths.
+ *
+ * @returns The file paths, in processing order. The caller is responsible for freeing each path and the list.
+ */
+static StringList expandInputPaths(char const * const * const paths, size_t const pathCount) {
+    StringList const filePaths = StringList_create();
+
+    for (size_t i = 0; i < pathCount; i += 1) {
+        char const * const path = paths[i];
+
+        struct stat pathStatus;
+        if (stat(path, &pathStatus) != 0 || !S_ISDIR(pathStatus.st_mode)) {
+            StringList_add(filePaths, formatString("%s", path));
+            continue;
+        }
+
+        DIR * const directory = opendir(path);
+        if (directory == NULL) {
+            int const opendirErrorCode = errno;
+            char const * const opendirErrorMessage = strerror(opendirErrorCode);
+
+            abortWithErrorFmt(
+                "hw9 expandInputPaths: Failed to open directory \"%s\" using opendir"
+                " (error code: %d; error message: \"%s\")",
+                path,
+                opendirErrorCode,
+                opendirErrorMessage
+            );
+            return NULL;
+        }
+
+        size_t const directoryStart = StringList_count(filePaths);
+        struct dirent const *entry;
+        while ((entry = readdir(directory)) != NULL) {
+            char * const entryPath = formatString("%s/%s", path, entry->d_name);
+
+            struct stat entryStatus;
+            if (stat(entryPath, &entryStatus) == 0 && S_ISREG(entryStatus.st_mode)) {
+                StringList_add(filePaths, entryPath);
+            } else {
+                free(entryPath);
+            }
+        }
+        closedir(directory);
+
+        // An empty directory contributes no files
+        if (StringList_count(filePaths) > directoryStart) {
+            qsort(
+                StringList_getPtr(filePaths, directoryStart),
+                StringList_count(filePaths) - directoryStart,
+                sizeof (char *),
+                compareStrings
+            );
+        }
+    }
+
+    return filePaths;
+}
+
+/**
+ * Compare two strings, for qsort over an array of strings.
+ */
+static int compareStrings(void const * const aAsVoidPtr, void const * const bAsVoidPtr) {
+    char const * const * const aPtr = aAsVoidPtr;
+    char const * const * const bPtr = bAsVoidPtr;
+    return strcmp(*aPtr, *bPtr);
+}
+
+/**
+ * Open an output file for writing through the configured I/O backend and in the configured format.
+ *
+ * @param filePath The output file path.
+ * @param options The run options. The ioBackend and outputFormat are used.
+ * @param callerDescription A description of the caller to be included in the error message if opening fails.
+ *
+ * @returns The output stream. The caller is responsible for closing it with fclose.
+ */
+static FILE *openOutputFile(
+    char const * const filePath,
+    struct HW9Options const * const options,
+    char const * const callerDescription
+) {
+    FILE *outFile = NULL;
+    if (options->ioBackend == HW9IoBackend_IoUring) {
+        outFile = ioUringFopenWrite(filePath, callerDescription);
+    } else if (options->ioBackend == HW9IoBackend_Async) {
+        outFile = AsyncWriter_openStream(filePath, asyncOutputBufferCapacity, callerDescription);
+    }
+    if (outFile == NULL) {
+        outFile = safeFopen(filePath, "w", callerDescription);
+    }
+    if (options->outputFormat == HW9OutputFormat_Columnar) {
+        outFile = ColumnarOutput_openStream(outFile, callerDescription);
+    }
+    return outFile;
+}
+
+/**
+ * Write the run's statistics as a JSON report: the run's mode, thread count, and wall time, followed by each worker's
+ * counters.
+ *
+ * @param statsFilePath The report file.
+ * @param modeName The name of the mode to report.
+ * @param options The run options.
+ * @param wallNanoseconds The run's wall time.
+ * @param threadStatsPtrs Each worker's stats, in thread number order.
+ */
+static void writeStatsReport(
+    char const * const statsFilePath,
+    char const * const modeName,
+    struct HW9Options const * const options,
+    uint64_t const wallNanoseconds,
+    struct ThreadStats const * const * const threadStatsPtrs
+) {
+    FILE * const statsFile = safeFopen(statsFilePath, "w", "hw9 writeStatsReport");
+
+    safeFprintf(
+        statsFile,
+        "hw9 writeStatsReport",
+        "{\n  \"mode\": \"%s\",\n  \"lockKind\": \"%s\",\n  \"ioBackend\": \"%s\",\n"
+        "  \"outputFormat\": \"%s\",\n  \"threadCount\": %u,\n  \"wallNanoseconds\": %" PRIu64 ",\n  \"threads\": [\n",
+        modeName,
+        HW9LockKind_name(options->lockKind),
+        HW9IoBackend_name(options->ioBackend),
+        HW9OutputFormat_name(options->outputFormat),
+        options->threadCount,
+        wallNanoseconds
+    );
+    for (unsigned int i = 0; i < options->threadCount; i += 1) {
+        fputs("    ", statsFile);
+        ThreadStats_writeJson(threadStatsPtrs[i], i + 1, statsFile);
+        fputs(i + 1 < options->threadCount ? ",\n" : "\n", statsFile);
+    }
+    fputs("  ]\n}\n", statsFile);
+
+    fclose(statsFile);
+}
+
+/**
+ * Initialize a claim lock of the given kind, unlocked.
+ *
+ * @param lockOutPtr The memory where the lock should be initialized.
+ * @param kind Which lock implementation to use.
+ * @param callerDescription A description of the caller to be included in the error message if initialization fails.
+ */
+static void initClaimLock(
+    struct ClaimLock * const lockOutPtr,
+    enum HW9LockKind const kind,
+    char const * const callerDescription
+) {
+    lockOutPtr->kind = kind;
+    switch (kind) {
+        case HW9LockKind_Pthread: {
+            safeMutexInit(&lockOutPtr->mutex, NULL, callerDescription);
+            break;
+        }
+        case HW9LockKind_Adaptive: {
+            safeAdaptiveMutexInit(&lockOutPtr->adaptiveMutex, callerDescription);
+            break;
+        }
+        case HW9LockKind_Ticket: {
+            TicketLock_init(&lockOutPtr->ticketLock);
+            break;
+        }
+        case HW9LockKind_Mcs: {
+            McsLock_init(&lockOutPtr->mcsLock);
+            break;
+        }
+        default: {
+            abortWithErrorFmt("%s: unknown HW9LockKind %d", callerDescription, (int)kind);
+        }
+    }
+}
+
+/**
+ * Acquire the claim lock. Release it with releaseClaimLock.
+ *
+ * @param lockPtr The lock.
+ * @param statsPtr The calling thread's stats, in which to count how long the thread waited for the lock, or null if the
+ *                 caller times the lock itself.
+ * @param callerDescription A description of the caller to be included in the error message if locking fails.
+ */
+static void acquireClaimLock(
+    struct ClaimLock * const lockPtr,
+    struct ThreadStats * const statsPtr,
+    char const * const callerDescription
+) {
+    uint64_t const requestCycles = statsPtr == NULL ? 0 : cycleCount();
+
+    switch (lockPtr->kind) {
+        case HW9LockKind_Pthread: {
+            safeMutexLock(&lockPtr->mutex, callerDescription);
+            break;
+        }
+        case HW9LockKind_Adaptive: {
+            safeAdaptiveMutexLock(&lockPtr->adaptiveMutex, callerDescription);
+            break;
+        }
+        case HW9LockKind_Ticket: {
+            TicketLock_lock(&lockPtr->ticketLock);
+            break;
+        }
+        case HW9LockKind_Mcs: {
+            McsLock_lock(&lockPtr->mcsLock, &claimLockMcsNode);
+            break;
+        }
+        default: {
+            abortWithErrorFmt("%s: unknown HW9LockKind %d", callerDescription, (int)lockPtr->kind);
+            return;
+        }
+    }
+
+    if (statsPtr != NULL) {
+        statsPtr->lockAcquireCycles = cycleCount();
+        ThreadStats_addLockTimes(statsPtr, elapsedCycleNanoseconds(requestCycles, statsPtr->lockAcquireCycles), 0);
+    }
+}
+
+/**
+ * Release a claim lock acquired with acquireClaimLock.
+ *
+ * @param lockPtr The lock.
+ * @param statsPtr The calling thread's stats, in which to count how long the thread held the lock, or null if the
+ *                 caller times the lock itself. Must be the same as was passed to acquireClaimLock.
+ * @param callerDescription A description of the caller to be included in the error message if unlocking fails.
+ */
+static void releaseClaimLock(
+    struct ClaimLock * const lockPtr,
+    struct ThreadStats * const statsPtr,
+    char const * const callerDescription
+) {
+    switch (lockPtr->kind) {
+        case HW9LockKind_Pthread: {
+            safeMutexUnlock(&lockPtr->mutex, callerDescription);
+            break;
+        }
+        case HW9LockKind_Adaptive: {
+            safeAdaptiveMutexUnlock(&lockPtr->adaptiveMutex, callerDescription);
+            break;
+        }
+        case HW9LockKind_Ticket: {
+            TicketLock_unlock(&lockPtr->ticketLock);
+            break;
+        }
+        case HW9LockKind_Mcs: {
+            McsLock_unlock(&lockPtr->mcsLock, &claimLockMcsNode);
+            break;
+        }
+        default: {
+            abortWithErrorFmt("%s: unknown HW9LockKind %d", callerDescription, (int)lockPtr->kind);
+            return;
+        }
+    }
+
+    if (statsPtr != NULL) {
+        ThreadStats_addLockTimes(statsPtr, 0, elapsedCycleNanoseconds(statsPtr->lockAcquireCycles, cycleCount()));
+    }
+}
+
+/**
+ * Destroy a claim lock.
+ *
+ * @param lockPtr The lock. It must not be held.
+ * @param callerDescription A description of the caller to be included in the error message if destruction fails.
+ */
+static void destroyClaimLock(struct ClaimLock * const lockPtr, char const * const callerDescription) {
+    switch (lockPtr->kind) {
+        case HW9LockKind_Pthread: {
+            safeMutexDestroy(&lockPtr->mutex, callerDescription);
+            break;
+        }
+        case HW9LockKind_Adaptive: {
+            safeAdaptiveMutexDestroy(&lockPtr->adaptiveMutex, callerDescription);
+            break;
+        }
+        case HW9LockKind_Ticket: {
+            TicketLock_destroy(&lockPtr->ticketLock, callerDescription);
+            break;
+        }
+        case HW9LockKind_Mcs: {
+            McsLock_destroy(&lockPtr->mcsLock, callerDescription);
+            break;
+        }
+        default: {
+            abortWithErrorFmt("%s: unknown HW9LockKind %d", callerDescription, (int)lockPtr->kind);
+        }
+    }
+}
+
+/**
+ * Get whether the mode claims words by index and so always reads the input through the memory mapping.
+ *
+ * @param mode The mode.
+ *
+ * @returns Whether the mode requires a mapped input.
+ */
+static bool modeRequiresMappedInput(enum HW9Mode const mode) {
+    return mode == HW9Mode_LockFree || mode == HW9Mode_Sharded || mode == HW9Mode_WorkStealing;
+}
+
+/**
+ * Prepare to launch a run's threads. Without a thread pool, pinned threads each get attributes naming their own CPU,
+ * and unpinned threads use the default attributes.
+ *
+ * @param launcherOutPtr The memory where the launcher should be initialized.
+ * @param maxThreadCount The most threads the run launches.
+ * @param options The run options. The threadPool and pinThreads are used.
+ * @param callerDescription A description of the caller to be included in error messages.
+ */
+static void initThreadLauncher(
+    struct ThreadLauncher * const launcherOutPtr,
+    size_t const maxThreadCount,
+    struct HW9Options const * const options,
+    char const * const callerDescription
+) {
+    launcherOutPtr->pool = options->threadPool;
+    launcherOutPtr->threadAttributes = NULL;
+    launcherOutPtr->maxThreadCount = maxThreadCount;
+    launcherOutPtr->threadIds = NULL;
+    launcherOutPtr->launchedThreadCount = 0;
+
+    if (launcherOutPtr->pool != NULL) {
+        guardFmt(
+            ThreadPool_threadCount(launcherOutPtr->pool) >= maxThreadCount,
+            "%s: threadPool has %zu threads, but this run needs %zu at once",
+            callerDescription,
+            ThreadPool_threadCount(launcherOutPtr->pool),
+            maxThreadCount
+        );
+        return;
+    }
+
+    if (options->pinThreads) {
+        launcherOutPtr->threadAttributes = safeMalloc(
+            sizeof *launcherOutPtr->threadAttributes * maxThreadCount,
+            callerDescription
+        );
+        for (size_t i = 0; i < maxThreadCount; i += 1) {
+            safePthreadAttrInit(&launcherOutPtr->threadAttributes[i], callerDescription);
+            safePthreadAttrSetCpu(&launcherOutPtr->threadAttributes[i], i, callerDescription);
+        }
+    }
+    launcherOutPtr->threadIds = safeMalloc(sizeof *launcherOutPtr->threadIds * maxThreadCount, callerDescription);
+}
+
+/**
+ * Launch the run's next thread: create it, or submit it to the thread pool.
+ *
+ * @param launcherPtr The launcher.
+ * @param startRoutine The function the thread runs.
+ * @param startRoutineArg The argument to pass to startRoutine.
+ * @param callerDescription A description of the caller to be included in error messages.
+ */
+static void launchThread(
+    struct ThreadLauncher * const launcherPtr,
+    PthreadCreateStartRoutine const startRoutine,
+    void * const startRoutineArg,
+    char const * const callerDescription
+) {
+    size_t const threadIndex = launcherPtr->launchedThreadCount;
+    guard(threadIndex < launcherPtr->maxThreadCount, "hw9 launchThread: launched more threads than maxThreadCount");
+
+    if (launcherPtr->pool != NULL) {
+        ThreadPool_submit(launcherPtr->pool, startRoutine, startRoutineArg);
+    } else {
+        launcherPtr->threadIds[threadIndex] = safePthreadCreate(
+            threadAttributesAt(launcherPtr->threadAttributes, threadIndex),
+            startRoutine,
+            startRoutineArg,
+            callerDescription
+        );
+    }
+    launcherPtr->launchedThreadCount += 1;
+}
+
+/**
+ * Wait for every thread launched so far to finish.
+ *
+ * @param launcherPtr The launcher.
+ * @param callerDescription A description of the caller to be included in error messages.
+ */
+static void joinLaunchedThreads(struct ThreadLauncher * const launcherPtr, char const * const callerDescription) {
+    if (launcherPtr->pool != NULL) {
+        ThreadPool_waitAll(launcherPtr->pool);
+    } else {
+        for (size_t i = 0; i < launcherPtr->launchedThreadCount; i += 1) {
+            safePthreadJoin(launcherPtr->threadIds[i], callerDescription);
+        }
+    }
+    launcherPtr->launchedThreadCount = 0;
+}
+
+/**
+ * Free the memory associated with the launcher. Its threads must have been joined.
+ *
+ * @param launcherPtr The launcher.
+ * @param callerDescription A description of the caller to be included in error messages.
+ */
+static void destroyThreadLauncher(struct ThreadLauncher * const launcherPtr, char const * const callerDescription) {
+    if (launcherPtr->threadAttributes != NULL) {
+        for (size_t i = 0; i < launcherPtr->maxThreadCount; i += 1) {
+            safePthreadAttrDestroy(&launcherPtr->threadAttributes[i], callerDescription);
+        }
+        free(launcherPtr->threadAttributes);
+    }
+    free(launcherPtr->threadIds);
+}
+
+/**
+ * Get the attributes to launch a thread with.
+ *
+ * @param threadAttributes The per-thread attributes, or null to use the default attributes for every thread.
+ * @param threadIndex The index of the thread.
+ *
+ * @returns The thread's attributes, or null for the default attributes.
+ */
+static pthread_attr_t const *threadAttributesAt(
+    pthread_attr_t const * const threadAttributes,
+    size_t const threadIndex
+) {
+    return threadAttributes == NULL ? NULL : &threadAttributes[threadIndex];
+}
+
+/**
+ * Split the whole input into word spans up front so that words can be claimed by index.
+ *
+ * @param tokenizer The tokenizer over the mapped input, positioned at its start.
+ * @param wordCountOutPtr The location to store the number of words.
+ *
+ * @returns The span of each word, in input order. The caller is responsible for freeing this memory.
+ */
+static struct StringSpan *indexWords(LineTokenizer const tokenizer, size_t * const wordCountOutPtr) {
+    size_t wordCount = 0;
+    struct StringSpan word;
+    while (LineTokenizer_next(tokenizer, &word)) {
+        wordCount += 1;
+    }
+    LineTokenizer_reset(tokenizer);
+
+    struct StringSpan * const words = safeMalloc(sizeof *words * (wordCount == 0 ? 1 : wordCount), "hw9 indexWords");
+    for (size_t i = 0; i < wordCount; i += 1) {
+        LineTokenizer_next(tokenizer, &words[i]);
+    }
+
+    *wordCountOutPtr = wordCount;
+    return words;
+}
+
+/**
+ * Open the input file, either as a stdio stream or as a memory mapping or io_uring-read copy with a tokenizer. Standard
+ * input ("-") and other inputs that are not regular files, such as pipes, cannot be mapped: modes that claim words by
+ * index read them in full, NoMutex mode reads them as a stdio stream, and the other modes split them through a
+ * fixed-size window so that memory use does not depend on the input size.
+ *
+ * When the options give word delimiters, the tokenizer splits words on them instead of newlines, and a regular file is
+ * mapped even if mappedInput is not set, since stdio streams are only split on newlines.
+ *
+ * @param inputOutPtr The location to store the input.
+ * @param filePath The input file path, or "-" for standard input.
+ * @param options The run options. The mode, mappedInput, ioBackend, and wordDelimiters choose how the input is read.
+ *                io_uring takes precedence over mapping, and falls back to the other options if io_uring is not
+ *                available.
+ */
+static void openWordInput(
+    struct WordInput * const inputOutPtr,
+    char const * const filePath,
+    struct HW9Options const * const options
+) {
+    inputOutPtr->file = NULL;
+    inputOutPtr->mappedFile = NULL;
+    inputOutPtr->readChars = NULL;
+    inputOutPtr->tokenizer = NULL;
+    inputOutPtr->streamFileDescriptor = -1;
+    inputOutPtr->streamTokenizer = NULL;
+
+    enum HW9Mode const mode = options->mode;
+    bool const mapped = options->mappedInput || modeRequiresMappedInput(mode) || options->wordDelimiters != NULL;
+
+    struct DelimiterSet wordDelimiters;
+    struct DelimiterSet const *wordDelimitersPtr = NULL;
+    if (options->wordDelimiters != NULL) {
+        DelimiterSet_init(&wordDelimiters, options->wordDelimiters, strlen(options->wordDelimiters));
+        wordDelimitersPtr = &wordDelimiters;
+    }
+
+    int const streamFileDescriptor = openStreamInput(filePath);
+    if (streamFileDescriptor != -1) {
+        inputOutPtr->streamFileDescriptor = streamFileDescriptor;
+        if (modeRequiresMappedInput(mode)) {
+            size_t readLength;
+            inputOutPtr->readChars = readAllFileDescriptor(streamFileDescriptor, filePath, &readLength);
+            inputOutPtr->tokenizer = createInputTokenizer(inputOutPtr->readChars, readLength, wordDelimitersPtr);
+        } else if (mode == HW9Mode_NoMutex) {
+            inputOutPtr->file = fdopen(streamFileDescriptor, "r");
+            guardFmt(inputOutPtr->file != NULL, "hw9 openWordInput: Failed to open \"%s\" using fdopen", filePath);
+            inputOutPtr->streamFileDescriptor = -1;
+        } else if (wordDelimitersPtr != NULL) {
+            inputOutPtr->streamTokenizer = StreamTokenizer_createWords(
+                streamFileDescriptor,
+                streamInputWindowCapacity,
+                filePath,
+                wordDelimitersPtr
+            );
+        } else {
+            inputOutPtr->streamTokenizer = StreamTokenizer_create(
+                streamFileDescriptor,
+                streamInputWindowCapacity,
+                filePath
+            );
+        }
+        return;
+    }
+
+    if (options->ioBackend == HW9IoBackend_IoUring && mode != HW9Mode_NoMutex) {
+        size_t readLength;
+        inputOutPtr->readChars = ioUringReadAllFile(filePath, &readLength, "hw9 openWordInput");
+        if (inputOutPtr->readChars != NULL) {
+            inputOutPtr->tokenizer = createInputTokenizer(inputOutPtr->readChars, readLength, wordDelimitersPtr);
+            return;
+        }
+    }
+
+    if (mapped) {
+        inputOutPtr->mappedFile = MappedFile_open(filePath, "hw9 openWordInput");
+        inputOutPtr->tokenizer = createInputTokenizer(
+            MappedFile_chars(inputOutPtr->mappedFile),
+            MappedFile_length(inputOutPtr->mappedFile),
+            wordDelimitersPtr
+        );
+    } else {
+        inputOutPtr->file = safeFopen(filePath, "r", "hw9 openWordInput");
+    }
+}
+
+/**
+ * Create a tokenizer over the whole input.
+ *
+ * @param chars The input characters.
+ * @param length The number of input characters.
+ * @param wordDelimitersPtr The word delimiters, or null to split the input into lines.
+ *
+ * @returns The tokenizer. The caller is responsible for freeing this memory.
+ */
+static LineTokenizer createInputTokenizer(
+    char const * const chars,
+    size_t const length,
+    struct DelimiterSet const * const wordDelimitersPtr
+) {
+    if (wordDelimitersPtr == NULL) {
+        return LineTokenizer_create(chars, length);
+    }
+    return LineTokenizer_createWords(chars, length, wordDelimitersPtr);
+}
+
+/**
+ * Open the input file if it must be read as a stream: standard input, or anything that is not a regular file (a pipe,
+ * FIFO, or character device), which cannot be mapped or read at offsets.
+ *
+ * @param filePath The input file path, or "-" for standard input.
+ *
+ * @returns The file descriptor to stream the input from, or -1 if the input is a regular file (or cannot be opened, in
+ *          which case opening it normally reports the error).
+ */
+static int openStreamInput(char const * const filePath) {
+    if (strcmp(filePath, "-") == 0) {
+        return STDIN_FILENO;
+    }
+
+    // A FIFO is kept open rather than reopened, since reopening would wait for another writer
+    int const fileDescriptor = open(filePath, O_RDONLY);
+    if (fileDescriptor == -1) {
+        return -1;
+    }
+
+    struct stat fileStatus;
+    if (fstat(fileDescriptor, &fileStatus) == 0 && !S_ISREG(fileStatus.st_mode)) {
+        return fileDescriptor;
+    }
+
+    close(fileDescriptor);
+    return -1;
+}
+
+/**
+ * Close the input file and free the memory associated with it.
+ *
+ * @param inputPtr The input.
+ */
+static void closeWordInput(struct WordInput * const inputPtr) {
+    if (inputPtr->file != NULL) {
+        fclose(inputPtr->file);
+    }
+    if (inputPtr->tokenizer != NULL) {
+        LineTokenizer_destroy(inputPtr->tokenizer);
+    }
+    if (inputPtr->streamTokenizer != NULL) {
+        StreamTokenizer_destroy(inputPtr->streamTokenizer);
+    }
+    if (inputPtr->streamFileDescriptor != -1) {
+        close(inputPtr->streamFileDescriptor);
+    }
+    if (inputPtr->mappedFile != NULL) {
+        MappedFile_destroy(inputPtr->mappedFile);
+    }
+    free(inputPtr->readChars);
+}
+
+/**
+ * Claim the next word from the input. With a mapped input this does not allocate memory. A word from a streamed input
+ * is copied, since the window it was read into is reused by the next claim.
+ *
+ * @param inputPtr The input.
+ * @param wordArena The claiming thread's arena to copy the word into, or null to copy it to the heap (e.g. when the
+ *                  word is handed to another thread). The caller resets the arena once the word has been written.
+ * @param wordOutPtr The location to store the word. Release it with releaseWord once it has been written.
+ *
+ * @returns Whether a word was claimed, or false if the end of the input was reached.
+ */
+static bool claimWord(
+    struct WordInput * const inputPtr,
+    Arena const wordArena,
+    struct ClaimedWord * const wordOutPtr
+) {
+    if (inputPtr->tokenizer != NULL) {
+        wordOutPtr->ownedChars = NULL;
+        return LineTokenizer_next(inputPtr->tokenizer, &wordOutPtr->span);
+    }
+    if (inputPtr->streamTokenizer != NULL) {
+        struct StringSpan line;
+        if (!StreamTokenizer_next(inputPtr->streamTokenizer, &line)) {
+            return false;
+        }
+
+        char *chars;
+        if (wordArena != NULL) {
+            chars = Arena_copyChars(wordArena, line.chars, line.length);
+            wordOutPtr->ownedChars = NULL;
+        } else {
+            chars = safeMalloc(line.length + 1, "hw9 claimWord");
+            memcpy(chars, line.chars, line.length);
+            chars[line.length] = '\0';
+            wordOutPtr->ownedChars = chars;
+        }
+        wordOutPtr->span = (struct StringSpan){ .chars = chars, .length = line.length };
+        return true;
+    }
+
+    char * const line = wordArena != NULL
+        ? readFileLineIntoArena(inputPtr->file, wordArena)
+        : readFileLine(inputPtr->file);
+    if (line == NULL) {
+        return false;
+    }
+
+    wordOutPtr->ownedChars = wordArena != NULL ? NULL : line;
+    wordOutPtr->span = (struct StringSpan){ .chars = line, .length = strlen(line) };
+    return true;
+}
+
+/**
+ * Free any memory held by a claimed word.
+ *
+ * @param wordPtr The word.
+ */
+static void releaseWord(struct ClaimedWord * const wordPtr) {
+    free(wordPtr->ownedChars);
+    wordPtr->ownedChars = NULL;
+}
@@ -0,0 +1,230 @@
+#include "../../include/util/Arena.h"
+
+#include "../../include/util/memory.h"
+#include "../../include/util/guard.h"
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdalign.h>
+#include <string.h>
+#include <sys/mman.h>
+
+/**
+ * A block of arena memory. Blocks stay chained after a reset so that they are reused rather than freed and allocated
+ * again.
+ */
+struct ArenaBlock {
+    struct ArenaBlock *next;
+    size_t capacity;
+    alignas(max_align_t) unsigned char bytes[];
+};
+
+/**
+ * A bump allocator: each allocation takes the next bytes of the current block, and all of them are freed at once by
+ * resetting the arena to its first block. An arena is not thread-safe; give each thread its own, so that allocating
+ * takes no lock and never contends with other threads in malloc.
+ */
+struct Arena {
+    size_t blockCapacity;
+    bool hugePages;
+
+    struct ArenaBlock *firstBlock;
+    struct ArenaBlock *currentBlock;
+    /** The offset in currentBlock of the next free byte. */
+    size_t currentOffset;
+    /** The offset in currentBlock of the most recent allocation, which Arena_grow can extend in place. */
+    size_t lastAllocationOffset;
+};
+
+static struct ArenaBlock *Arena_createBlock(Arena arena, size_t minCapacity);
+
+/** The size of a transparent huge page on x86-64. Huge-page arena blocks are a whole number of these. */
+static size_t const hugePageSize = (size_t)2 * 1024 * 1024;
+
+/**
+ * Create an Arena.
+ *
+ * @param blockCapacity The number of bytes in each block the arena allocates from. Must be positive. A single
+ *                      allocation larger than this gets a block of its own size.
+ * @param hugePages Whether to back the blocks with transparent huge pages, which cuts TLB misses for large arenas. Each
+ *                  block is rounded up to a whole number of 2 MiB pages. This is only a hint: if the kernel does not
+ *                  support transparent huge pages, the blocks use normal pages.
+ *
+ * @returns The newly allocated Arena. The caller is responsible for freeing this memory.
+ */
+Arena Arena_create(size_t const blockCapacity, bool const hugePages) {
+    guard(blockCapacity > 0, "Arena_create: blockCapacity must be positive");
+
+    Arena const arena = safeMalloc(sizeof *arena, "Arena_create");
+    arena->blockCapacity = blockCapacity;
+    arena->hugePages = hugePages;
+    arena->firstBlock = Arena_createBlock(arena, blockCapacity);
+    arena->firstBlock->next = NULL;
+    arena->currentBlock = arena->firstBlock;
+    arena->currentOffset = 0;
+    arena->lastAllocationOffset = 0;
+    return arena;
+}
+
+/**
+ * Free the memory associated with the Arena, including everything allocated from it.
+ *
+ * @param arena The Arena instance.
+ */
+void Arena_destroy(Arena const arena) {
+    guardNotNull(arena, "arena", "Arena_destroy");
+
+    struct ArenaBlock *block = arena->firstBlock;
+    while (block != NULL) {
+        struct ArenaBlock * const nextBlock = block->next;
+        free(block);
+        block = nextBlock;
+    }
+    free(arena);
+}
+
+/**
+ * Allocate memory from the arena, aligned for any type. The memory lasts until the arena is reset or destroyed; it is
+ * not freed individually.
+ *
+ * @param arena The Arena instance.
+ * @param size The size of the memory, in bytes.
+ *
+ * @returns The allocated memory.
+ */
+void *Arena_alloc(Arena const arena, size_t const size) {
+    return Arena_allocAligned(arena, size, alignof(max_align_t));
+}
+
+/**
+ * Allocate memory from the arena with the given alignment. The memory lasts until the arena is reset or destroyed; it
+ * is not freed individually.
+ *
+ * @param arena The Arena instance.
+ * @param size The size of the memory, in bytes.
+ * @param alignment The alignment of the memory, in bytes. Must be a power of two no greater than alignof(max_align_t).
+ *
+ * @returns The allocated memory.
+ */
+void *Arena_allocAligned(Arena const arena, size_t const size, size_t const alignment) {
+    guardNotNull(arena, "arena", "Arena_allocAligned");
+    guardFmt(
+        alignment > 0 && (alignment & (alignment - 1)) == 0 && alignment <= alignof(max_align_t),
+        "Arena_allocAligned: Cannot align to %zu (alignment must be a power of two no greater than %zu)",
+        alignment,
+        alignof(max_align_t)
+    );
+
+    while (true) {
+        struct ArenaBlock * const block = arena->currentBlock;
+        size_t const offset = (arena->currentOffset + alignment - 1) & ~(alignment - 1);
+        if (offset <= block->capacity && size <= block->capacity - offset) {
+            arena->currentOffset = offset + size;
+            arena->lastAllocationOffset = offset;
+            return &block->bytes[offset];
+        }
+
+        // Move on to the next block, inserting a new one if it is missing or too small for this allocation
+        if (block->next == NULL || block->next->capacity < size) {
+            struct ArenaBlock * const newBlock = Arena_createBlock(arena, size);
+            newBlock->next = block->next;
+            block->next = newBlock;
+        }
+        arena->currentBlock = block->next;
+        arena->currentOffset = 0;
+    }
+}
+
+/**
+ * Resize the arena's most recent allocation. It grows in place while its block has room; otherwise it is copied to new
+ * memory aligned for any type, and the old memory is left unused until the arena is reset.
+ *
+ * @param arena The Arena instance.
+ * @param memory The memory to resize, or null to allocate new memory.
+ * @param oldSize The current size of the memory, in bytes.
+ * @param newSize The new size of the memory, in bytes.
+ *
+ * @returns The resized memory, which may have moved.
+ */
+void *Arena_grow(Arena const arena, void * const memory, size_t const oldSize, size_t const newSize) {
+    guardNotNull(arena, "arena", "Arena_grow");
+
+    if (memory == NULL) {
+        return Arena_alloc(arena, newSize);
+    }
+
+    struct ArenaBlock * const block = arena->currentBlock;
+    if (
+        memory == &block->bytes[arena->lastAllocationOffset]
+        && newSize <= block->capacity - arena->lastAllocationOffset
+    ) {
+        arena->currentOffset = arena->lastAllocationOffset + newSize;
+        return memory;
+    }
+
+    void * const newMemory = Arena_alloc(arena, newSize);
+    memcpy(newMemory, memory, oldSize < newSize ? oldSize : newSize);
+    return newMemory;
+}
+
+/**
+ * Copy characters into the arena as a null-terminated string.
+ *
+ * @param arena The Arena instance.
+ * @param chars The characters to copy.
+ * @param length The number of characters.
+ *
+ * @returns The copy. It lasts until the arena is reset or destroyed.
+ */
+char *Arena_copyChars(Arena const arena, char const * const chars, size_t const length) {
+    guard(length == 0 || chars != NULL, "Arena_copyChars: chars must not be null");
+
+    char * const copy = Arena_allocAligned(arena, length + 1, 1);
+    if (length > 0) {
+        memcpy(copy, chars, length);
+    }
+    copy[length] = '\0';
+    return copy;
+}
+
+/**
+ * Free everything allocated from the arena at once, in constant time. The arena keeps its blocks and allocates from
+ * them again.
+ *
+ * @param arena The Arena instance.
+ */
+void Arena_reset(Arena const arena) {
+    guardNotNull(arena, "arena", "Arena_reset");
+
+    arena->currentBlock = arena->firstBlock;
+    arena->currentOffset = 0;
+    arena->lastAllocationOffset = 0;
+}
+
+/**
+ * Allocate a block for the arena. The caller links it into the chain.
+ *
+ * @param arena The Arena instance.
+ * @param minCapacity The fewest bytes the block must hold.
+ *
+ * @returns The block.
+ */
+static struct ArenaBlock *Arena_createBlock(Arena const arena, size_t const minCapacity) {
+    size_t const capacity = minCapacity > arena->blockCapacity ? minCapacity : arena->blockCapacity;
+    size_t size = sizeof(struct ArenaBlock) + capacity;
+
+    struct ArenaBlock *block;
+    if (arena->hugePages) {
+        size = (size + hugePageSize - 1) / hugePageSize * hugePageSize;
+        block = safeAlignedAlloc(hugePageSize, size, "Arena_createBlock");
+        // Only a hint, so a kernel without transparent huge pages (EINVAL) is not an error
+        madvise(block, size, MADV_HUGEPAGE);
+    } else {
+        block = safeMalloc(size, "Arena_createBlock");
+    }
+
+    block->next = NULL;
+    block->capacity = size - sizeof(struct ArenaBlock);
+    return block;
+}
@@ -0,0 +1,345 @@
+#define _GNU_SOURCE
+
+#include "../../include/util/AsyncWriter.h"
+
+#include "../../include/util/memory.h"
+#include "../../include/util/thread.h"
+#include "../../include/util/string.h"
+#include "../../include/util/guard.h"
+#include "../../include/util/error.h"
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <stdio.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <pthread.h>
+
+/**
+ * Writes a file through two in-memory buffers. Writers copy into the active buffer; when it fills, it is swapped with
+ * the flush buffer, which a background thread writes to the file while writers continue filling the other one. Writers
+ * only wait for the disk when both buffers are full.
+ */
+struct AsyncWriter {
+    int fileDescriptor;
+    char *filePath;
+    /** Whether the file is a regular file. Only those are fsynced, since pipes and devices have nothing to sync. */
+    bool isRegularFile;
+    pthread_t flusherThreadId;
+
+    pthread_mutex_t mutex;
+    pthread_cond_t flushRequestedCondition;
+    pthread_cond_t flushDoneCondition;
+
+    size_t bufferCapacity;
+    char *activeChars;
+    size_t activeLength;
+    /** The buffer being written by the flusher thread. flushLength is 0 when the flusher is idle. */
+    char *flushChars;
+    size_t flushLength;
+    bool closing;
+};
+
+static void AsyncWriter_swapBuffers(AsyncWriter writer);
+static void *AsyncWriter_flusherThreadStart(void *writerAsVoidPtr);
+static void AsyncWriter_writeAll(ConstAsyncWriter writer, char const *chars, size_t length);
+
+static ssize_t AsyncWriter_streamWrite(void *writerAsVoidPtr, char const *chars, size_t length);
+static int AsyncWriter_streamClose(void *writerAsVoidPtr);
+
+/**
+ * Open a file for writing (truncating it) and start the thread that flushes its buffers. If the operation fails, abort
+ * the program with an error message.
+ *
+ * @param filePath The file path.
+ * @param bufferCapacity The size of each of the two buffers. Must be positive.
+ * @param callerDescription A description of the caller to be included in the error message. This could be the name of
+ *                          the calling function, plus extra information if useful.
+ *
+ * @returns The newly allocated AsyncWriter. The caller is responsible for closing it with AsyncWriter_close.
+ */
+AsyncWriter AsyncWriter_open(
+    char const * const filePath,
+    size_t const bufferCapacity,
+    char const * const callerDescription
+) {
+    guardNotNull(filePath, "filePath", "AsyncWriter_open");
+    guardNotNull(callerDescription, "callerDescription", "AsyncWriter_open");
+    guard(bufferCapacity > 0, "AsyncWriter_open: bufferCapacity must be positive");
+
+    int const fileDescriptor = open(filePath, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+    if (fileDescriptor == -1) {
+        int const openErrorCode = errno;
+        char const * const openErrorMessage = strerror(openErrorCode);
+
+        abortWithErrorFmt(
+            "%s: Failed to open file \"%s\" using open (error code: %d; error message: \"%s\")",
+            callerDescription,
+            filePath,
+            openErrorCode,
+            openErrorMessage
+        );
+        return NULL;
+    }
+    struct stat fileStat;
+    if (fstat(fileDescriptor, &fileStat) != 0) {
+        int const fstatErrorCode = errno;
+        char const * const fstatErrorMessage = strerror(fstatErrorCode);
+
+        abortWithErrorFmt(
+            "%s: Failed to get the type of file \"%s\" using fstat (error code: %d; error message: \"%s\")",
+            callerDescription,
+            filePath,
+            fstatErrorCode,
+            fstatErrorMessage
+        );
+        return NULL;
+    }
+
+    AsyncWriter const writer = safeMalloc(sizeof *writer, "AsyncWriter_open");
+    writer->fileDescriptor = fileDescriptor;
+    writer->filePath = formatString("%s", filePath);
+    writer->isRegularFile = S_ISREG(fileStat.st_mode);
+
+    safeMutexInit(&writer->mutex, NULL, "AsyncWriter_open");
+    safeConditionInit(&writer->flushRequestedCondition, NULL, "AsyncWriter_open");
+    safeConditionInit(&writer->flushDoneCondition, NULL, "AsyncWriter_open");
+
+    writer->bufferCapacity = bufferCapacity;
+    writer->activeChars = safeMalloc(bufferCapacity, "AsyncWriter_open");
+    writer->activeLength = 0;
+    writer->flushChars = safeMalloc(bufferCapacity, "AsyncWriter_open");
+    writer->flushLength = 0;
+    writer->closing = false;
+
+    writer->flusherThreadId = safePthreadCreate(NULL, AsyncWriter_flusherThreadStart, writer, "AsyncWriter_open");
+    return writer;
+}
+
+/**
+ * Flush everything written so far, wait until it is durably stored (fsync) if the file is a regular file, then close
+ * the file, stop the flusher thread, and free the memory associated with the AsyncWriter. If the operation fails, abort
+ * the program with an error message.
+ *
+ * @param writer The AsyncWriter instance.
+ */
+void AsyncWriter_close(AsyncWriter const writer) {
+    guardNotNull(writer, "writer", "AsyncWriter_close");
+
+    safeMutexLock(&writer->mutex, "AsyncWriter_close");
+    if (writer->activeLength > 0) {
+        AsyncWriter_swapBuffers(writer);
+    }
+    writer->closing = true;
+    safeConditionSignal(&writer->flushRequestedCondition, "AsyncWriter_close");
+    safeMutexUnlock(&writer->mutex, "AsyncWriter_close");
+
+    safePthreadJoin(writer->flusherThreadId, "AsyncWriter_close");
+
+    if (writer->isRegularFile && fsync(writer->fileDescriptor) != 0) {
+        int const fsyncErrorCode = errno;
+        char const * const fsyncErrorMessage = strerror(fsyncErrorCode);
+
+        abortWithErrorFmt(
+            "AsyncWriter_close: Failed to flush file \"%s\" to disk using fsync"
+            " (error code: %d; error message: \"%s\")",
+            writer->filePath,
+            fsyncErrorCode,
+            fsyncErrorMessage
+        );
+        return;
+    }
+    if (close(writer->fileDescriptor) != 0) {
+        int const closeErrorCode = errno;
+        char const * const closeErrorMessage = strerror(closeErrorCode);
+
+        abortWithErrorFmt(
+            "AsyncWriter_close: Failed to close file \"%s\" using close (error code: %d; error message: \"%s\")",
+            writer->filePath,
+            closeErrorCode,
+            closeErrorMessage
+        );
+        return;
+    }
+
+    safeConditionDestroy(&writer->flushDoneCondition, "AsyncWriter_close");
+    safeConditionDestroy(&writer->flushRequestedCondition, "AsyncWriter_close");
+    safeMutexDestroy(&writer->mutex, "AsyncWriter_close");
+    free(writer->activeChars);
+    free(writer->flushChars);
+    free(writer->filePath);
+    free(writer);
+}
+
+/**
+ * Append characters to the file. They are copied into the active buffer, and only written to the file once that fills
+ * or the writer is closed. Safe to call from multiple threads; each call's characters are kept together.
+ *
+ * @param writer The AsyncWriter instance.
+ * @param chars The characters.
+ * @param length The number of characters.
+ */
+void AsyncWriter_write(AsyncWriter const writer, char const * const chars, size_t const length) {
+    guardNotNull(writer, "writer", "AsyncWriter_write");
+    guardNotNull(chars, "chars", "AsyncWriter_write");
+
+    safeMutexLock(&writer->mutex, "AsyncWriter_write");
+
+    size_t writtenLength = 0;
+    while (writtenLength < length) {
+        if (writer->activeLength == writer->bufferCapacity) {
+            AsyncWriter_swapBuffers(writer);
+        }
+
+        size_t const spaceLength = writer->bufferCapacity - writer->activeLength;
+        size_t const copyLength = length - writtenLength < spaceLength ? length - writtenLength : spaceLength;
+        memcpy(writer->activeChars + writer->activeLength, chars + writtenLength, copyLength);
+        writer->activeLength += copyLength;
+        writtenLength += copyLength;
+    }
+
+    safeMutexUnlock(&writer->mutex, "AsyncWriter_write");
+}
+
+/**
+ * Open a file for writing as a stdio stream backed by an AsyncWriter. The stream itself is unbuffered, so each stdio
+ * call is copied straight into the AsyncWriter's active buffer. Closing the stream closes the AsyncWriter, including
+ * its fsync. If the operation fails, abort the program with an error message.
+ *
+ * @param filePath The file path.
+ * @param bufferCapacity The size of each of the AsyncWriter's two buffers. Must be positive.
+ * @param callerDescription A description of the caller to be included in the error message. This could be the name of
+ *                          the calling function, plus extra information if useful.
+ *
+ * @returns The stream. The caller is responsible for closing it with fclose.
+ */
+FILE *AsyncWriter_openStream(
+    char const * const filePath,
+    size_t const bufferCapacity,
+    char const * const callerDescription
+) {
+    AsyncWriter const writer = AsyncWriter_open(filePath, bufferCapacity, callerDescription);
+
+    FILE * const file = fopencookie(writer, "w", (cookie_io_functions_t){
+        .read = NULL,
+        .write = AsyncWriter_streamWrite,
+        .seek = NULL,
+        .close = AsyncWriter_streamClose
+    });
+    if (file == NULL) {
+        int const fopencookieErrorCode = errno;
+        char const * const fopencookieErrorMessage = strerror(fopencookieErrorCode);
+
+        abortWithErrorFmt(
+            "%s: Failed to open stream for file \"%s\" using fopencookie (error code: %d; error message: \"%s\")",
+            callerDescription,
+            filePath,
+            fopencookieErrorCode,
+            fopencookieErrorMessage
+        );
+        return NULL;
+    }
+
+    setvbuf(file, NULL, _IONBF, 0);
+    return file;
+}
+
+/**
+ * Hand the active buffer to the flusher thread, first waiting for it to finish the previous one. The mutex must be
+ * held.
+ *
+ * @param writer The AsyncWriter instance.
+ */
+static void AsyncWriter_swapBuffers(AsyncWriter const writer) {
+    while (writer->flushLength > 0) {
+        safeConditionWait(&writer->flushDoneCondition, &writer->mutex, "AsyncWriter_swapBuffers");
+    }
+
+    char * const flushChars = writer->flushChars;
+    writer->flushChars = writer->activeChars;
+    writer->flushLength = writer->activeLength;
+    writer->activeChars = flushChars;
+    writer->activeLength = 0;
+
+    safeConditionSignal(&writer->flushRequestedCondition, "AsyncWriter_swapBuffers");
+}
+
+/**
+ * Write each buffer handed over by AsyncWriter_swapBuffers to the file, until the writer is closing and nothing is left
+ * to write.
+ */
+static void *AsyncWriter_flusherThreadStart(void * const writerAsVoidPtr) {
+    AsyncWriter const writer = writerAsVoidPtr;
+
+    safeMutexLock(&writer->mutex, "AsyncWriter_flusherThreadStart");
+    while (true) {
+        while (writer->flushLength == 0 && !writer->closing) {
+            safeConditionWait(&writer->flushRequestedCondition, &writer->mutex, "AsyncWriter_flusherThreadStart");
+        }
+        if (writer->flushLength == 0) {
+            break;
+        }
+
+        // Writers may keep filling the active buffer while this one is written
+        safeMutexUnlock(&writer->mutex, "AsyncWriter_flusherThreadStart");
+        AsyncWriter_writeAll(writer, writer->flushChars, writer->flushLength);
+        safeMutexLock(&writer->mutex, "AsyncWriter_flusherThreadStart");
+
+        writer->flushLength = 0;
+        safeConditionBroadcast(&writer->flushDoneCondition, "AsyncWriter_flusherThreadStart");
+    }
+    safeMutexUnlock(&writer->mutex, "AsyncWriter_flusherThreadStart");
+
+    return NULL;
+}
+
+/**
+ * Write all of the given characters to the file, continuing after short writes. If the operation fails, abort the
+ * program with an error message.
+ *
+ * @param writer The AsyncWriter instance.
+ * @param chars The characters.
+ * @param length The number of characters.
+ */
+static void AsyncWriter_writeAll(ConstAsyncWriter const writer, char const * const chars, size_t const length) {
+    size_t writtenLength = 0;
+    while (writtenLength < length) {
+        ssize_t const writeResult = write(writer->fileDescriptor, chars + writtenLength, length - writtenLength);
+        if (writeResult < 0) {
+            int const writeErrorCode = errno;
+            if (writeErrorCode == EINTR) {
+                continue;
+            }
+
+            char const * const writeErrorMessage = strerror(writeErrorCode);
+            abortWithErrorFmt(
+                "AsyncWriter_writeAll: Failed to write file \"%s\" using write (error code: %d; error message: \"%s\")",
+                writer->filePath,
+                writeErrorCode,
+                writeErrorMessage
+            );
+            return;
+        }
+
+        writtenLength += (size_t)writeResult;
+    }
+}
+
+/**
+ * The stdio write function of a stream opened with AsyncWriter_openStream.
+ */
+static ssize_t AsyncWriter_streamWrite(void * const writerAsVoidPtr, char const * const chars, size_t const length) {
+    AsyncWriter_write(writerAsVoidPtr, chars, length);
+    return (ssize_t)length;
+}
+
+/**
+ * The stdio close function of a stream opened with AsyncWriter_openStream.
+ */
+static int AsyncWriter_streamClose(void * const writerAsVoidPtr) {
+    AsyncWriter_close(writerAsVoidPtr);
+    return 0;
+}
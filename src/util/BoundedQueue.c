@@ -0,0 +1,133 @@
+#include "../../include/util/BoundedQueue.h"
+
+#include "../../include/util/memory.h"
+#include "../../include/util/thread.h"
+#include "../../include/util/guard.h"
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <pthread.h>
+
+/**
+ * A fixed-capacity FIFO ring of items shared between producer and consumer threads. Pushing blocks while the ring is
+ * full and popping blocks while it is empty, so a slow consumer holds back its producers instead of letting the queue
+ * grow without bound.
+ */
+struct BoundedQueue {
+    pthread_mutex_t mutex;
+    pthread_cond_t notEmptyCondition;
+    pthread_cond_t notFullCondition;
+
+    void **items;
+    size_t capacity;
+    size_t headIndex;
+    size_t count;
+    bool closed;
+};
+
+/**
+ * Create an empty, open BoundedQueue.
+ *
+ * @param capacity The most items the queue can hold. Must be positive.
+ *
+ * @returns The newly allocated BoundedQueue. The caller is responsible for freeing this memory.
+ */
+BoundedQueue BoundedQueue_create(size_t const capacity) {
+    guard(capacity > 0, "BoundedQueue_create: capacity must be positive");
+
+    BoundedQueue const queue = safeMalloc(sizeof *queue, "BoundedQueue_create");
+    safeMutexInit(&queue->mutex, NULL, "BoundedQueue_create");
+    safeConditionInit(&queue->notEmptyCondition, NULL, "BoundedQueue_create");
+    safeConditionInit(&queue->notFullCondition, NULL, "BoundedQueue_create");
+
+    queue->items = safeMalloc(sizeof *queue->items * capacity, "BoundedQueue_create");
+    queue->capacity = capacity;
+    queue->headIndex = 0;
+    queue->count = 0;
+    queue->closed = false;
+    return queue;
+}
+
+/**
+ * Free the memory associated with the BoundedQueue. This does not free any items remaining in the queue.
+ *
+ * @param queue The BoundedQueue instance.
+ */
+void BoundedQueue_destroy(BoundedQueue const queue) {
+    guardNotNull(queue, "queue", "BoundedQueue_destroy");
+
+    safeConditionDestroy(&queue->notFullCondition, "BoundedQueue_destroy");
+    safeConditionDestroy(&queue->notEmptyCondition, "BoundedQueue_destroy");
+    safeMutexDestroy(&queue->mutex, "BoundedQueue_destroy");
+    free(queue->items);
+    free(queue);
+}
+
+/**
+ * Add an item to the back of the queue, waiting until there is room. The queue must not be closed.
+ *
+ * @param queue The BoundedQueue instance.
+ * @param item The item.
+ */
+void BoundedQueue_push(BoundedQueue const queue, void * const item) {
+    guardNotNull(queue, "queue", "BoundedQueue_push");
+
+    safeMutexLock(&queue->mutex, "BoundedQueue_push");
+
+    guard(!queue->closed, "BoundedQueue_push: queue is closed");
+    while (queue->count == queue->capacity) {
+        safeConditionWait(&queue->notFullCondition, &queue->mutex, "BoundedQueue_push");
+    }
+
+    queue->items[(queue->headIndex + queue->count) % queue->capacity] = item;
+    queue->count += 1;
+
+    safeConditionSignal(&queue->notEmptyCondition, "BoundedQueue_push");
+    safeMutexUnlock(&queue->mutex, "BoundedQueue_push");
+}
+
+/**
+ * Remove the item at the front of the queue, waiting until there is one or the queue is closed.
+ *
+ * @param queue The BoundedQueue instance.
+ * @param itemOutPtr The location to store the item.
+ *
+ * @returns Whether an item was removed, or false if the queue is closed and empty.
+ */
+bool BoundedQueue_pop(BoundedQueue const queue, void ** const itemOutPtr) {
+    guardNotNull(queue, "queue", "BoundedQueue_pop");
+    guardNotNull(itemOutPtr, "itemOutPtr", "BoundedQueue_pop");
+
+    safeMutexLock(&queue->mutex, "BoundedQueue_pop");
+
+    while (queue->count == 0 && !queue->closed) {
+        safeConditionWait(&queue->notEmptyCondition, &queue->mutex, "BoundedQueue_pop");
+    }
+
+    bool const popped = queue->count > 0;
+    if (popped) {
+        *itemOutPtr = queue->items[queue->headIndex];
+        queue->headIndex = (queue->headIndex + 1) % queue->capacity;
+        queue->count -= 1;
+
+        safeConditionSignal(&queue->notFullCondition, "BoundedQueue_pop");
+    }
+
+    safeMutexUnlock(&queue->mutex, "BoundedQueue_pop");
+    return popped;
+}
+
+/**
+ * Mark the queue as closed: no more items will be pushed. Consumers drain the remaining items, after which popping
+ * returns false instead of waiting.
+ *
+ * @param queue The BoundedQueue instance.
+ */
+void BoundedQueue_close(BoundedQueue const queue) {
+    guardNotNull(queue, "queue", "BoundedQueue_close");
+
+    safeMutexLock(&queue->mutex, "BoundedQueue_close");
+    queue->closed = true;
+    safeConditionBroadcast(&queue->notEmptyCondition, "BoundedQueue_close");
+    safeMutexUnlock(&queue->mutex, "BoundedQueue_close");
+}
@@ -0,0 +1,827 @@
+#define _GNU_SOURCE
+
+#include "../../include/util/ColumnarOutput.h"
+
+#include "../../include/util/memory.h"
+#include "../../include/util/string.h"
+#include "../../include/util/guard.h"
+#include "../../include/util/error.h"
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <string.h>
+#include <stdio.h>
+#include <errno.h>
+#include <sys/types.h>
+
+/*
+ * The columnar output format stores the lines "word\tthread\n" column by column. All integers are little-endian.
+ *
+ *   header      "HW9C", the format version (1 byte), the word ID width in bytes (1 byte: 1, 2, or 4), the thread bit
+ *               width (1 byte: 1 to 32), a reserved zero byte, the line count (8 bytes), the dictionary word count
+ *               (4 bytes), and the thread run count (8 bytes)
+ *   dictionary  each distinct word in order of first appearance: its length as a LEB128 varint, then its characters
+ *   threads     the thread number of each run of consecutive lines written by the same thread, packed into thread bit
+ *               width bits (least significant bit first, padded to a whole byte), then the line count of each run as a
+ *               LEB128 varint
+ *   word IDs    the dictionary index of each line's word, in word ID width bytes
+ *
+ * The word IDs come last so that a reader only holds the dictionary and the runs in memory while streaming them.
+ */
+
+static char const columnarMagic[4] = {'H', 'W', '9', 'C'};
+static uint8_t const columnarVersion = 1;
+#define COLUMNAR_HEADER_LENGTH 28
+/** The maximum length of a LEB128 varint holding a uint64_t. */
+#define VARINT_MAX_LENGTH 10
+
+/** The size of the blocks the columns are encoded into and decoded from. */
+static size_t const columnarChunkLength = 64 * 1024;
+static size_t const columnarInitialSlotCount = 1024;
+
+/**
+ * Collects the lines written to a columnar output stream, then encodes them to the binary file when the stream is
+ * closed. The dictionary is an open-addressing hash table of word IDs over the concatenated word characters.
+ */
+struct ColumnarEncoder {
+    FILE *binaryFile;
+    char *callerDescription;
+
+    /** The characters of a line whose newline has not been written yet. */
+    char *pendingChars;
+    size_t pendingLength;
+    size_t pendingCapacity;
+
+    char *wordChars;
+    size_t wordCharsLength;
+    size_t wordCharsCapacity;
+    /** The start of each word in wordChars, plus the end of the last word. */
+    size_t *wordOffsets;
+    uint32_t wordCount;
+    size_t wordOffsetsCapacity;
+    /** Each slot holds a word ID plus 1, or 0 if it is empty. The slot count is a power of 2. */
+    uint32_t *slots;
+    size_t slotCount;
+
+    uint32_t *lineWordIds;
+    size_t lineCount;
+    size_t lineCapacity;
+
+    uint32_t *runThreadNumbers;
+    uint64_t *runLengths;
+    size_t runCount;
+    size_t runCapacity;
+    uint32_t maxThreadNumber;
+};
+
+/**
+ * Collects bytes into a block and writes the block to a file whenever it fills.
+ */
+struct ChunkWriter {
+    FILE *file;
+    uint8_t *bytes;
+    size_t length;
+    char const *callerDescription;
+};
+
+static void ColumnarEncoder_addLine(struct ColumnarEncoder *encoderPtr, char const *chars, size_t length);
+static uint32_t ColumnarEncoder_internWord(struct ColumnarEncoder *encoderPtr, char const *chars, size_t length);
+static void ColumnarEncoder_growSlots(struct ColumnarEncoder *encoderPtr);
+static void ColumnarEncoder_addThreadNumber(struct ColumnarEncoder *encoderPtr, uint32_t threadNumber);
+static void ColumnarEncoder_writeFile(struct ColumnarEncoder const *encoderPtr);
+static void ColumnarEncoder_destroy(struct ColumnarEncoder *encoderPtr);
+
+static ssize_t ColumnarEncoder_streamWrite(void *encoderAsVoidPtr, char const *chars, size_t length);
+static int ColumnarEncoder_streamClose(void *encoderAsVoidPtr);
+
+static void ChunkWriter_init(struct ChunkWriter *writerOutPtr, FILE *file, char const *callerDescription);
+static uint8_t *ChunkWriter_reserve(struct ChunkWriter *writerPtr, size_t length);
+static void ChunkWriter_destroy(struct ChunkWriter *writerPtr);
+
+static uint64_t hashWord(char const *chars, size_t length);
+static uint8_t wordIdWidthFor(uint32_t wordCount);
+static uint8_t bitWidthFor(uint32_t value);
+static void storeUintLE(uint8_t *bytes, uint64_t value, size_t byteCount);
+static uint64_t loadUintLE(uint8_t const *bytes, size_t byteCount);
+static size_t storeVarint(uint8_t *bytes, uint64_t value);
+static uint64_t readVarint(FILE *file, char const *callerDescription);
+static void writeBytes(FILE *file, void const *bytes, size_t length, char const *callerDescription);
+static void readBytes(FILE *file, void *bytes, size_t length, char const *callerDescription);
+
+/**
+ * Open a stream which accepts the text output lines ("word\tthread\n") and, when closed, writes them to the given file
+ * in the columnar output format: a dictionary of distinct words, one fixed-width word ID per line, and the thread
+ * numbers as bit-packed runs. The lines are held in memory until the stream is closed. A malformed line aborts the
+ * program with an error message.
+ *
+ * @param binaryFile The file to write the columnar output to. The stream takes ownership of it, closing it when the
+ *                   stream is closed.
+ * @param callerDescription A description of the caller to be included in error messages. This could be the name of
+ *                          the calling function, plus extra information if useful.
+ *
+ * @returns The stream. The caller is responsible for closing it with fclose.
+ */
+FILE *ColumnarOutput_openStream(FILE * const binaryFile, char const * const callerDescription) {
+    guardNotNull(binaryFile, "binaryFile", "ColumnarOutput_openStream");
+    guardNotNull(callerDescription, "callerDescription", "ColumnarOutput_openStream");
+
+    struct ColumnarEncoder * const encoderPtr = safeMalloc(sizeof *encoderPtr, "ColumnarOutput_openStream");
+    encoderPtr->binaryFile = binaryFile;
+    encoderPtr->callerDescription = formatString("%s", callerDescription);
+
+    encoderPtr->pendingChars = NULL;
+    encoderPtr->pendingLength = 0;
+    encoderPtr->pendingCapacity = 0;
+
+    encoderPtr->wordChars = NULL;
+    encoderPtr->wordCharsLength = 0;
+    encoderPtr->wordCharsCapacity = 0;
+    encoderPtr->wordOffsetsCapacity = 64;
+    encoderPtr->wordOffsets = safeMalloc(
+        encoderPtr->wordOffsetsCapacity * sizeof *encoderPtr->wordOffsets,
+        "ColumnarOutput_openStream"
+    );
+    encoderPtr->wordOffsets[0] = 0;
+    encoderPtr->wordCount = 0;
+    encoderPtr->slotCount = columnarInitialSlotCount;
+    encoderPtr->slots = calloc(encoderPtr->slotCount, sizeof *encoderPtr->slots);
+    guard(encoderPtr->slots != NULL, "ColumnarOutput_openStream: Failed to allocate the dictionary slots");
+
+    encoderPtr->lineWordIds = NULL;
+    encoderPtr->lineCount = 0;
+    encoderPtr->lineCapacity = 0;
+
+    encoderPtr->runThreadNumbers = NULL;
+    encoderPtr->runLengths = NULL;
+    encoderPtr->runCount = 0;
+    encoderPtr->runCapacity = 0;
+    encoderPtr->maxThreadNumber = 0;
+
+    FILE * const file = fopencookie(encoderPtr, "w", (cookie_io_functions_t){
+        .read = NULL,
+        .write = ColumnarEncoder_streamWrite,
+        .seek = NULL,
+        .close = ColumnarEncoder_streamClose
+    });
+    if (file == NULL) {
+        int const fopencookieErrorCode = errno;
+        char const * const fopencookieErrorMessage = strerror(fopencookieErrorCode);
+
+        abortWithErrorFmt(
+            "%s: Failed to open columnar output stream using fopencookie (error code: %d; error message: \"%s\")",
+            callerDescription,
+            fopencookieErrorCode,
+            fopencookieErrorMessage
+        );
+        return NULL;
+    }
+
+    return file;
+}
+
+/**
+ * Convert a file in the columnar output format back to the text output lines ("word\tthread\n"). If the file is not
+ * valid columnar output or the operation fails, abort the program with an error message.
+ *
+ * @param binaryFile The columnar output to read, positioned at its start.
+ * @param textFile Where to write the text lines.
+ * @param callerDescription A description of the caller to be included in error messages. This could be the name of
+ *                          the calling function, plus extra information if useful.
+ */
+void ColumnarOutput_writeText(FILE * const binaryFile, FILE * const textFile, char const * const callerDescription) {
+    guardNotNull(binaryFile, "binaryFile", "ColumnarOutput_writeText");
+    guardNotNull(textFile, "textFile", "ColumnarOutput_writeText");
+    guardNotNull(callerDescription, "callerDescription", "ColumnarOutput_writeText");
+
+    uint8_t header[COLUMNAR_HEADER_LENGTH];
+    readBytes(binaryFile, header, sizeof header, callerDescription);
+    if (memcmp(header, columnarMagic, sizeof columnarMagic) != 0) {
+        abortWithErrorFmt("%s: Not a columnar output file (missing \"HW9C\" header)", callerDescription);
+        return;
+    }
+    if (header[4] != columnarVersion) {
+        abortWithErrorFmt("%s: Unsupported columnar output version %u", callerDescription, (unsigned int)header[4]);
+        return;
+    }
+    size_t const wordIdWidth = header[5];
+    unsigned int const threadBitWidth = header[6];
+    uint64_t const lineCount = loadUintLE(header + 8, 8);
+    uint64_t const wordCount = loadUintLE(header + 16, 4);
+    uint64_t const runCount = loadUintLE(header + 20, 8);
+    if (
+        (wordIdWidth != 1 && wordIdWidth != 2 && wordIdWidth != 4)
+        || threadBitWidth < 1
+        || threadBitWidth > 32
+        || runCount > lineCount
+        || lineCount > SIZE_MAX / 16
+    ) {
+        abortWithErrorFmt("%s: Invalid columnar output header", callerDescription);
+        return;
+    }
+
+    // The dictionary, as the concatenated words plus the start of each
+    size_t * const wordOffsets = safeMalloc(((size_t)wordCount + 1) * sizeof *wordOffsets, "ColumnarOutput_writeText");
+    size_t wordCharsCapacity = 64 * 1024;
+    char *wordChars = safeMalloc(wordCharsCapacity, "ColumnarOutput_writeText");
+    wordOffsets[0] = 0;
+    for (size_t i = 0; i < wordCount; i += 1) {
+        uint64_t const wordLength = readVarint(binaryFile, callerDescription);
+        if (wordLength > SIZE_MAX / 4) {
+            abortWithErrorFmt("%s: Invalid columnar output word length %" PRIu64, callerDescription, wordLength);
+            return;
+        }
+        size_t const wordCharsLength = wordOffsets[i] + (size_t)wordLength;
+        while (wordCharsLength > wordCharsCapacity) {
+            wordCharsCapacity *= 2;
+            wordChars = safeRealloc(wordChars, wordCharsCapacity, "ColumnarOutput_writeText");
+        }
+        readBytes(binaryFile, wordChars + wordOffsets[i], (size_t)wordLength, callerDescription);
+        wordOffsets[i + 1] = wordCharsLength;
+    }
+
+    // The thread runs
+    size_t const packedLength = (size_t)((runCount * threadBitWidth + 7) / 8);
+    uint8_t * const packedThreadNumbers = safeMalloc(packedLength + 1, "ColumnarOutput_writeText");
+    readBytes(binaryFile, packedThreadNumbers, packedLength, callerDescription);
+    uint32_t * const runThreadNumbers = safeMalloc(
+        ((size_t)runCount + 1) * sizeof *runThreadNumbers,
+        "ColumnarOutput_writeText"
+    );
+    uint64_t const threadNumberMask = (UINT64_C(1) << threadBitWidth) - 1;
+    uint64_t bitBuffer = 0;
+    unsigned int bitCount = 0;
+    size_t packedIndex = 0;
+    for (size_t i = 0; i < runCount; i += 1) {
+        while (bitCount < threadBitWidth) {
+            bitBuffer |= (uint64_t)packedThreadNumbers[packedIndex] << bitCount;
+            packedIndex += 1;
+            bitCount += 8;
+        }
+        runThreadNumbers[i] = (uint32_t)(bitBuffer & threadNumberMask);
+        bitBuffer >>= threadBitWidth;
+        bitCount -= threadBitWidth;
+    }
+    uint64_t * const runLengths = safeMalloc(((size_t)runCount + 1) * sizeof *runLengths, "ColumnarOutput_writeText");
+    uint64_t runLineCount = 0;
+    for (size_t i = 0; i < runCount; i += 1) {
+        runLengths[i] = readVarint(binaryFile, callerDescription);
+        runLineCount += runLengths[i];
+    }
+    if (runLineCount != lineCount) {
+        abortWithErrorFmt("%s: Columnar output thread runs do not cover every line", callerDescription);
+        return;
+    }
+
+    // The word IDs, streamed a block at a time alongside the runs
+    size_t const chunkLineCount = columnarChunkLength / wordIdWidth;
+    uint8_t * const wordIdBytes = safeMalloc(chunkLineCount * wordIdWidth, "ColumnarOutput_writeText");
+    size_t chunkLineIndex = 0;
+    size_t chunkLineEnd = 0;
+    uint64_t unreadLineCount = lineCount;
+    for (size_t runIndex = 0; runIndex < runCount; runIndex += 1) {
+        char threadText[16];
+        size_t const threadTextLength = safeSnprintf(
+            threadText,
+            sizeof threadText,
+            "ColumnarOutput_writeText",
+            "\t%" PRIu32 "\n",
+            runThreadNumbers[runIndex]
+        );
+
+        for (uint64_t i = 0; i < runLengths[runIndex]; i += 1) {
+            if (chunkLineIndex == chunkLineEnd) {
+                chunkLineEnd = unreadLineCount < chunkLineCount ? (size_t)unreadLineCount : chunkLineCount;
+                readBytes(binaryFile, wordIdBytes, chunkLineEnd * wordIdWidth, callerDescription);
+                unreadLineCount -= chunkLineEnd;
+                chunkLineIndex = 0;
+            }
+            uint64_t const wordId = loadUintLE(wordIdBytes + chunkLineIndex * wordIdWidth, wordIdWidth);
+            chunkLineIndex += 1;
+            if (wordId >= wordCount) {
+                abortWithErrorFmt("%s: Invalid columnar output word ID %" PRIu64, callerDescription, wordId);
+                return;
+            }
+
+            size_t const wordStart = wordOffsets[wordId];
+            writeBytes(textFile, wordChars + wordStart, wordOffsets[wordId + 1] - wordStart, callerDescription);
+            writeBytes(textFile, threadText, threadTextLength, callerDescription);
+        }
+    }
+
+    free(wordIdBytes);
+    free(runLengths);
+    free(runThreadNumbers);
+    free(packedThreadNumbers);
+    free(wordChars);
+    free(wordOffsets);
+}
+
+/**
+ * Record one text output line.
+ *
+ * @param encoderPtr The encoder.
+ * @param chars The line, without its newline.
+ * @param length The length of the line.
+ */
+static void ColumnarEncoder_addLine(
+    struct ColumnarEncoder * const encoderPtr,
+    char const * const chars,
+    size_t const length
+) {
+    char const * const tab = memrchr(chars, '\t', length);
+    if (tab == NULL || tab + 1 == chars + length) {
+        abortWithErrorFmt(
+            "%s: Invalid output line \"%.*s\" for the columnar format (expected \"word<tab>thread\")",
+            encoderPtr->callerDescription,
+            (int)(length < 200 ? length : 200),
+            chars
+        );
+        return;
+    }
+
+    uint64_t threadNumber = 0;
+    for (char const *c = tab + 1; c < chars + length; c += 1) {
+        if (*c < '0' || *c > '9' || threadNumber > UINT32_MAX / 10) {
+            abortWithErrorFmt(
+                "%s: Invalid thread number in output line \"%.*s\" for the columnar format",
+                encoderPtr->callerDescription,
+                (int)(length < 200 ? length : 200),
+                chars
+            );
+            return;
+        }
+        threadNumber = threadNumber * 10 + (uint64_t)(*c - '0');
+    }
+    if (threadNumber > UINT32_MAX) {
+        abortWithErrorFmt("%s: Thread number %" PRIu64 " is too large", encoderPtr->callerDescription, threadNumber);
+        return;
+    }
+
+    if (encoderPtr->lineCount == encoderPtr->lineCapacity) {
+        encoderPtr->lineCapacity = encoderPtr->lineCapacity == 0 ? 1024 : encoderPtr->lineCapacity * 2;
+        encoderPtr->lineWordIds = safeRealloc(
+            encoderPtr->lineWordIds,
+            encoderPtr->lineCapacity * sizeof *encoderPtr->lineWordIds,
+            "ColumnarEncoder_addLine"
+        );
+    }
+    encoderPtr->lineWordIds[encoderPtr->lineCount] = ColumnarEncoder_internWord(
+        encoderPtr,
+        chars,
+        (size_t)(tab - chars)
+    );
+    encoderPtr->lineCount += 1;
+
+    ColumnarEncoder_addThreadNumber(encoderPtr, (uint32_t)threadNumber);
+}
+
+/**
+ * Look up a word in the dictionary, adding it if it is new.
+ *
+ * @param encoderPtr The encoder.
+ * @param chars The word's characters.
+ * @param length The word's length.
+ *
+ * @returns The word's ID: its index in the dictionary.
+ */
+static uint32_t ColumnarEncoder_internWord(
+    struct ColumnarEncoder * const encoderPtr,
+    char const * const chars,
+    size_t const length
+) {
+    size_t const slotMask = encoderPtr->slotCount - 1;
+    size_t slotIndex = (size_t)hashWord(chars, length) & slotMask;
+    while (encoderPtr->slots[slotIndex] != 0) {
+        uint32_t const wordId = encoderPtr->slots[slotIndex] - 1;
+        size_t const wordStart = encoderPtr->wordOffsets[wordId];
+        if (
+            encoderPtr->wordOffsets[wordId + 1] - wordStart == length
+            && memcmp(encoderPtr->wordChars + wordStart, chars, length) == 0
+        ) {
+            return wordId;
+        }
+        slotIndex = (slotIndex + 1) & slotMask;
+    }
+
+    guard(encoderPtr->wordCount < UINT32_MAX - 1, "ColumnarEncoder_internWord: Too many distinct words");
+    uint32_t const wordId = encoderPtr->wordCount;
+
+    size_t const wordCharsLength = encoderPtr->wordCharsLength + length;
+    if (wordCharsLength > encoderPtr->wordCharsCapacity) {
+        size_t wordCharsCapacity = encoderPtr->wordCharsCapacity == 0 ? 64 * 1024 : encoderPtr->wordCharsCapacity;
+        while (wordCharsLength > wordCharsCapacity) {
+            wordCharsCapacity *= 2;
+        }
+        encoderPtr->wordChars = safeRealloc(encoderPtr->wordChars, wordCharsCapacity, "ColumnarEncoder_internWord");
+        encoderPtr->wordCharsCapacity = wordCharsCapacity;
+    }
+    memcpy(encoderPtr->wordChars + encoderPtr->wordCharsLength, chars, length);
+    encoderPtr->wordCharsLength = wordCharsLength;
+
+    if ((size_t)wordId + 2 > encoderPtr->wordOffsetsCapacity) {
+        encoderPtr->wordOffsetsCapacity *= 2;
+        encoderPtr->wordOffsets = safeRealloc(
+            encoderPtr->wordOffsets,
+            encoderPtr->wordOffsetsCapacity * sizeof *encoderPtr->wordOffsets,
+            "ColumnarEncoder_internWord"
+        );
+    }
+    encoderPtr->wordOffsets[wordId + 1] = wordCharsLength;
+    encoderPtr->wordCount += 1;
+
+    encoderPtr->slots[slotIndex] = wordId + 1;
+    if ((size_t)encoderPtr->wordCount * 2 > encoderPtr->slotCount) {
+        ColumnarEncoder_growSlots(encoderPtr);
+    }
+
+    return wordId;
+}
+
+/**
+ * Double the dictionary's slot count, keeping the table at most half full so probe sequences stay short.
+ *
+ * @param encoderPtr The encoder.
+ */
+static void ColumnarEncoder_growSlots(struct ColumnarEncoder * const encoderPtr) {
+    size_t const slotCount = encoderPtr->slotCount * 2;
+    size_t const slotMask = slotCount - 1;
+    uint32_t * const slots = calloc(slotCount, sizeof *slots);
+    guard(slots != NULL, "ColumnarEncoder_growSlots: Failed to allocate the dictionary slots");
+
+    for (uint32_t wordId = 0; wordId < encoderPtr->wordCount; wordId += 1) {
+        size_t const wordStart = encoderPtr->wordOffsets[wordId];
+        size_t slotIndex = (size_t)hashWord(
+            encoderPtr->wordChars + wordStart,
+            encoderPtr->wordOffsets[wordId + 1] - wordStart
+        ) & slotMask;
+        while (slots[slotIndex] != 0) {
+            slotIndex = (slotIndex + 1) & slotMask;
+        }
+        slots[slotIndex] = wordId + 1;
+    }
+
+    free(encoderPtr->slots);
+    encoderPtr->slots = slots;
+    encoderPtr->slotCount = slotCount;
+}
+
+/**
+ * Record the thread number of the latest line, extending the last run if the same thread wrote the line before it.
+ *
+ * @param encoderPtr The encoder.
+ * @param threadNumber The thread number.
+ */
+static void ColumnarEncoder_addThreadNumber(struct ColumnarEncoder * const encoderPtr, uint32_t const threadNumber) {
+    if (encoderPtr->runCount > 0 && encoderPtr->runThreadNumbers[encoderPtr->runCount - 1] == threadNumber) {
+        encoderPtr->runLengths[encoderPtr->runCount - 1] += 1;
+        return;
+    }
+
+    if (encoderPtr->runCount == encoderPtr->runCapacity) {
+        encoderPtr->runCapacity = encoderPtr->runCapacity == 0 ? 1024 : encoderPtr->runCapacity * 2;
+        encoderPtr->runThreadNumbers = safeRealloc(
+            encoderPtr->runThreadNumbers,
+            encoderPtr->runCapacity * sizeof *encoderPtr->runThreadNumbers,
+            "ColumnarEncoder_addThreadNumber"
+        );
+        encoderPtr->runLengths = safeRealloc(
+            encoderPtr->runLengths,
+            encoderPtr->runCapacity * sizeof *encoderPtr->runLengths,
+            "ColumnarEncoder_addThreadNumber"
+        );
+    }
+    encoderPtr->runThreadNumbers[encoderPtr->runCount] = threadNumber;
+    encoderPtr->runLengths[encoderPtr->runCount] = 1;
+    encoderPtr->runCount += 1;
+    if (threadNumber > encoderPtr->maxThreadNumber) {
+        encoderPtr->maxThreadNumber = threadNumber;
+    }
+}
+
+/**
+ * Encode the recorded lines to the binary file.
+ *
+ * @param encoderPtr The encoder.
+ */
+static void ColumnarEncoder_writeFile(struct ColumnarEncoder const * const encoderPtr) {
+    char const * const callerDescription = encoderPtr->callerDescription;
+    uint8_t const wordIdWidth = wordIdWidthFor(encoderPtr->wordCount);
+    uint8_t const threadBitWidth = bitWidthFor(encoderPtr->maxThreadNumber);
+
+    uint8_t header[COLUMNAR_HEADER_LENGTH];
+    memcpy(header, columnarMagic, sizeof columnarMagic);
+    header[4] = columnarVersion;
+    header[5] = wordIdWidth;
+    header[6] = threadBitWidth;
+    header[7] = 0;
+    storeUintLE(header + 8, encoderPtr->lineCount, 8);
+    storeUintLE(header + 16, encoderPtr->wordCount, 4);
+    storeUintLE(header + 20, encoderPtr->runCount, 8);
+
+    struct ChunkWriter writer;
+    ChunkWriter_init(&writer, encoderPtr->binaryFile, callerDescription);
+    memcpy(ChunkWriter_reserve(&writer, sizeof header), header, sizeof header);
+
+    for (uint32_t wordId = 0; wordId < encoderPtr->wordCount; wordId += 1) {
+        size_t const wordStart = encoderPtr->wordOffsets[wordId];
+        size_t const wordLength = encoderPtr->wordOffsets[wordId + 1] - wordStart;
+
+        uint8_t * const lengthBytes = ChunkWriter_reserve(&writer, VARINT_MAX_LENGTH);
+        writer.length -= VARINT_MAX_LENGTH - storeVarint(lengthBytes, wordLength);
+        if (wordLength > 0) {
+            size_t copiedLength = 0;
+            while (copiedLength < wordLength) {
+                size_t const copyLength = wordLength - copiedLength < columnarChunkLength
+                    ? wordLength - copiedLength
+                    : columnarChunkLength;
+                memcpy(
+                    ChunkWriter_reserve(&writer, copyLength),
+                    encoderPtr->wordChars + wordStart + copiedLength,
+                    copyLength
+                );
+                copiedLength += copyLength;
+            }
+        }
+    }
+
+    uint64_t bitBuffer = 0;
+    unsigned int bitCount = 0;
+    for (size_t i = 0; i < encoderPtr->runCount; i += 1) {
+        bitBuffer |= (uint64_t)encoderPtr->runThreadNumbers[i] << bitCount;
+        bitCount += threadBitWidth;
+        while (bitCount >= 8) {
+            *ChunkWriter_reserve(&writer, 1) = (uint8_t)bitBuffer;
+            bitBuffer >>= 8;
+            bitCount -= 8;
+        }
+    }
+    if (bitCount > 0) {
+        *ChunkWriter_reserve(&writer, 1) = (uint8_t)bitBuffer;
+    }
+    for (size_t i = 0; i < encoderPtr->runCount; i += 1) {
+        uint8_t * const lengthBytes = ChunkWriter_reserve(&writer, VARINT_MAX_LENGTH);
+        writer.length -= VARINT_MAX_LENGTH - storeVarint(lengthBytes, encoderPtr->runLengths[i]);
+    }
+
+    for (size_t i = 0; i < encoderPtr->lineCount; i += 1) {
+        storeUintLE(ChunkWriter_reserve(&writer, wordIdWidth), encoderPtr->lineWordIds[i], wordIdWidth);
+    }
+
+    ChunkWriter_destroy(&writer);
+}
+
+/**
+ * Free the memory associated with the encoder.
+ *
+ * @param encoderPtr The encoder.
+ */
+static void ColumnarEncoder_destroy(struct ColumnarEncoder * const encoderPtr) {
+    free(encoderPtr->runLengths);
+    free(encoderPtr->runThreadNumbers);
+    free(encoderPtr->lineWordIds);
+    free(encoderPtr->slots);
+    free(encoderPtr->wordOffsets);
+    free(encoderPtr->wordChars);
+    free(encoderPtr->pendingChars);
+    free(encoderPtr->callerDescription);
+    free(encoderPtr);
+}
+
+/**
+ * The stdio write function of a stream opened with ColumnarOutput_openStream. Each complete line is recorded; a
+ * trailing partial line is kept until the rest of it arrives.
+ */
+static ssize_t ColumnarEncoder_streamWrite(
+    void * const encoderAsVoidPtr,
+    char const * const chars,
+    size_t const length
+) {
+    struct ColumnarEncoder * const encoderPtr = encoderAsVoidPtr;
+
+    size_t lineStart = 0;
+    while (lineStart < length) {
+        char const * const newline = memchr(chars + lineStart, '\n', length - lineStart);
+        size_t const lineEnd = newline == NULL ? length : (size_t)(newline - chars);
+
+        if (newline != NULL && encoderPtr->pendingLength == 0) {
+            ColumnarEncoder_addLine(encoderPtr, chars + lineStart, lineEnd - lineStart);
+        } else {
+            size_t const pendingLength = encoderPtr->pendingLength + (lineEnd - lineStart);
+            if (pendingLength > encoderPtr->pendingCapacity) {
+                encoderPtr->pendingCapacity = pendingLength * 2;
+                encoderPtr->pendingChars = safeRealloc(
+                    encoderPtr->pendingChars,
+                    encoderPtr->pendingCapacity,
+                    "ColumnarEncoder_streamWrite"
+                );
+            }
+            memcpy(encoderPtr->pendingChars + encoderPtr->pendingLength, chars + lineStart, lineEnd - lineStart);
+            encoderPtr->pendingLength = pendingLength;
+
+            if (newline != NULL) {
+                ColumnarEncoder_addLine(encoderPtr, encoderPtr->pendingChars, encoderPtr->pendingLength);
+                encoderPtr->pendingLength = 0;
+            }
+        }
+
+        lineStart = lineEnd + 1;
+    }
+
+    return (ssize_t)length;
+}
+
+/**
+ * The stdio close function of a stream opened with ColumnarOutput_openStream. Encodes the recorded lines to the binary
+ * file and closes it.
+ */
+static int ColumnarEncoder_streamClose(void * const encoderAsVoidPtr) {
+    struct ColumnarEncoder * const encoderPtr = encoderAsVoidPtr;
+
+    if (encoderPtr->pendingLength > 0) {
+        ColumnarEncoder_addLine(encoderPtr, encoderPtr->pendingChars, encoderPtr->pendingLength);
+        encoderPtr->pendingLength = 0;
+    }
+
+    ColumnarEncoder_writeFile(encoderPtr);
+    int const closeResult = fclose(encoderPtr->binaryFile);
+    ColumnarEncoder_destroy(encoderPtr);
+    return closeResult;
+}
+
+static void ChunkWriter_init(
+    struct ChunkWriter * const writerOutPtr,
+    FILE * const file,
+    char const * const callerDescription
+) {
+    writerOutPtr->file = file;
+    writerOutPtr->bytes = safeMalloc(columnarChunkLength, "ChunkWriter_init");
+    writerOutPtr->length = 0;
+    writerOutPtr->callerDescription = callerDescription;
+}
+
+/**
+ * Make room for bytes at the end of the block, first writing out the block if they do not fit.
+ *
+ * @param writerPtr The writer.
+ * @param length The number of bytes. Must be at most columnarChunkLength.
+ *
+ * @returns Where to store the bytes.
+ */
+static uint8_t *ChunkWriter_reserve(struct ChunkWriter * const writerPtr, size_t const length) {
+    if (writerPtr->length + length > columnarChunkLength) {
+        writeBytes(writerPtr->file, writerPtr->bytes, writerPtr->length, writerPtr->callerDescription);
+        writerPtr->length = 0;
+    }
+
+    uint8_t * const bytes = writerPtr->bytes + writerPtr->length;
+    writerPtr->length += length;
+    return bytes;
+}
+
+/**
+ * Write out the rest of the block, then free the writer's memory.
+ *
+ * @param writerPtr The writer.
+ */
+static void ChunkWriter_destroy(struct ChunkWriter * const writerPtr) {
+    writeBytes(writerPtr->file, writerPtr->bytes, writerPtr->length, writerPtr->callerDescription);
+    free(writerPtr->bytes);
+}
+
+/**
+ * Hash a word with 64-bit FNV-1a.
+ */
+static uint64_t hashWord(char const * const chars, size_t const length) {
+    uint64_t hash = UINT64_C(14695981039346656037);
+    for (size_t i = 0; i < length; i += 1) {
+        hash ^= (uint8_t)chars[i];
+        hash *= UINT64_C(1099511628211);
+    }
+    return hash;
+}
+
+/**
+ * Get the number of bytes needed to store any ID of a dictionary with the given number of words.
+ */
+static uint8_t wordIdWidthFor(uint32_t const wordCount) {
+    if (wordCount <= UINT8_MAX + 1) {
+        return 1;
+    }
+    if (wordCount <= UINT16_MAX + 1) {
+        return 2;
+    }
+    return 4;
+}
+
+/**
+ * Get the number of bits needed to store the given value, at least 1.
+ */
+static uint8_t bitWidthFor(uint32_t const value) {
+    uint8_t width = 1;
+    while (width < 32 && (value >> width) != 0) {
+        width += 1;
+    }
+    return width;
+}
+
+static void storeUintLE(uint8_t * const bytes, uint64_t const value, size_t const byteCount) {
+    for (size_t i = 0; i < byteCount; i += 1) {
+        bytes[i] = (uint8_t)(value >> (i * 8));
+    }
+}
+
+static uint64_t loadUintLE(uint8_t const * const bytes, size_t const byteCount) {
+    uint64_t value = 0;
+    for (size_t i = 0; i < byteCount; i += 1) {
+        value |= (uint64_t)bytes[i] << (i * 8);
+    }
+    return value;
+}
+
+/**
+ * Store a value as a LEB128 varint: 7 bits per byte, least significant first, with the high bit set on every byte but
+ * the last.
+ *
+ * @returns The number of bytes stored, at most VARINT_MAX_LENGTH.
+ */
+static size_t storeVarint(uint8_t * const bytes, uint64_t value) {
+    size_t length = 0;
+    while (value >= 0x80) {
+        bytes[length] = (uint8_t)(value | 0x80);
+        length += 1;
+        value >>= 7;
+    }
+    bytes[length] = (uint8_t)value;
+    return length + 1;
+}
+
+/**
+ * Read a LEB128 varint. If the file ends or the varint is too long, abort the program with an error message.
+ */
+static uint64_t readVarint(FILE * const file, char const * const callerDescription) {
+    uint64_t value = 0;
+    for (unsigned int shift = 0; shift < 7 * VARINT_MAX_LENGTH; shift += 7) {
+        int const byte = getc(file);
+        if (byte == EOF) {
+            abortWithErrorFmt("%s: Columnar output is truncated", callerDescription);
+            return 0;
+        }
+
+        value |= (uint64_t)(byte & 0x7f) << shift;
+        if ((byte & 0x80) == 0) {
+            return value;
+        }
+    }
+
+    abortWithErrorFmt("%s: Invalid columnar output varint", callerDescription);
+    return 0;
+}
+
+static void writeBytes(
+    FILE * const file,
+    void const * const bytes,
+    size_t const length,
+    char const * const callerDescription
+) {
+    if (length > 0 && fwrite(bytes, 1, length, file) != length) {
+        int const fwriteErrorCode = errno;
+        char const * const fwriteErrorMessage = strerror(fwriteErrorCode);
+
+        abortWithErrorFmt(
+            "%s: Failed to write columnar output using fwrite (error code: %d; error message: \"%s\")",
+            callerDescription,
+            fwriteErrorCode,
+            fwriteErrorMessage
+        );
+    }
+}
+
+/**
+ * Read exactly the given number of bytes. If the file ends first or the read fails, abort the program with an error
+ * message.
+ */
+static void readBytes(
+    FILE * const file,
+    void * const bytes,
+    size_t const length,
+    char const * const callerDescription
+) {
+    if (length > 0 && fread(bytes, 1, length, file) != length) {
+        if (ferror(file)) {
+            int const freadErrorCode = errno;
+            char const * const freadErrorMessage = strerror(freadErrorCode);
+
+            abortWithErrorFmt(
+                "%s: Failed to read columnar output using fread (error code: %d; error message: \"%s\")",
+                callerDescription,
+                freadErrorCode,
+                freadErrorMessage
+            );
+            return;
+        }
+
+        abortWithErrorFmt("%s: Columnar output is truncated", callerDescription);
+    }
+}
@@ -0,0 +1,177 @@
+#include "../../include/util/LineTokenizer.h"
+
+#include "../../include/util/delimiterScan.h"
+#include "../../include/util/string.h"
+#include "../../include/util/memory.h"
+#include "../../include/util/guard.h"
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+
+/** The number of delimiters found per scan of the buffer. */
+#define DELIMITER_BATCH_LENGTH 256
+
+/**
+ * Splits a character buffer into lines without copying. Each line is returned as a span into the buffer, so the buffer
+ * (e.g. a MappedFile) must outlive every span. Lines are split on newlines the same way as readFileLine. Newlines are
+ * found a batch at a time with scanDelimiters, rather than searching for each line's newline separately.
+ *
+ * When created with a delimiter set, the buffer is split into words instead: tokens are separated by any run of the
+ * set's characters, found a batch at a time with scanDelimiterSet, and empty tokens are skipped.
+ */
+struct LineTokenizer {
+    char const *chars;
+    size_t length;
+    size_t position;
+    /** Whether to split on wordDelimiters rather than newlines. */
+    bool splitsWords;
+    struct DelimiterSet wordDelimiters;
+
+    /** The buffer offsets of the delimiters found by the last scan, and how many of them have been used. */
+    size_t delimiterOffsets[DELIMITER_BATCH_LENGTH];
+    size_t delimiterCount;
+    size_t delimiterIndex;
+    /** Where the next scan starts. */
+    size_t scanPosition;
+};
+
+static void LineTokenizer_scan(LineTokenizer tokenizer);
+
+/**
+ * Create a LineTokenizer positioned at the start of the given characters.
+ *
+ * @param chars The characters to split, or null if length is 0. The tokenizer does not take ownership of this memory.
+ * @param length The number of characters.
+ *
+ * @returns The newly allocated LineTokenizer. The caller is responsible for freeing this memory.
+ */
+LineTokenizer LineTokenizer_create(char const * const chars, size_t const length) {
+    guard(chars != NULL || length == 0, "LineTokenizer_create: chars must not be null unless length is 0");
+
+    LineTokenizer const tokenizer = safeMalloc(sizeof *tokenizer, "LineTokenizer_create");
+    tokenizer->chars = chars;
+    tokenizer->length = length;
+    tokenizer->position = 0;
+    tokenizer->splitsWords = false;
+    tokenizer->delimiterCount = 0;
+    tokenizer->delimiterIndex = 0;
+    tokenizer->scanPosition = 0;
+    return tokenizer;
+}
+
+/**
+ * Create a LineTokenizer which splits the given characters into words separated by runs of delimiters.
+ *
+ * @param chars The characters to split, or null if length is 0. The tokenizer does not take ownership of this memory.
+ * @param length The number of characters.
+ * @param wordDelimitersPtr The delimiters, e.g. whitespace. The tokenizer keeps a copy of them.
+ *
+ * @returns The newly allocated LineTokenizer. The caller is responsible for freeing this memory.
+ */
+LineTokenizer LineTokenizer_createWords(
+    char const * const chars,
+    size_t const length,
+    struct DelimiterSet const * const wordDelimitersPtr
+) {
+    guardNotNull(wordDelimitersPtr, "wordDelimitersPtr", "LineTokenizer_createWords");
+
+    LineTokenizer const tokenizer = LineTokenizer_create(chars, length);
+    tokenizer->splitsWords = true;
+    tokenizer->wordDelimiters = *wordDelimitersPtr;
+    return tokenizer;
+}
+
+/**
+ * Free the memory associated with the LineTokenizer. This does not free the characters being split.
+ *
+ * @param tokenizer The LineTokenizer instance.
+ */
+void LineTokenizer_destroy(LineTokenizer const tokenizer) {
+    guardNotNull(tokenizer, "tokenizer", "LineTokenizer_destroy");
+    free(tokenizer);
+}
+
+/**
+ * Advance to the next line, or the next non-empty word if created with LineTokenizer_createWords. The span excludes
+ * its terminating delimiter. This does not allocate memory.
+ *
+ * @param tokenizer The LineTokenizer instance.
+ * @param lineOutPtr The location to store the line's span.
+ *
+ * @returns Whether a line was found, or false if the end of the characters was reached.
+ */
+bool LineTokenizer_next(LineTokenizer const tokenizer, struct StringSpan * const lineOutPtr) {
+    guardNotNull(tokenizer, "tokenizer", "LineTokenizer_next");
+    guardNotNull(lineOutPtr, "lineOutPtr", "LineTokenizer_next");
+
+    while (tokenizer->position < tokenizer->length) {
+        if (tokenizer->delimiterIndex == tokenizer->delimiterCount && tokenizer->scanPosition < tokenizer->length) {
+            LineTokenizer_scan(tokenizer);
+        }
+
+        // Without a delimiter left, the rest of the buffer is the last line
+        size_t lineEnd = tokenizer->length;
+        if (tokenizer->delimiterIndex < tokenizer->delimiterCount) {
+            lineEnd = tokenizer->delimiterOffsets[tokenizer->delimiterIndex];
+            tokenizer->delimiterIndex += 1;
+        }
+
+        lineOutPtr->chars = &tokenizer->chars[tokenizer->position];
+        lineOutPtr->length = lineEnd - tokenizer->position;
+        tokenizer->position = lineEnd + 1;
+        if (!tokenizer->splitsWords || lineOutPtr->length > 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Move back to the start of the characters.
+ *
+ * @param tokenizer The LineTokenizer instance.
+ */
+void LineTokenizer_reset(LineTokenizer const tokenizer) {
+    guardNotNull(tokenizer, "tokenizer", "LineTokenizer_reset");
+    tokenizer->position = 0;
+    tokenizer->delimiterCount = 0;
+    tokenizer->delimiterIndex = 0;
+    tokenizer->scanPosition = 0;
+}
+
+/**
+ * Find the next batch of delimiters after the last scan. Every delimiter found so far must have been used.
+ *
+ * @param tokenizer The LineTokenizer instance.
+ */
+static void LineTokenizer_scan(LineTokenizer const tokenizer) {
+    char const * const scanChars = &tokenizer->chars[tokenizer->scanPosition];
+    size_t const scanLength = tokenizer->length - tokenizer->scanPosition;
+
+    size_t scannedLength;
+    if (!tokenizer->splitsWords) {
+        tokenizer->delimiterCount = scanDelimiters(
+            scanChars,
+            scanLength,
+            '\n',
+            tokenizer->delimiterOffsets,
+            DELIMITER_BATCH_LENGTH,
+            &scannedLength
+        );
+    } else {
+        tokenizer->delimiterCount = scanDelimiterSet(
+            scanChars,
+            scanLength,
+            &tokenizer->wordDelimiters,
+            tokenizer->delimiterOffsets,
+            DELIMITER_BATCH_LENGTH,
+            &scannedLength
+        );
+    }
+    for (size_t i = 0; i < tokenizer->delimiterCount; i += 1) {
+        tokenizer->delimiterOffsets[i] += tokenizer->scanPosition;
+    }
+    tokenizer->delimiterIndex = 0;
+    tokenizer->scanPosition += scannedLength;
+}
@@ -0,0 +1,131 @@
+#include "../../include/util/MappedFile.h"
+
+#include "../../include/util/memory.h"
+#include "../../include/util/guard.h"
+#include "../../include/util/error.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/**
+ * Represents the full contents of a file mapped read-only into memory.
+ */
+struct MappedFile {
+    char *chars;
+    size_t length;
+};
+
+/**
+ * Map the entire file at the given path read-only into memory. If the operation fails, abort the program with an error
+ * message.
+ *
+ * @param filePath The file path.
+ * @param callerDescription A description of the caller to be included in the error message. This could be the name of
+ *                          the calling function, plus extra information if useful.
+ *
+ * @returns The newly allocated MappedFile. The caller is responsible for freeing this memory.
+ */
+MappedFile MappedFile_open(char const * const filePath, char const * const callerDescription) {
+    guardNotNull(filePath, "filePath", "MappedFile_open");
+    guardNotNull(callerDescription, "callerDescription", "MappedFile_open");
+
+    int const fileDescriptor = open(filePath, O_RDONLY);
+    if (fileDescriptor == -1) {
+        int const openErrorCode = errno;
+        char const * const openErrorMessage = strerror(openErrorCode);
+
+        abortWithErrorFmt(
+            "%s: Failed to open file \"%s\" using open (error code: %d; error message: \"%s\")",
+            callerDescription,
+            filePath,
+            openErrorCode,
+            openErrorMessage
+        );
+        return NULL;
+    }
+
+    struct stat fileStatus;
+    if (fstat(fileDescriptor, &fileStatus) != 0) {
+        int const fstatErrorCode = errno;
+        char const * const fstatErrorMessage = strerror(fstatErrorCode);
+
+        abortWithErrorFmt(
+            "%s: Failed to get size of file \"%s\" using fstat (error code: %d; error message: \"%s\")",
+            callerDescription,
+            filePath,
+            fstatErrorCode,
+            fstatErrorMessage
+        );
+        return NULL;
+    }
+
+    MappedFile const file = safeMalloc(sizeof *file, "MappedFile_open");
+    file->chars = NULL;
+    file->length = (size_t)fileStatus.st_size;
+
+    // mmap rejects zero-length mappings, so an empty file is represented without one
+    if (file->length > 0) {
+        void * const mapping = mmap(NULL, file->length, PROT_READ, MAP_PRIVATE, fileDescriptor, 0);
+        if (mapping == MAP_FAILED) {
+            int const mmapErrorCode = errno;
+            char const * const mmapErrorMessage = strerror(mmapErrorCode);
+
+            abortWithErrorFmt(
+                "%s: Failed to map file \"%s\" using mmap (error code: %d; error message: \"%s\")",
+                callerDescription,
+                filePath,
+                mmapErrorCode,
+                mmapErrorMessage
+            );
+            return NULL;
+        }
+
+        file->chars = mapping;
+    }
+
+    close(fileDescriptor);
+    return file;
+}
+
+/**
+ * Unmap the file and free the memory associated with the MappedFile.
+ *
+ * @param file The MappedFile instance.
+ */
+void MappedFile_destroy(MappedFile const file) {
+    guardNotNull(file, "file", "MappedFile_destroy");
+
+    if (file->chars != NULL) {
+        munmap(file->chars, file->length);
+    }
+    free(file);
+}
+
+/**
+ * Get the contents of the file.
+ *
+ * @param file The MappedFile instance.
+ *
+ * @returns The file contents, or null if the file is empty. This array is not null-terminated.
+ */
+char const *MappedFile_chars(ConstMappedFile const file) {
+    guardNotNull(file, "file", "MappedFile_chars");
+    return file->chars;
+}
+
+/**
+ * Get the length of the file.
+ *
+ * @param file The MappedFile instance.
+ *
+ * @returns The number of characters in the file.
+ */
+size_t MappedFile_length(ConstMappedFile const file) {
+    guardNotNull(file, "file", "MappedFile_length");
+    return file->length;
+}
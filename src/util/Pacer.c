@@ -0,0 +1,313 @@
+#include "../../include/util/Pacer.h"
+
+#include "../../include/util/memory.h"
+#include "../../include/util/random.h"
+#include "../../include/util/thread.h"
+#include "../../include/util/time.h"
+#include "../../include/util/guard.h"
+#include "../../include/util/error.h"
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdalign.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <string.h>
+#include <ctype.h>
+#include <stdio.h>
+#include <math.h>
+#include <time.h>
+#include <pthread.h>
+
+/**
+ * Delays threads between units of work according to a PacingPolicy. The random policies draw from a separate seeded
+ * stream per thread, so a run's delays are reproducible and threads never contend over a shared generator. The token
+ * bucket is shared by all threads: each call reserves the next free slot under a mutex and sleeps until it arrives.
+ */
+struct Pacer {
+    struct PacingPolicy policy;
+
+    unsigned int threadCount;
+    struct PacerRandom *randoms;
+
+    pthread_mutex_t bucketMutex;
+    uint64_t bucketIntervalNanoseconds;
+    uint64_t bucketToleranceNanoseconds;
+    uint64_t bucketNextSlotNanoseconds;
+};
+
+/** A thread's random stream, on a cache line of its own since every thread advances its stream after each word. */
+struct PacerRandom {
+    alignas(CACHE_LINE_SIZE) struct Random random;
+};
+
+static uint64_t Pacer_randomDelay(Pacer pacer, unsigned int threadIndex);
+static uint64_t Pacer_reserveBucketSlot(Pacer pacer, uint64_t nowNanoseconds);
+
+static void sleepUntilMonotonicNanoseconds(uint64_t wakeNanoseconds);
+static bool hasNegativeField(char const *text);
+
+/** The longest single delay the random policies produce; longer draws from heavy tails are cut to this. */
+static uint64_t const maxRandomDelayNanoseconds = (uint64_t)10 * 1000 * 1000 * 1000;
+
+/**
+ * Parse a pacing policy of the form "none", "fixed:NS", "uniform:MAX_NS", "exponential:MEAN_NS",
+ * "pareto:SCALE_NS:SHAPE", or "rate:PER_SECOND[:BURST]". Fields not named by the text (such as the seed) are left as
+ * they were.
+ *
+ * @param text The text to parse.
+ * @param policyInOutPtr The policy to update. It is left unchanged if the text is invalid.
+ *
+ * @returns Whether the text was a valid policy.
+ */
+bool PacingPolicy_parse(char const * const text, struct PacingPolicy * const policyInOutPtr) {
+    guardNotNull(text, "text", "PacingPolicy_parse");
+    guardNotNull(policyInOutPtr, "policyInOutPtr", "PacingPolicy_parse");
+
+    struct PacingPolicy policy = *policyInOutPtr;
+    int consumedLength = -1;
+
+    // scanf's unsigned conversions accept a leading '-' and silently wrap the value around
+    if (hasNegativeField(text)) {
+        return false;
+    }
+
+    if (strcmp(text, "none") == 0) {
+        policy.kind = PacingKind_None;
+    } else if (strncmp(text, "fixed:", 6) == 0) {
+        policy.kind = PacingKind_Fixed;
+        sscanf(text, "fixed:%" SCNu64 "%n", &policy.delayNanoseconds, &consumedLength);
+    } else if (strncmp(text, "uniform:", 8) == 0) {
+        policy.kind = PacingKind_Uniform;
+        sscanf(text, "uniform:%" SCNu64 "%n", &policy.delayNanoseconds, &consumedLength);
+    } else if (strncmp(text, "exponential:", 12) == 0) {
+        policy.kind = PacingKind_Exponential;
+        sscanf(text, "exponential:%" SCNu64 "%n", &policy.delayNanoseconds, &consumedLength);
+    } else if (strncmp(text, "pareto:", 7) == 0) {
+        policy.kind = PacingKind_Pareto;
+        sscanf(text, "pareto:%" SCNu64 ":%lf%n", &policy.delayNanoseconds, &policy.paretoShape, &consumedLength);
+        if (!(policy.paretoShape > 0)) {
+            return false;
+        }
+    } else if (strncmp(text, "rate:", 5) == 0) {
+        policy.kind = PacingKind_TokenBucket;
+        policy.burst = 1;
+        sscanf(text, "rate:%lf%n:%u%n", &policy.ratePerSecond, &consumedLength, &policy.burst, &consumedLength);
+        if (!(policy.ratePerSecond > 0) || policy.burst == 0) {
+            return false;
+        }
+    } else {
+        return false;
+    }
+
+    if (policy.kind != PacingKind_None && (consumedLength < 0 || text[consumedLength] != '\0')) {
+        return false;
+    }
+
+    *policyInOutPtr = policy;
+    return true;
+}
+
+/**
+ * Create a Pacer for the given number of threads.
+ *
+ * @param policy The pacing policy. It is copied.
+ * @param threadCount The number of threads that will call Pacer_pace. Must be positive.
+ *
+ * @returns The newly allocated Pacer. The caller is responsible for freeing this memory.
+ */
+Pacer Pacer_create(struct PacingPolicy const * const policy, unsigned int const threadCount) {
+    guardNotNull(policy, "policy", "Pacer_create");
+    guard(threadCount > 0, "Pacer_create: threadCount must be positive");
+
+    Pacer const pacer = safeMalloc(sizeof *pacer, "Pacer_create");
+    pacer->policy = *policy;
+    pacer->threadCount = threadCount;
+
+    pacer->randoms = safeAlignedAlloc(CACHE_LINE_SIZE, sizeof *pacer->randoms * threadCount, "Pacer_create");
+    unsigned int const seed = policy->seed != 0
+        ? policy->seed
+        : (unsigned int)safeClockGettime(CLOCK_REALTIME, "Pacer_create").tv_nsec;
+    for (unsigned int i = 0; i < threadCount; i += 1) {
+        Random_seed(&pacer->randoms[i].random, seed, i);
+    }
+
+    safeMutexInit(&pacer->bucketMutex, NULL, "Pacer_create");
+    if (policy->kind == PacingKind_TokenBucket) {
+        guard(policy->ratePerSecond > 0, "Pacer_create: ratePerSecond must be positive");
+        guard(policy->burst > 0, "Pacer_create: burst must be positive");
+
+        pacer->bucketIntervalNanoseconds = (uint64_t)((double)(1000 * 1000 * 1000) / policy->ratePerSecond);
+        pacer->bucketToleranceNanoseconds = pacer->bucketIntervalNanoseconds * (policy->burst - 1);
+        pacer->bucketNextSlotNanoseconds = monotonicNanoseconds();
+    } else if (policy->kind == PacingKind_Pareto) {
+        guard(policy->paretoShape > 0, "Pacer_create: paretoShape must be positive");
+    }
+
+    return pacer;
+}
+
+/**
+ * Free the memory associated with the Pacer.
+ *
+ * @param pacer The Pacer instance.
+ */
+void Pacer_destroy(Pacer const pacer) {
+    guardNotNull(pacer, "pacer", "Pacer_destroy");
+
+    safeMutexDestroy(&pacer->bucketMutex, "Pacer_destroy");
+    free(pacer->randoms);
+    free(pacer);
+}
+
+/**
+ * Delay the calling thread after a unit of work, as the pacer's policy dictates.
+ *
+ * @param pacer The Pacer instance.
+ * @param threadIndex The index of the calling thread, less than the Pacer's thread count. No two threads may pace with
+ *                    the same index at once.
+ *
+ * @returns How long the thread slept, in nanoseconds.
+ */
+uint64_t Pacer_pace(Pacer const pacer, unsigned int const threadIndex) {
+    guardNotNull(pacer, "pacer", "Pacer_pace");
+    guardFmt(
+        threadIndex < pacer->threadCount,
+        "Pacer_pace: threadIndex (%u) must be less than the thread count (%u)",
+        threadIndex,
+        pacer->threadCount
+    );
+
+    uint64_t delayNanoseconds;
+    switch (pacer->policy.kind) {
+        case PacingKind_None: {
+            return 0;
+        }
+        case PacingKind_Fixed: {
+            delayNanoseconds = pacer->policy.delayNanoseconds;
+            break;
+        }
+        case PacingKind_Uniform:
+        case PacingKind_Exponential:
+        case PacingKind_Pareto: {
+            delayNanoseconds = Pacer_randomDelay(pacer, threadIndex);
+            break;
+        }
+        case PacingKind_TokenBucket: {
+            uint64_t const startNanoseconds = monotonicNanoseconds();
+            uint64_t const slotNanoseconds = Pacer_reserveBucketSlot(pacer, startNanoseconds);
+            if (slotNanoseconds <= startNanoseconds) {
+                return 0;
+            }
+            sleepUntilMonotonicNanoseconds(slotNanoseconds);
+            return monotonicNanoseconds() - startNanoseconds;
+        }
+        default: {
+            abortWithErrorFmt("Pacer_pace: unknown PacingKind %d", (int)pacer->policy.kind);
+            return 0;
+        }
+    }
+
+    if (delayNanoseconds == 0) {
+        return 0;
+    }
+    uint64_t const startNanoseconds = monotonicNanoseconds();
+    sleepUntilMonotonicNanoseconds(startNanoseconds + delayNanoseconds);
+    return monotonicNanoseconds() - startNanoseconds;
+}
+
+/**
+ * Draw the next delay from the calling thread's random stream.
+ *
+ * @param pacer The Pacer instance.
+ * @param threadIndex The index of the calling thread.
+ *
+ * @returns The delay in nanoseconds.
+ */
+static uint64_t Pacer_randomDelay(Pacer const pacer, unsigned int const threadIndex) {
+    struct PacingPolicy const * const policy = &pacer->policy;
+    double const delayNanoseconds = (double)policy->delayNanoseconds;
+
+    // A uniform draw from [0, 1)
+    double const unit = Random_nextDouble(&pacer->randoms[threadIndex].random);
+
+    double delay;
+    switch (policy->kind) {
+        case PacingKind_Uniform:
+            delay = unit * delayNanoseconds;
+            break;
+        case PacingKind_Exponential:
+            delay = -delayNanoseconds * log1p(-unit);
+            break;
+        case PacingKind_Pareto:
+            delay = delayNanoseconds / pow(1 - unit, 1 / policy->paretoShape);
+            break;
+        case PacingKind_None:
+        case PacingKind_Fixed:
+        case PacingKind_TokenBucket:
+        default:
+            abortWithErrorFmt("Pacer_randomDelay: PacingKind %d is not random", (int)policy->kind);
+            return 0;
+    }
+
+    return delay >= (double)maxRandomDelayNanoseconds ? maxRandomDelayNanoseconds : (uint64_t)delay;
+}
+
+/**
+ * Reserve the next slot of the token bucket. Slots are spaced one interval apart, but up to the burst size of them may
+ * fall at the current time when the bucket has been idle.
+ *
+ * @param pacer The Pacer instance.
+ * @param nowNanoseconds The current monotonic time, in nanoseconds.
+ *
+ * @returns The monotonic time, in nanoseconds, at which the caller may proceed.
+ */
+static uint64_t Pacer_reserveBucketSlot(Pacer const pacer, uint64_t const nowNanoseconds) {
+    safeMutexLock(&pacer->bucketMutex, "Pacer_reserveBucketSlot");
+
+    if (pacer->bucketNextSlotNanoseconds < nowNanoseconds) {
+        pacer->bucketNextSlotNanoseconds = nowNanoseconds;
+    }
+    uint64_t slotNanoseconds = pacer->bucketNextSlotNanoseconds - pacer->bucketToleranceNanoseconds;
+    if (pacer->bucketNextSlotNanoseconds < pacer->bucketToleranceNanoseconds || slotNanoseconds < nowNanoseconds) {
+        slotNanoseconds = nowNanoseconds;
+    }
+    pacer->bucketNextSlotNanoseconds += pacer->bucketIntervalNanoseconds;
+
+    safeMutexUnlock(&pacer->bucketMutex, "Pacer_reserveBucketSlot");
+
+    return slotNanoseconds;
+}
+
+/**
+ * Sleep until the monotonic clock reaches the given time.
+ *
+ * @param wakeNanoseconds The time in nanoseconds.
+ */
+static void sleepUntilMonotonicNanoseconds(uint64_t const wakeNanoseconds) {
+    struct timespec const wakeTime = {
+        .tv_sec = (time_t)(wakeNanoseconds / (1000 * 1000 * 1000)),
+        .tv_nsec = (long)(wakeNanoseconds % (1000 * 1000 * 1000))
+    };
+    safeClockNanosleepUntil(CLOCK_MONOTONIC, wakeTime, "sleepUntilMonotonicNanoseconds");
+}
+
+/**
+ * Check whether any ':'-separated field of a pacing policy starts with a minus sign, after the whitespace scanf skips.
+ *
+ * @param text The policy text.
+ *
+ * @returns Whether a field is negative.
+ */
+static bool hasNegativeField(char const *text) {
+    for (char const *colon = strchr(text, ':'); colon != NULL; colon = strchr(colon + 1, ':')) {
+        char const *fieldStart = colon + 1;
+        while (isspace((unsigned char)*fieldStart)) {
+            fieldStart += 1;
+        }
+        if (*fieldStart == '-') {
+            return true;
+        }
+    }
+    return false;
+}
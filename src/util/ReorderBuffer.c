@@ -0,0 +1,135 @@
+#include "../../include/util/ReorderBuffer.h"
+
+#include "../../include/util/memory.h"
+#include "../../include/util/thread.h"
+#include "../../include/util/guard.h"
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <pthread.h>
+
+/**
+ * Collects lines that are completed out of order and writes them to a file in sequence-number order. Lines are held in
+ * a fixed-size ring indexed by sequence number until every preceding line has been written. A line too far ahead of the
+ * next one due to fit in the ring waits for room, so one stalled early line cannot make later lines pile up without
+ * bound.
+ */
+struct ReorderBuffer {
+    FILE *outFile;
+    pthread_mutex_t mutex;
+    pthread_cond_t roomCondition;
+
+    size_t nextSequenceNumber;
+    char **pendingLines;
+    size_t pendingCapacity;
+};
+
+/**
+ * Create an empty ReorderBuffer which writes to the given file. The first line written will be the one with sequence
+ * number 0.
+ *
+ * @param outFile The file to which lines are written.
+ * @param capacity The most lines that may be pending at once, e.g. a small multiple of the number of submitting
+ *                 threads. Must be positive. It is rounded up to a power of two.
+ *
+ * @returns The newly allocated ReorderBuffer. The caller is responsible for freeing this memory.
+ */
+ReorderBuffer ReorderBuffer_create(FILE * const outFile, size_t const capacity) {
+    guardNotNull(outFile, "outFile", "ReorderBuffer_create");
+    guard(capacity > 0, "ReorderBuffer_create: capacity must be positive");
+
+    ReorderBuffer const buffer = safeMalloc(sizeof *buffer, "ReorderBuffer_create");
+    buffer->outFile = outFile;
+    safeMutexInit(&buffer->mutex, NULL, "ReorderBuffer_create");
+    safeConditionInit(&buffer->roomCondition, NULL, "ReorderBuffer_create");
+
+    size_t pendingCapacity = 1;
+    while (pendingCapacity < capacity) {
+        pendingCapacity *= 2;
+    }
+    buffer->nextSequenceNumber = 0;
+    buffer->pendingLines = safeMalloc(sizeof *buffer->pendingLines * pendingCapacity, "ReorderBuffer_create");
+    for (size_t i = 0; i < pendingCapacity; i += 1) {
+        buffer->pendingLines[i] = NULL;
+    }
+    buffer->pendingCapacity = pendingCapacity;
+
+    return buffer;
+}
+
+/**
+ * Free the memory associated with the ReorderBuffer. Every sequence number before the last one submitted must have been
+ * submitted, so that no lines remain pending.
+ *
+ * @param buffer The ReorderBuffer instance.
+ */
+void ReorderBuffer_destroy(ReorderBuffer const buffer) {
+    guardNotNull(buffer, "buffer", "ReorderBuffer_destroy");
+
+    for (size_t i = 0; i < buffer->pendingCapacity; i += 1) {
+        guardFmt(
+            buffer->pendingLines[i] == NULL,
+            "ReorderBuffer_destroy: lines remain pending (next sequence number: %zu)",
+            buffer->nextSequenceNumber
+        );
+    }
+
+    safeConditionDestroy(&buffer->roomCondition, "ReorderBuffer_destroy");
+    safeMutexDestroy(&buffer->mutex, "ReorderBuffer_destroy");
+    free(buffer->pendingLines);
+    free(buffer);
+}
+
+/**
+ * Submit the line with the given sequence number. If it is the next line due, it is written immediately along with any
+ * pending lines that directly follow it. Otherwise it is held until the lines before it have been submitted, first
+ * waiting until it is within the buffer's capacity of the next line due. The thread submitting the next line due never
+ * waits, so this cannot deadlock as long as every claimed sequence number is eventually submitted.
+ *
+ * @param buffer The ReorderBuffer instance.
+ * @param sequenceNumber The line's position in the output. Each sequence number must be submitted exactly once.
+ * @param line The line, including any trailing newline. The buffer takes ownership of this memory.
+ */
+void ReorderBuffer_submit(ReorderBuffer const buffer, size_t const sequenceNumber, char * const line) {
+    guardNotNull(buffer, "buffer", "ReorderBuffer_submit");
+    guardNotNull(line, "line", "ReorderBuffer_submit");
+
+    safeMutexLock(&buffer->mutex, "ReorderBuffer_submit");
+
+    guardFmt(
+        sequenceNumber >= buffer->nextSequenceNumber,
+        "ReorderBuffer_submit: sequence number %zu was already written",
+        sequenceNumber
+    );
+
+    while (sequenceNumber - buffer->nextSequenceNumber >= buffer->pendingCapacity) {
+        safeConditionWait(&buffer->roomCondition, &buffer->mutex, "ReorderBuffer_submit");
+    }
+
+    size_t const mask = buffer->pendingCapacity - 1;
+    guardFmt(
+        buffer->pendingLines[sequenceNumber & mask] == NULL,
+        "ReorderBuffer_submit: sequence number %zu was submitted twice",
+        sequenceNumber
+    );
+    buffer->pendingLines[sequenceNumber & mask] = line;
+
+    size_t const firstSequenceNumber = buffer->nextSequenceNumber;
+    while (true) {
+        char ** const nextLinePtr = &buffer->pendingLines[buffer->nextSequenceNumber & mask];
+        if (*nextLinePtr == NULL) {
+            break;
+        }
+
+        fputs(*nextLinePtr, buffer->outFile);
+        free(*nextLinePtr);
+        *nextLinePtr = NULL;
+        buffer->nextSequenceNumber += 1;
+    }
+    if (buffer->nextSequenceNumber != firstSequenceNumber) {
+        safeConditionBroadcast(&buffer->roomCondition, "ReorderBuffer_submit");
+    }
+
+    safeMutexUnlock(&buffer->mutex, "ReorderBuffer_submit");
+}
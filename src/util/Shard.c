@@ -0,0 +1,319 @@
+#include "../../include/util/Shard.h"
+
+#include "../../include/util/lists.h"
+#include "../../include/util/memory.h"
+#include "../../include/util/string.h"
+#include "../../include/util/file.h"
+#include "../../include/util/guard.h"
+#include "../../include/util/error.h"
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdarg.h>
+#include <string.h>
+#include <errno.h>
+#include <stdio.h>
+#include <sys/types.h>
+
+/**
+ * The number of lines between the checkpoints a Shard records to let a merge seek close to its first sequence number.
+ */
+static size_t const checkpointInterval = 1024;
+/**
+ * The stdio buffer size of each shard's read stream during a merge. The merge alternates between shards line by line,
+ * so a large buffer keeps each shard's reads to a few big blocks.
+ */
+static size_t const mergeReadBufferSize = 256 * 1024;
+
+/**
+ * An append-only file of output lines, each prefixed with its sequence number, which are written by one thread in
+ * ascending sequence order. Shards from several threads are interleaved back into a single sequence by
+ * Shard_mergeRange, which streams the files so that the output need not fit in memory.
+ */
+struct Shard {
+    char *filePath;
+    FILE *file;
+
+    size_t lineCount;
+    size_t lastSequenceNumber;
+    SizeList checkpointSequenceNumbers;
+    SizeList checkpointOffsets;
+};
+
+/**
+ * The read position of one shard during a merge: the shard's file and its next unmerged line. The line buffer is reused
+ * by getline for every line of the shard.
+ */
+struct ShardMergeCursor {
+    FILE *file;
+    char *line;
+    size_t lineCapacity;
+    bool atEnd;
+    size_t sequenceNumber;
+    char const *payload;
+    size_t payloadLength;
+};
+
+static void ShardMergeCursor_open(
+    struct ShardMergeCursor *cursorOutPtr,
+    ConstShard shard,
+    size_t sequenceStart
+);
+static void ShardMergeCursor_advance(struct ShardMergeCursor *cursorPtr);
+static void ShardMergeCursor_close(struct ShardMergeCursor *cursorPtr);
+
+/**
+ * Create an empty Shard backed by a new file at the given path. Any existing file at the path is overwritten.
+ *
+ * @param filePath The path of the shard's file.
+ *
+ * @returns The newly allocated Shard. The caller is responsible for freeing this memory.
+ */
+Shard Shard_create(char const * const filePath) {
+    guardNotNull(filePath, "filePath", "Shard_create");
+
+    Shard const shard = safeMalloc(sizeof *shard, "Shard_create");
+    shard->filePath = formatString("%s", filePath);
+    shard->file = safeFopen(filePath, "w", "Shard_create");
+
+    shard->lineCount = 0;
+    shard->lastSequenceNumber = 0;
+    shard->checkpointSequenceNumbers = SizeList_create();
+    shard->checkpointOffsets = SizeList_create();
+    return shard;
+}
+
+/**
+ * Delete the shard's file and free the memory associated with the Shard.
+ *
+ * @param shard The Shard instance.
+ */
+void Shard_destroy(Shard const shard) {
+    guardNotNull(shard, "shard", "Shard_destroy");
+
+    if (shard->file != NULL) {
+        fclose(shard->file);
+    }
+    remove(shard->filePath);
+
+    SizeList_destroy(shard->checkpointSequenceNumbers);
+    SizeList_destroy(shard->checkpointOffsets);
+    free(shard->filePath);
+    free(shard);
+}
+
+/**
+ * Append a line to the shard. Lines must be appended in strictly ascending sequence order.
+ *
+ * @param shard The Shard instance.
+ * @param sequenceNumber The line's position in the merged output.
+ * @param lineFormat The line format (printf), terminated by a newline.
+ * @param ... The line format arguments (printf).
+ *
+ * @returns The length of the line, not counting the sequence number tag.
+ */
+size_t Shard_appendFmt(Shard const shard, size_t const sequenceNumber, char const * const lineFormat, ...) {
+    va_list lineFormatArgs;
+    va_start(lineFormatArgs, lineFormat);
+    size_t const lineLength = Shard_appendFmtVA(shard, sequenceNumber, lineFormat, lineFormatArgs);
+    va_end(lineFormatArgs);
+    return lineLength;
+}
+
+/**
+ * Append a line to the shard. Lines must be appended in strictly ascending sequence order.
+ *
+ * @param shard The Shard instance.
+ * @param sequenceNumber The line's position in the merged output.
+ * @param lineFormat The line format (printf), terminated by a newline.
+ * @param lineFormatArgs The line format arguments (printf).
+ *
+ * @returns The length of the line, not counting the sequence number tag.
+ */
+size_t Shard_appendFmtVA(
+    Shard const shard,
+    size_t const sequenceNumber,
+    char const * const lineFormat,
+    va_list lineFormatArgs
+) {
+    guardNotNull(shard, "shard", "Shard_appendFmtVA");
+    guardNotNull(lineFormat, "lineFormat", "Shard_appendFmtVA");
+    guard(shard->file != NULL, "Shard_appendFmtVA: shard has already been finished");
+    guardFmt(
+        shard->lineCount == 0 || sequenceNumber > shard->lastSequenceNumber,
+        "Shard_appendFmtVA: sequence number %zu does not follow %zu",
+        sequenceNumber,
+        shard->lastSequenceNumber
+    );
+
+    if (shard->lineCount % checkpointInterval == 0) {
+        SizeList_add(shard->checkpointSequenceNumbers, sequenceNumber);
+        SizeList_add(shard->checkpointOffsets, (size_t)ftell(shard->file));
+    }
+
+    safeFprintf(shard->file, "Shard_appendFmtVA", "%zu\t", sequenceNumber);
+    unsigned int const lineLength = safeVfprintf(shard->file, lineFormat, lineFormatArgs, "Shard_appendFmtVA");
+
+    shard->lineCount += 1;
+    shard->lastSequenceNumber = sequenceNumber;
+    return lineLength;
+}
+
+/**
+ * Close the shard's file for writing so that it can be merged. No more lines may be appended.
+ *
+ * @param shard The Shard instance.
+ */
+void Shard_finish(Shard const shard) {
+    guardNotNull(shard, "shard", "Shard_finish");
+    guard(shard->file != NULL, "Shard_finish: shard has already been finished");
+
+    safeFclose(shard->file, "Shard_finish");
+    shard->file = NULL;
+}
+
+/**
+ * Merge the lines with sequence numbers in the given range from every shard, writing them to the output file in
+ * sequence order with their sequence-number prefixes removed. Each shard is streamed from its nearest checkpoint, so
+ * several ranges can be merged concurrently. All shards must be finished.
+ *
+ * @param shards The shards.
+ * @param shardCount The number of shards.
+ * @param sequenceStart The first sequence number to merge (inclusive).
+ * @param sequenceEnd The last sequence number to merge (exclusive).
+ * @param outFile The file to write the merged lines to.
+ */
+void Shard_mergeRange(
+    ConstShard const * const shards,
+    size_t const shardCount,
+    size_t const sequenceStart,
+    size_t const sequenceEnd,
+    FILE * const outFile
+) {
+    guardNotNull(shards, "shards", "Shard_mergeRange");
+    guardNotNull(outFile, "outFile", "Shard_mergeRange");
+
+    struct ShardMergeCursor * const cursors = safeMalloc(
+        sizeof *cursors * (shardCount == 0 ? 1 : shardCount),
+        "Shard_mergeRange"
+    );
+    for (size_t i = 0; i < shardCount; i += 1) {
+        ShardMergeCursor_open(&cursors[i], shards[i], sequenceStart);
+    }
+
+    // The shard count is the thread count, so a linear scan for the lowest head is cheaper than maintaining a heap
+    while (true) {
+        struct ShardMergeCursor *lowestCursorPtr = NULL;
+        for (size_t i = 0; i < shardCount; i += 1) {
+            struct ShardMergeCursor * const cursorPtr = &cursors[i];
+            if (cursorPtr->atEnd || cursorPtr->sequenceNumber >= sequenceEnd) {
+                continue;
+            }
+            if (lowestCursorPtr == NULL || cursorPtr->sequenceNumber < lowestCursorPtr->sequenceNumber) {
+                lowestCursorPtr = cursorPtr;
+            }
+        }
+
+        if (lowestCursorPtr == NULL) {
+            break;
+        }
+
+        safeFwrite(lowestCursorPtr->payload, lowestCursorPtr->payloadLength, outFile, "Shard_mergeRange");
+        safeFwrite("\n", 1, outFile, "Shard_mergeRange");
+        ShardMergeCursor_advance(lowestCursorPtr);
+    }
+
+    for (size_t i = 0; i < shardCount; i += 1) {
+        ShardMergeCursor_close(&cursors[i]);
+    }
+    free(cursors);
+}
+
+/**
+ * Open an independent read stream on the shard, positioned at its first line with a sequence number of at least
+ * sequenceStart.
+ */
+static void ShardMergeCursor_open(
+    struct ShardMergeCursor * const cursorOutPtr,
+    ConstShard const shard,
+    size_t const sequenceStart
+) {
+    guard(shard->file == NULL, "Shard_mergeRange: shard has not been finished");
+
+    cursorOutPtr->file = safeFopen(shard->filePath, "r", "Shard_mergeRange");
+    if (setvbuf(cursorOutPtr->file, NULL, _IOFBF, mergeReadBufferSize) != 0) {
+        abortWithErrorFmt("Shard_mergeRange: Failed to set the read buffer of shard \"%s\"", shard->filePath);
+    }
+    cursorOutPtr->line = NULL;
+    cursorOutPtr->lineCapacity = 0;
+    cursorOutPtr->atEnd = false;
+
+    // Seek to the last checkpoint at or before sequenceStart
+    size_t const checkpointCount = SizeList_count(shard->checkpointSequenceNumbers);
+    size_t low = 0;
+    size_t high = checkpointCount;
+    while (low < high) {
+        size_t const middle = low + (high - low) / 2;
+        if (SizeList_get(shard->checkpointSequenceNumbers, middle) <= sequenceStart) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    if (low > 0) {
+        size_t const checkpointOffset = SizeList_get(shard->checkpointOffsets, low - 1);
+        if (fseek(cursorOutPtr->file, (long)checkpointOffset, SEEK_SET) != 0) {
+            int const fseekErrorCode = errno;
+            char const * const fseekErrorMessage = strerror(fseekErrorCode);
+
+            abortWithErrorFmt(
+                "Shard_mergeRange: Failed to seek shard \"%s\" using fseek (error code: %d; error message: \"%s\")",
+                shard->filePath,
+                fseekErrorCode,
+                fseekErrorMessage
+            );
+        }
+    }
+
+    do {
+        ShardMergeCursor_advance(cursorOutPtr);
+    } while (!cursorOutPtr->atEnd && cursorOutPtr->sequenceNumber < sequenceStart);
+}
+
+/**
+ * Replace the cursor's head with the next line of its shard, or mark the cursor as at its end.
+ */
+static void ShardMergeCursor_advance(struct ShardMergeCursor * const cursorPtr) {
+    errno = 0;
+    ssize_t const lineLength = getline(&cursorPtr->line, &cursorPtr->lineCapacity, cursorPtr->file);
+    if (lineLength < 0) {
+        if (ferror(cursorPtr->file)) {
+            int const getlineErrorCode = errno;
+            char const * const getlineErrorMessage = strerror(getlineErrorCode);
+
+            abortWithErrorFmt(
+                "Shard_mergeRange: Failed to read shard line using getline (error code: %d; error message: \"%s\")",
+                getlineErrorCode,
+                getlineErrorMessage
+            );
+        }
+        cursorPtr->atEnd = true;
+        return;
+    }
+    size_t contentLength = (size_t)lineLength;
+    if (contentLength > 0 && cursorPtr->line[contentLength - 1] == '\n') {
+        contentLength -= 1;
+        cursorPtr->line[contentLength] = '\0';
+    }
+
+    char *sequenceNumberEnd;
+    cursorPtr->sequenceNumber = (size_t)strtoull(cursorPtr->line, &sequenceNumberEnd, 10);
+    guardFmt(*sequenceNumberEnd == '\t', "Shard_mergeRange: malformed shard line \"%s\"", cursorPtr->line);
+    cursorPtr->payload = sequenceNumberEnd + 1;
+    cursorPtr->payloadLength = contentLength - (size_t)(cursorPtr->payload - cursorPtr->line);
+}
+
+static void ShardMergeCursor_close(struct ShardMergeCursor * const cursorPtr) {
+    free(cursorPtr->line);
+    fclose(cursorPtr->file);
+}
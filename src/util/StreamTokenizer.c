@@ -0,0 +1,255 @@
+#include "../../include/util/StreamTokenizer.h"
+
+#include "../../include/util/delimiterScan.h"
+#include "../../include/util/string.h"
+#include "../../include/util/memory.h"
+#include "../../include/util/guard.h"
+#include "../../include/util/error.h"
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+
+/** The number of delimiters found per scan of the window. */
+#define DELIMITER_BATCH_LENGTH 256
+
+/**
+ * Splits a file descriptor's contents into lines as they are read, through a fixed-size window, so that any amount of
+ * input (e.g. a pipe from a decompressor) is split in constant memory. Each line is returned as a span into the window,
+ * which is only valid until the next line is requested. Lines are split on newlines the same way as LineTokenizer, and
+ * newlines are likewise found a batch at a time with scanDelimiters.
+ *
+ * When created with a delimiter set, the input is split into words instead, the same way as LineTokenizer.
+ */
+struct StreamTokenizer {
+    int fileDescriptor;
+    char *filePath;
+
+    char *chars;
+    size_t capacity;
+    /** The start of the characters not yet returned. */
+    size_t position;
+    /** The end of the characters read so far. */
+    size_t length;
+    bool endOfFile;
+    /** Whether to split on wordDelimiters rather than newlines. */
+    bool splitsWords;
+    struct DelimiterSet wordDelimiters;
+
+    /** The window offsets of the delimiters found by the last scan, and how many of them have been used. */
+    size_t delimiterOffsets[DELIMITER_BATCH_LENGTH];
+    size_t delimiterCount;
+    size_t delimiterIndex;
+    /** Where the next scan starts. */
+    size_t scanPosition;
+};
+
+static void StreamTokenizer_scan(StreamTokenizer tokenizer);
+static void StreamTokenizer_fill(StreamTokenizer tokenizer);
+
+/**
+ * Create a StreamTokenizer which reads from the given file descriptor.
+ *
+ * @param fileDescriptor The file descriptor, positioned where splitting should start. The tokenizer does not take
+ *                       ownership of it.
+ * @param windowCapacity The size of the window the input is read into. Must be positive. The window only grows beyond
+ *                       this to hold a single line longer than it.
+ * @param filePath The path the file descriptor was opened from, to be included in error messages.
+ *
+ * @returns The newly allocated StreamTokenizer. The caller is responsible for freeing this memory.
+ */
+StreamTokenizer StreamTokenizer_create(
+    int const fileDescriptor,
+    size_t const windowCapacity,
+    char const * const filePath
+) {
+    guard(fileDescriptor >= 0, "StreamTokenizer_create: fileDescriptor must not be negative");
+    guard(windowCapacity > 0, "StreamTokenizer_create: windowCapacity must be positive");
+    guardNotNull(filePath, "filePath", "StreamTokenizer_create");
+
+    StreamTokenizer const tokenizer = safeMalloc(sizeof *tokenizer, "StreamTokenizer_create");
+    tokenizer->fileDescriptor = fileDescriptor;
+    tokenizer->filePath = formatString("%s", filePath);
+    tokenizer->chars = safeMalloc(windowCapacity, "StreamTokenizer_create");
+    tokenizer->capacity = windowCapacity;
+    tokenizer->position = 0;
+    tokenizer->length = 0;
+    tokenizer->endOfFile = false;
+    tokenizer->splitsWords = false;
+    tokenizer->delimiterCount = 0;
+    tokenizer->delimiterIndex = 0;
+    tokenizer->scanPosition = 0;
+    return tokenizer;
+}
+
+/**
+ * Create a StreamTokenizer which splits the input read from the given file descriptor into words separated by runs of
+ * delimiters.
+ *
+ * @param fileDescriptor The file descriptor, positioned where splitting should start. The tokenizer does not take
+ *                       ownership of it.
+ * @param windowCapacity The size of the window the input is read into. Must be positive. The window only grows beyond
+ *                       this to hold a single word longer than it.
+ * @param filePath The path the file descriptor was opened from, to be included in error messages.
+ * @param wordDelimitersPtr The delimiters, e.g. whitespace. The tokenizer keeps a copy of them.
+ *
+ * @returns The newly allocated StreamTokenizer. The caller is responsible for freeing this memory.
+ */
+StreamTokenizer StreamTokenizer_createWords(
+    int const fileDescriptor,
+    size_t const windowCapacity,
+    char const * const filePath,
+    struct DelimiterSet const * const wordDelimitersPtr
+) {
+    guardNotNull(wordDelimitersPtr, "wordDelimitersPtr", "StreamTokenizer_createWords");
+
+    StreamTokenizer const tokenizer = StreamTokenizer_create(fileDescriptor, windowCapacity, filePath);
+    tokenizer->splitsWords = true;
+    tokenizer->wordDelimiters = *wordDelimitersPtr;
+    return tokenizer;
+}
+
+/**
+ * Free the memory associated with the StreamTokenizer. This does not close the file descriptor.
+ *
+ * @param tokenizer The StreamTokenizer instance.
+ */
+void StreamTokenizer_destroy(StreamTokenizer const tokenizer) {
+    guardNotNull(tokenizer, "tokenizer", "StreamTokenizer_destroy");
+
+    free(tokenizer->chars);
+    free(tokenizer->filePath);
+    free(tokenizer);
+}
+
+/**
+ * Advance to the next line, or the next non-empty word if created with StreamTokenizer_createWords, reading more of the
+ * input if the window does not hold a whole one. The span excludes its terminating delimiter. If reading fails, abort
+ * the program with an error message.
+ *
+ * @param tokenizer The StreamTokenizer instance.
+ * @param lineOutPtr The location to store the line's span. It is only valid until the next call.
+ *
+ * @returns Whether a line was found, or false if the end of the input was reached.
+ */
+bool StreamTokenizer_next(StreamTokenizer const tokenizer, struct StringSpan * const lineOutPtr) {
+    guardNotNull(tokenizer, "tokenizer", "StreamTokenizer_next");
+    guardNotNull(lineOutPtr, "lineOutPtr", "StreamTokenizer_next");
+
+    while (true) {
+        if (tokenizer->delimiterIndex == tokenizer->delimiterCount && tokenizer->scanPosition < tokenizer->length) {
+            StreamTokenizer_scan(tokenizer);
+        }
+
+        size_t const remainingLength = tokenizer->length - tokenizer->position;
+        if (tokenizer->delimiterIndex < tokenizer->delimiterCount || (tokenizer->endOfFile && remainingLength > 0)) {
+            // Without a delimiter left at the end of the input, the rest of the window is the last line
+            size_t lineEnd = tokenizer->length;
+            if (tokenizer->delimiterIndex < tokenizer->delimiterCount) {
+                lineEnd = tokenizer->delimiterOffsets[tokenizer->delimiterIndex];
+                tokenizer->delimiterIndex += 1;
+            }
+
+            lineOutPtr->chars = &tokenizer->chars[tokenizer->position];
+            lineOutPtr->length = lineEnd - tokenizer->position;
+            tokenizer->position = lineEnd == tokenizer->length ? lineEnd : lineEnd + 1;
+            if (!tokenizer->splitsWords || lineOutPtr->length > 0) {
+                return true;
+            }
+            continue;
+        }
+        if (tokenizer->endOfFile) {
+            return false;
+        }
+
+        StreamTokenizer_fill(tokenizer);
+    }
+}
+
+/**
+ * Find the next batch of delimiters in the window after the last scan. Every delimiter found so far must have been
+ * used.
+ *
+ * @param tokenizer The StreamTokenizer instance.
+ */
+static void StreamTokenizer_scan(StreamTokenizer const tokenizer) {
+    char const * const scanChars = &tokenizer->chars[tokenizer->scanPosition];
+    size_t const scanLength = tokenizer->length - tokenizer->scanPosition;
+
+    size_t scannedLength;
+    if (!tokenizer->splitsWords) {
+        tokenizer->delimiterCount = scanDelimiters(
+            scanChars,
+            scanLength,
+            '\n',
+            tokenizer->delimiterOffsets,
+            DELIMITER_BATCH_LENGTH,
+            &scannedLength
+        );
+    } else {
+        tokenizer->delimiterCount = scanDelimiterSet(
+            scanChars,
+            scanLength,
+            &tokenizer->wordDelimiters,
+            tokenizer->delimiterOffsets,
+            DELIMITER_BATCH_LENGTH,
+            &scannedLength
+        );
+    }
+    for (size_t i = 0; i < tokenizer->delimiterCount; i += 1) {
+        tokenizer->delimiterOffsets[i] += tokenizer->scanPosition;
+    }
+    tokenizer->delimiterIndex = 0;
+    tokenizer->scanPosition += scannedLength;
+}
+
+/**
+ * Move the partial line to the start of the window, then read as much as fits after it. A partial line which already
+ * fills the window doubles it. Every delimiter found so far must have been used.
+ *
+ * @param tokenizer The StreamTokenizer instance.
+ */
+static void StreamTokenizer_fill(StreamTokenizer const tokenizer) {
+    size_t const remainingLength = tokenizer->length - tokenizer->position;
+    if (tokenizer->position > 0) {
+        memmove(tokenizer->chars, &tokenizer->chars[tokenizer->position], remainingLength);
+        tokenizer->scanPosition -= tokenizer->position;
+        tokenizer->position = 0;
+        tokenizer->length = remainingLength;
+    }
+    if (tokenizer->length == tokenizer->capacity) {
+        tokenizer->capacity *= 2;
+        tokenizer->chars = safeRealloc(tokenizer->chars, tokenizer->capacity, "StreamTokenizer_fill");
+    }
+
+    while (true) {
+        ssize_t const readResult = read(
+            tokenizer->fileDescriptor,
+            &tokenizer->chars[tokenizer->length],
+            tokenizer->capacity - tokenizer->length
+        );
+        if (readResult < 0) {
+            int const readErrorCode = errno;
+            if (readErrorCode == EINTR) {
+                continue;
+            }
+
+            char const * const readErrorMessage = strerror(readErrorCode);
+            abortWithErrorFmt(
+                "StreamTokenizer_fill: Failed to read file \"%s\" using read (error code: %d; error message: \"%s\")",
+                tokenizer->filePath,
+                readErrorCode,
+                readErrorMessage
+            );
+            return;
+        }
+
+        if (readResult == 0) {
+            tokenizer->endOfFile = true;
+        }
+        tokenizer->length += (size_t)readResult;
+        return;
+    }
+}
@@ -306,6 +306,16 @@ void StringBuilder_removeManyAt(StringBuilder const builder, size_t const startI
     CharList_removeManyAt(builder->chars, startIndex, count);
 }
 
+/**
+ * Remove every character from the current value, keeping the allocated capacity for reuse.
+ *
+ * @param builder The StringBuilder instance.
+ */
+void StringBuilder_clear(StringBuilder const builder) {
+    guardNotNull(builder, "builder", "StringBuilder_clear");
+    CharList_clear(builder->chars);
+}
+
 /**
  * Convert the current value to a string.
  *
@@ -0,0 +1,214 @@
+#define _GNU_SOURCE
+
+#include "../../include/util/ThreadStats.h"
+
+#include "../../include/util/thread.h"
+#include "../../include/util/time.h"
+#include "../../include/util/guard.h"
+#include "../../include/util/error.h"
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <string.h>
+#include <stdio.h>
+#include <errno.h>
+#include <pthread.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+
+static void readThreadUsage(struct ThreadUsage *usageOutPtr);
+
+/**
+ * Zero the counters.
+ *
+ * @param statsOutPtr The stats to initialize.
+ */
+void ThreadStats_init(struct ThreadStats * const statsOutPtr) {
+    guardNotNull(statsOutPtr, "statsOutPtr", "ThreadStats_init");
+
+    *statsOutPtr = (struct ThreadStats){
+        .wordCount = 0,
+        .byteCount = 0,
+        .lockWaitNanoseconds = 0,
+        .maxLockWaitNanoseconds = 0,
+        .lockHoldNanoseconds = 0,
+        .sleepNanoseconds = 0,
+        .userCpuNanoseconds = 0,
+        .systemCpuNanoseconds = 0,
+        .voluntaryContextSwitches = 0,
+        .involuntaryContextSwitches = 0,
+        .lockAcquireCycles = 0,
+        .usageBegun = false,
+        .usageBaseline = { 0, 0, 0, 0 }
+    };
+}
+
+/**
+ * Lock the mutex, counting how long the thread waited for it. Release it with ThreadStats_unlockMutex.
+ *
+ * @param statsPtr The calling thread's stats.
+ * @param mutexPtr The mutex.
+ * @param callerDescription A description of the caller to be included in the error message if locking fails.
+ */
+void ThreadStats_lockMutex(
+    struct ThreadStats * const statsPtr,
+    pthread_mutex_t * const mutexPtr,
+    char const * const callerDescription
+) {
+    uint64_t const requestCycles = cycleCount();
+    safeMutexLock(mutexPtr, callerDescription);
+    statsPtr->lockAcquireCycles = cycleCount();
+
+    ThreadStats_addLockTimes(statsPtr, elapsedCycleNanoseconds(requestCycles, statsPtr->lockAcquireCycles), 0);
+}
+
+/**
+ * Unlock a mutex locked with ThreadStats_lockMutex, counting how long the thread held it.
+ *
+ * @param statsPtr The calling thread's stats.
+ * @param mutexPtr The mutex.
+ * @param callerDescription A description of the caller to be included in the error message if unlocking fails.
+ */
+void ThreadStats_unlockMutex(
+    struct ThreadStats * const statsPtr,
+    pthread_mutex_t * const mutexPtr,
+    char const * const callerDescription
+) {
+    safeMutexUnlock(mutexPtr, callerDescription);
+    ThreadStats_addLockTimes(statsPtr, 0, elapsedCycleNanoseconds(statsPtr->lockAcquireCycles, cycleCount()));
+}
+
+/**
+ * Count lock wait and hold times that the caller measured itself.
+ *
+ * @param statsPtr The calling thread's stats.
+ * @param waitNanoseconds How long one lock acquisition waited.
+ * @param holdNanoseconds How long the lock was held.
+ */
+void ThreadStats_addLockTimes(
+    struct ThreadStats * const statsPtr,
+    uint64_t const waitNanoseconds,
+    uint64_t const holdNanoseconds
+) {
+    statsPtr->lockWaitNanoseconds += waitNanoseconds;
+    if (waitNanoseconds > statsPtr->maxLockWaitNanoseconds) {
+        statsPtr->maxLockWaitNanoseconds = waitNanoseconds;
+    }
+    statsPtr->lockHoldNanoseconds += holdNanoseconds;
+}
+
+/**
+ * Count processed words.
+ *
+ * @param statsPtr The calling thread's stats.
+ * @param wordCount The number of words.
+ * @param byteCount The number of bytes written for the words.
+ */
+void ThreadStats_addWords(struct ThreadStats * const statsPtr, uint64_t const wordCount, uint64_t const byteCount) {
+    statsPtr->wordCount += wordCount;
+    statsPtr->byteCount += byteCount;
+}
+
+/**
+ * Count time spent sleeping.
+ *
+ * @param statsPtr The calling thread's stats.
+ * @param sleepNanoseconds How long the thread slept.
+ */
+void ThreadStats_addSleep(struct ThreadStats * const statsPtr, uint64_t const sleepNanoseconds) {
+    statsPtr->sleepNanoseconds += sleepNanoseconds;
+}
+
+/**
+ * Mark the start of the work the stats describe, so that ThreadStats_captureUsage counts only the calling thread's
+ * usage from here on. Call this from the thread the stats belong to, before its first unit of work; later calls do
+ * nothing. Threads which only ever do this work (rather than being reused, e.g. from a ThreadPool) need not call it.
+ *
+ * @param statsPtr The calling thread's stats.
+ */
+void ThreadStats_beginUsage(struct ThreadStats * const statsPtr) {
+    if (statsPtr->usageBegun) {
+        return;
+    }
+
+    readThreadUsage(&statsPtr->usageBaseline);
+    statsPtr->usageBegun = true;
+}
+
+/**
+ * Record the calling thread's CPU time and context switches so far. Call this from the thread the stats belong to,
+ * after its last unit of work. If the operation fails, abort the program with an error message.
+ *
+ * @param statsPtr The calling thread's stats.
+ */
+void ThreadStats_captureUsage(struct ThreadStats * const statsPtr) {
+    struct ThreadUsage usage = { 0, 0, 0, 0 };
+    readThreadUsage(&usage);
+
+    struct ThreadUsage const * const baselinePtr = &statsPtr->usageBaseline;
+    statsPtr->userCpuNanoseconds = usage.userCpuNanoseconds - baselinePtr->userCpuNanoseconds;
+    statsPtr->systemCpuNanoseconds = usage.systemCpuNanoseconds - baselinePtr->systemCpuNanoseconds;
+    statsPtr->voluntaryContextSwitches = usage.voluntaryContextSwitches - baselinePtr->voluntaryContextSwitches;
+    statsPtr->involuntaryContextSwitches = usage.involuntaryContextSwitches - baselinePtr->involuntaryContextSwitches;
+}
+
+/**
+ * Write the stats as a single-line JSON object.
+ *
+ * @param statsPtr The stats.
+ * @param threadNumber The number of the thread the stats belong to.
+ * @param outFile The file to write to.
+ */
+void ThreadStats_writeJson(
+    struct ThreadStats const * const statsPtr,
+    unsigned int const threadNumber,
+    FILE * const outFile
+) {
+    guardNotNull(statsPtr, "statsPtr", "ThreadStats_writeJson");
+    guardNotNull(outFile, "outFile", "ThreadStats_writeJson");
+
+    fprintf(
+        outFile,
+        "{\"threadNumber\": %u, \"words\": %" PRIu64 ", \"bytes\": %" PRIu64 ", \"lockWaitNanoseconds\": %" PRIu64
+        ", \"maxLockWaitNanoseconds\": %" PRIu64 ", \"lockHoldNanoseconds\": %" PRIu64 ", \"sleepNanoseconds\": %"
+        PRIu64 ", \"userCpuNanoseconds\": %" PRIu64 ", \"systemCpuNanoseconds\": %" PRIu64
+        ", \"voluntaryContextSwitches\": %" PRIu64 ", \"involuntaryContextSwitches\": %" PRIu64 "}",
+        threadNumber,
+        statsPtr->wordCount,
+        statsPtr->byteCount,
+        statsPtr->lockWaitNanoseconds,
+        statsPtr->maxLockWaitNanoseconds,
+        statsPtr->lockHoldNanoseconds,
+        statsPtr->sleepNanoseconds,
+        statsPtr->userCpuNanoseconds,
+        statsPtr->systemCpuNanoseconds,
+        statsPtr->voluntaryContextSwitches,
+        statsPtr->involuntaryContextSwitches
+    );
+}
+
+/**
+ * Get the calling thread's usage so far. If the operation fails, abort the program with an error message.
+ *
+ * @param usageOutPtr The location to store the usage.
+ */
+static void readThreadUsage(struct ThreadUsage * const usageOutPtr) {
+    struct rusage usage;
+    if (getrusage(RUSAGE_THREAD, &usage) != 0) {
+        int const getrusageErrorCode = errno;
+        char const * const getrusageErrorMessage = strerror(getrusageErrorCode);
+
+        abortWithErrorFmt(
+            "ThreadStats: Failed to get thread resource usage using getrusage (error code: %d; error message: \"%s\")",
+            getrusageErrorCode,
+            getrusageErrorMessage
+        );
+        return;
+    }
+
+    usageOutPtr->userCpuNanoseconds = timevalToNanoseconds(usage.ru_utime);
+    usageOutPtr->systemCpuNanoseconds = timevalToNanoseconds(usage.ru_stime);
+    usageOutPtr->voluntaryContextSwitches = (uint64_t)usage.ru_nvcsw;
+    usageOutPtr->involuntaryContextSwitches = (uint64_t)usage.ru_nivcsw;
+}
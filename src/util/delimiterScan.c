@@ -0,0 +1,523 @@
+#include "../../include/util/delimiterScan.h"
+
+#include "../../include/util/guard.h"
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#define DELIMITER_SCAN_X86 1
+#else
+#define DELIMITER_SCAN_X86 0
+#endif
+
+/**
+ * The number of characters compared per step. Each step produces a bit mask with one bit per character, set where the
+ * character is a delimiter.
+ */
+#define BLOCK_LENGTH 64
+
+/**
+ * The scan loop shared by every instruction set and kind of delimiter, expanded as the body of each scan function so
+ * that blockMask (which compares BLOCK_LENGTH characters) and isDelimiter (which tests one of the characters after the
+ * last whole block) are called directly and inlined, even in unoptimized builds. It uses the enclosing function's
+ * chars, length, offsetsOut, offsetCapacity, and scannedLengthOutPtr parameters, and returns from it.
+ */
+#define SCAN_WITH(blockMask, isDelimiter, context) \
+    size_t offsetCount = 0; \
+    \
+    size_t blockStart = 0; \
+    for (; blockStart + BLOCK_LENGTH <= length; blockStart += BLOCK_LENGTH) { \
+        uint64_t mask = blockMask(chars + blockStart, context); \
+        while (mask != 0) { \
+            size_t const offset = blockStart + (size_t)__builtin_ctzll(mask); \
+            mask &= mask - 1; \
+            \
+            offsetsOut[offsetCount] = offset; \
+            offsetCount += 1; \
+            if (offsetCount == offsetCapacity) { \
+                *scannedLengthOutPtr = offset + 1; \
+                return offsetCount; \
+            } \
+        } \
+    } \
+    \
+    for (size_t offset = blockStart; offset < length; offset += 1) { \
+        if (isDelimiter(chars[offset], context)) { \
+            offsetsOut[offsetCount] = offset; \
+            offsetCount += 1; \
+            if (offsetCount == offsetCapacity) { \
+                *scannedLengthOutPtr = offset + 1; \
+                return offsetCount; \
+            } \
+        } \
+    } \
+    \
+    *scannedLengthOutPtr = length; \
+    return offsetCount
+
+typedef size_t (*CharScanFunction)(
+    char const *chars,
+    size_t length,
+    char delimiter,
+    size_t *offsetsOut,
+    size_t offsetCapacity,
+    size_t *scannedLengthOutPtr
+);
+typedef size_t (*SetScanFunction)(
+    char const *chars,
+    size_t length,
+    struct DelimiterSet const *delimitersPtr,
+    size_t *offsetsOut,
+    size_t offsetCapacity,
+    size_t *scannedLengthOutPtr
+);
+
+static CharScanFunction selectCharScan(void);
+static SetScanFunction selectSetScan(struct DelimiterSet const *delimitersPtr);
+
+static inline bool isChar(char c, void const *context);
+static inline bool isInSet(char c, void const *context);
+
+static size_t scanCharScalar(
+    char const *chars,
+    size_t length,
+    char delimiter,
+    size_t *offsetsOut,
+    size_t offsetCapacity,
+    size_t *scannedLengthOutPtr
+);
+static size_t scanSetScalar(
+    char const *chars,
+    size_t length,
+    struct DelimiterSet const *delimitersPtr,
+    size_t *offsetsOut,
+    size_t offsetCapacity,
+    size_t *scannedLengthOutPtr
+);
+static inline uint64_t blockMaskCharScalar(char const *chars, void const *context);
+static inline uint64_t blockMaskSetScalar(char const *chars, void const *context);
+#if DELIMITER_SCAN_X86
+static size_t scanCharSse2(
+    char const *chars,
+    size_t length,
+    char delimiter,
+    size_t *offsetsOut,
+    size_t offsetCapacity,
+    size_t *scannedLengthOutPtr
+);
+static size_t scanCharAvx2(
+    char const *chars,
+    size_t length,
+    char delimiter,
+    size_t *offsetsOut,
+    size_t offsetCapacity,
+    size_t *scannedLengthOutPtr
+);
+static size_t scanSetSsse3(
+    char const *chars,
+    size_t length,
+    struct DelimiterSet const *delimitersPtr,
+    size_t *offsetsOut,
+    size_t offsetCapacity,
+    size_t *scannedLengthOutPtr
+);
+static size_t scanSetAvx2(
+    char const *chars,
+    size_t length,
+    struct DelimiterSet const *delimitersPtr,
+    size_t *offsetsOut,
+    size_t offsetCapacity,
+    size_t *scannedLengthOutPtr
+);
+static inline uint64_t blockMaskCharSse2(char const *chars, void const *context);
+static inline uint64_t blockMaskCharAvx2(char const *chars, void const *context)
+    __attribute__((target("avx2")));
+static inline uint64_t blockMaskSetSsse3(char const *chars, void const *context)
+    __attribute__((target("ssse3")));
+static inline uint64_t blockMaskSetAvx2(char const *chars, void const *context)
+    __attribute__((target("avx2")));
+#endif
+
+/**
+ * Find the delimiters in a buffer, many at a time: BLOCK_LENGTH characters are compared per step using AVX2 or SSE2
+ * when the CPU supports them, or 8 at a time in a portable scalar fallback. This lets a whole buffer be tokenized in a
+ * few calls instead of one memchr per token.
+ *
+ * @param chars The characters to scan, or null if length is 0.
+ * @param length The number of characters.
+ * @param delimiter The delimiter character, e.g. '\n'.
+ * @param offsetsOut Where to store the offset of each delimiter found, relative to chars, in increasing order.
+ * @param offsetCapacity The number of offsets offsetsOut can hold. Must be positive.
+ * @param scannedLengthOutPtr The location to store how many characters were scanned: length if fewer than
+ *                            offsetCapacity delimiters were found, otherwise just past the last delimiter stored. The
+ *                            next scan should start there.
+ *
+ * @returns The number of delimiters found and stored in offsetsOut.
+ */
+size_t scanDelimiters(
+    char const * const chars,
+    size_t const length,
+    char const delimiter,
+    size_t * const offsetsOut,
+    size_t const offsetCapacity,
+    size_t * const scannedLengthOutPtr
+) {
+    guard(chars != NULL || length == 0, "scanDelimiters: chars must not be null unless length is 0");
+    guardNotNull(offsetsOut, "offsetsOut", "scanDelimiters");
+    guard(offsetCapacity > 0, "scanDelimiters: offsetCapacity must be positive");
+    guardNotNull(scannedLengthOutPtr, "scannedLengthOutPtr", "scanDelimiters");
+
+    return selectCharScan()(
+        chars,
+        length,
+        delimiter,
+        offsetsOut,
+        offsetCapacity,
+        scannedLengthOutPtr
+    );
+}
+
+/**
+ * Get the name of the instruction set scanDelimiters uses on this CPU: "avx2", "sse2", or "scalar".
+ */
+char const *delimiterScanImplementation(void) {
+    CharScanFunction const scan = selectCharScan();
+#if DELIMITER_SCAN_X86
+    if (scan == scanCharAvx2) {
+        return "avx2";
+    }
+    if (scan == scanCharSse2) {
+        return "sse2";
+    }
+#endif
+    return "scalar";
+}
+
+/**
+ * Initialize a set of delimiter characters, along with the nibble lookup tables that let scanDelimiterSet classify 16
+ * or 32 characters at once with a byte shuffle.
+ *
+ * Every distinct high nibble among the delimiters is given its own bucket bit. A character is a delimiter exactly when
+ * the bucket of its high nibble is among the buckets listed for its low nibble. With 8 bits per table entry, this is
+ * exact for delimiters with at most 8 distinct high nibbles, which covers whitespace plus a handful of custom bytes;
+ * larger sets are classified with the scalar bitmap instead.
+ *
+ * @param setOutPtr The memory where the set should be initialized.
+ * @param delimiters The delimiter characters, or null if delimiterCount is 0. Duplicates are allowed.
+ * @param delimiterCount The number of delimiter characters.
+ */
+void DelimiterSet_init(
+    struct DelimiterSet * const setOutPtr,
+    char const * const delimiters,
+    size_t const delimiterCount
+) {
+    guardNotNull(setOutPtr, "setOutPtr", "DelimiterSet_init");
+    guard(
+        delimiters != NULL || delimiterCount == 0,
+        "DelimiterSet_init: delimiters must not be null unless delimiterCount is 0"
+    );
+
+    memset(setOutPtr, 0, sizeof *setOutPtr);
+    setOutPtr->vectorizable = true;
+
+    unsigned int bucketCount = 0;
+    for (size_t i = 0; i < delimiterCount; i += 1) {
+        uint8_t const delimiter = (uint8_t)delimiters[i];
+        setOutPtr->members[delimiter / 64] |= UINT64_C(1) << (delimiter % 64);
+
+        size_t const highNibble = delimiter >> 4;
+        size_t const lowNibble = delimiter & 0x0f;
+        if (setOutPtr->highNibbleBuckets[highNibble] == 0) {
+            if (bucketCount == 8) {
+                setOutPtr->vectorizable = false;
+                continue;
+            }
+            setOutPtr->highNibbleBuckets[highNibble] = (uint8_t)(1u << bucketCount);
+            bucketCount += 1;
+        }
+        setOutPtr->lowNibbleBuckets[lowNibble] |= setOutPtr->highNibbleBuckets[highNibble];
+    }
+}
+
+/**
+ * Get whether a character is in a delimiter set.
+ *
+ * @param setPtr The set.
+ * @param c The character.
+ *
+ * @returns Whether c is one of the set's delimiters.
+ */
+bool DelimiterSet_has(struct DelimiterSet const * const setPtr, char const c) {
+    guardNotNull(setPtr, "setPtr", "DelimiterSet_has");
+    return isInSet(c, setPtr);
+}
+
+/**
+ * Find the characters of a delimiter set in a buffer, many at a time: BLOCK_LENGTH characters are classified per step
+ * with byte-shuffle table lookups using AVX2 or SSSE3 when the CPU supports them, or one at a time against the set's
+ * bitmap otherwise. Results are returned the same way as scanDelimiters.
+ *
+ * @param chars The characters to scan, or null if length is 0.
+ * @param length The number of characters.
+ * @param delimitersPtr The delimiter set.
+ * @param offsetsOut Where to store the offset of each delimiter found, relative to chars, in increasing order.
+ * @param offsetCapacity The number of offsets offsetsOut can hold. Must be positive.
+ * @param scannedLengthOutPtr The location to store how many characters were scanned: length if fewer than
+ *                            offsetCapacity delimiters were found, otherwise just past the last delimiter stored. The
+ *                            next scan should start there.
+ *
+ * @returns The number of delimiters found and stored in offsetsOut.
+ */
+size_t scanDelimiterSet(
+    char const * const chars,
+    size_t const length,
+    struct DelimiterSet const * const delimitersPtr,
+    size_t * const offsetsOut,
+    size_t const offsetCapacity,
+    size_t * const scannedLengthOutPtr
+) {
+    guard(chars != NULL || length == 0, "scanDelimiterSet: chars must not be null unless length is 0");
+    guardNotNull(delimitersPtr, "delimitersPtr", "scanDelimiterSet");
+    guardNotNull(offsetsOut, "offsetsOut", "scanDelimiterSet");
+    guard(offsetCapacity > 0, "scanDelimiterSet: offsetCapacity must be positive");
+    guardNotNull(scannedLengthOutPtr, "scannedLengthOutPtr", "scanDelimiterSet");
+
+    return selectSetScan(delimitersPtr)(
+        chars,
+        length,
+        delimitersPtr,
+        offsetsOut,
+        offsetCapacity,
+        scannedLengthOutPtr
+    );
+}
+
+/**
+ * Choose the single delimiter scan using the widest block comparison the CPU supports. x86-64 always has SSE2.
+ */
+static CharScanFunction selectCharScan(void) {
+#if DELIMITER_SCAN_X86
+    if (__builtin_cpu_supports("avx2")) {
+        return scanCharAvx2;
+    }
+    return scanCharSse2;
+#else
+    return scanCharScalar;
+#endif
+}
+
+/**
+ * Choose the delimiter set scan using the widest byte shuffle the CPU supports, if the set fits the nibble tables.
+ */
+static SetScanFunction selectSetScan(struct DelimiterSet const * const delimitersPtr) {
+#if DELIMITER_SCAN_X86
+    if (delimitersPtr->vectorizable) {
+        if (__builtin_cpu_supports("avx2")) {
+            return scanSetAvx2;
+        }
+        if (__builtin_cpu_supports("ssse3")) {
+            return scanSetSsse3;
+        }
+    }
+#endif
+    return scanSetScalar;
+}
+
+static inline bool isChar(char const c, void const * const context) {
+    char const * const delimiterPtr = context;
+    return c == *delimiterPtr;
+}
+
+static inline bool isInSet(char const c, void const * const context) {
+    struct DelimiterSet const * const setPtr = context;
+    uint8_t const byte = (uint8_t)c;
+    return ((setPtr->members[byte / 64] >> (byte % 64)) & 1) != 0;
+}
+
+static size_t scanCharScalar(
+    char const * const chars,
+    size_t const length,
+    char const delimiter,
+    size_t * const offsetsOut,
+    size_t const offsetCapacity,
+    size_t * const scannedLengthOutPtr
+) {
+    SCAN_WITH(blockMaskCharScalar, isChar, &delimiter);
+}
+
+static size_t scanSetScalar(
+    char const * const chars,
+    size_t const length,
+    struct DelimiterSet const * const delimitersPtr,
+    size_t * const offsetsOut,
+    size_t const offsetCapacity,
+    size_t * const scannedLengthOutPtr
+) {
+    SCAN_WITH(blockMaskSetScalar, isInSet, delimitersPtr);
+}
+
+#if DELIMITER_SCAN_X86
+static size_t scanCharSse2(
+    char const * const chars,
+    size_t const length,
+    char const delimiter,
+    size_t * const offsetsOut,
+    size_t const offsetCapacity,
+    size_t * const scannedLengthOutPtr
+) {
+    SCAN_WITH(blockMaskCharSse2, isChar, &delimiter);
+}
+
+__attribute__((target("avx2")))
+static size_t scanCharAvx2(
+    char const * const chars,
+    size_t const length,
+    char const delimiter,
+    size_t * const offsetsOut,
+    size_t const offsetCapacity,
+    size_t * const scannedLengthOutPtr
+) {
+    SCAN_WITH(blockMaskCharAvx2, isChar, &delimiter);
+}
+
+__attribute__((target("ssse3")))
+static size_t scanSetSsse3(
+    char const * const chars,
+    size_t const length,
+    struct DelimiterSet const * const delimitersPtr,
+    size_t * const offsetsOut,
+    size_t const offsetCapacity,
+    size_t * const scannedLengthOutPtr
+) {
+    SCAN_WITH(blockMaskSetSsse3, isInSet, delimitersPtr);
+}
+
+__attribute__((target("avx2")))
+static size_t scanSetAvx2(
+    char const * const chars,
+    size_t const length,
+    struct DelimiterSet const * const delimitersPtr,
+    size_t * const offsetsOut,
+    size_t const offsetCapacity,
+    size_t * const scannedLengthOutPtr
+) {
+    SCAN_WITH(blockMaskSetAvx2, isInSet, delimitersPtr);
+}
+#endif
+
+/**
+ * Compare a block 8 characters at a time within a 64-bit word: a byte of the word XOR the repeated delimiter is zero
+ * exactly where the character is the delimiter, and adding 0x7f to each byte's low 7 bits carries into its high bit
+ * unless the byte is zero.
+ */
+static inline uint64_t blockMaskCharScalar(char const * const chars, void const * const context) {
+    char const * const delimiterPtr = context;
+    uint64_t const lowBits = UINT64_C(0x7f7f7f7f7f7f7f7f);
+    uint64_t const repeatedDelimiter = UINT64_C(0x0101010101010101) * (uint8_t)*delimiterPtr;
+
+    uint64_t mask = 0;
+    for (size_t wordStart = 0; wordStart < BLOCK_LENGTH; wordStart += 8) {
+        uint64_t word;
+        memcpy(&word, chars + wordStart, sizeof word);
+        uint64_t const difference = word ^ repeatedDelimiter;
+        uint64_t const matchHighBits = ~(((difference & lowBits) + lowBits) | difference | lowBits);
+
+        // Gather the high bit of each byte into one byte, first character lowest
+        uint64_t const wordMask = ((matchHighBits >> 7) * UINT64_C(0x0102040810204080)) >> 56;
+        mask |= wordMask << wordStart;
+    }
+    return mask;
+}
+
+static inline uint64_t blockMaskSetScalar(char const * const chars, void const * const context) {
+    uint64_t mask = 0;
+    for (size_t i = 0; i < BLOCK_LENGTH; i += 1) {
+        if (isInSet(chars[i], context)) {
+            mask |= UINT64_C(1) << i;
+        }
+    }
+    return mask;
+}
+
+#if DELIMITER_SCAN_X86
+static inline uint64_t blockMaskCharSse2(char const * const chars, void const * const context) {
+    char const * const delimiterPtr = context;
+    __m128i const repeatedDelimiter = _mm_set1_epi8(*delimiterPtr);
+
+    uint64_t mask = 0;
+    for (size_t vectorStart = 0; vectorStart < BLOCK_LENGTH; vectorStart += 16) {
+        __m128i const vector = _mm_loadu_si128((__m128i const *)(void const *)(chars + vectorStart));
+        uint32_t const vectorMask = (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(vector, repeatedDelimiter));
+        mask |= (uint64_t)vectorMask << vectorStart;
+    }
+    return mask;
+}
+
+static inline uint64_t blockMaskCharAvx2(char const * const chars, void const * const context) {
+    char const * const delimiterPtr = context;
+    __m256i const repeatedDelimiter = _mm256_set1_epi8(*delimiterPtr);
+
+    __m256i const low = _mm256_loadu_si256((__m256i const *)(void const *)chars);
+    __m256i const high = _mm256_loadu_si256((__m256i const *)(void const *)(chars + 32));
+    uint32_t const lowMask = (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(low, repeatedDelimiter));
+    uint32_t const highMask = (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(high, repeatedDelimiter));
+    return (uint64_t)highMask << 32 | lowMask;
+}
+
+/**
+ * Classify a block 16 characters at a time: look up the buckets of each character's low and high nibbles with pshufb,
+ * and mark the characters whose buckets intersect. The high nibble is isolated after a 16-bit shift, since SSE has no
+ * 8-bit shift.
+ */
+static inline uint64_t blockMaskSetSsse3(char const * const chars, void const * const context) {
+    struct DelimiterSet const * const setPtr = context;
+    __m128i const lowNibbleBuckets = _mm_loadu_si128((__m128i const *)(void const *)setPtr->lowNibbleBuckets);
+    __m128i const highNibbleBuckets = _mm_loadu_si128((__m128i const *)(void const *)setPtr->highNibbleBuckets);
+    __m128i const nibbleBits = _mm_set1_epi8(0x0f);
+    __m128i const zero = _mm_setzero_si128();
+
+    uint64_t mask = 0;
+    for (size_t vectorStart = 0; vectorStart < BLOCK_LENGTH; vectorStart += 16) {
+        __m128i const vector = _mm_loadu_si128((__m128i const *)(void const *)(chars + vectorStart));
+        __m128i const lowBuckets = _mm_shuffle_epi8(lowNibbleBuckets, _mm_and_si128(vector, nibbleBits));
+        __m128i const highBuckets = _mm_shuffle_epi8(
+            highNibbleBuckets,
+            _mm_and_si128(_mm_srli_epi16(vector, 4), nibbleBits)
+        );
+        __m128i const isOther = _mm_cmpeq_epi8(_mm_and_si128(lowBuckets, highBuckets), zero);
+        uint32_t const vectorMask = ~(uint32_t)_mm_movemask_epi8(isOther) & 0xffff;
+        mask |= (uint64_t)vectorMask << vectorStart;
+    }
+    return mask;
+}
+
+static inline uint64_t blockMaskSetAvx2(char const * const chars, void const * const context) {
+    struct DelimiterSet const * const setPtr = context;
+    __m256i const lowNibbleBuckets = _mm256_broadcastsi128_si256(
+        _mm_loadu_si128((__m128i const *)(void const *)setPtr->lowNibbleBuckets)
+    );
+    __m256i const highNibbleBuckets = _mm256_broadcastsi128_si256(
+        _mm_loadu_si128((__m128i const *)(void const *)setPtr->highNibbleBuckets)
+    );
+    __m256i const nibbleBits = _mm256_set1_epi8(0x0f);
+    __m256i const zero = _mm256_setzero_si256();
+
+    uint64_t mask = 0;
+    for (size_t vectorStart = 0; vectorStart < BLOCK_LENGTH; vectorStart += 32) {
+        __m256i const vector = _mm256_loadu_si256((__m256i const *)(void const *)(chars + vectorStart));
+        __m256i const lowBuckets = _mm256_shuffle_epi8(lowNibbleBuckets, _mm256_and_si256(vector, nibbleBits));
+        __m256i const highBuckets = _mm256_shuffle_epi8(
+            highNibbleBuckets,
+            _mm256_and_si256(_mm256_srli_epi16(vector, 4), nibbleBits)
+        );
+        __m256i const isOther = _mm256_cmpeq_epi8(_mm256_and_si256(lowBuckets, highBuckets), zero);
+        uint32_t const vectorMask = ~(uint32_t)_mm256_movemask_epi8(isOther);
+        mask |= (uint64_t)vectorMask << vectorStart;
+    }
+    return mask;
+}
+#endif
@@ -4,12 +4,15 @@
 #include "../../include/util/error.h"
 
 #include "../../include/util/StringBuilder.h"
+#include "../../include/util/Arena.h"
+#include "../../include/util/memory.h"
 
 #include <stdbool.h>
 #include <string.h>
 #include <stdarg.h>
 #include <errno.h>
 #include <stdio.h>
+#include <unistd.h>
 
 /**
  * Open the file using fopen. If the operation fails, abort the program with an error message.
@@ -108,6 +111,64 @@ unsigned int safeVfprintf(
     return (unsigned int)printedCharCount;
 }
 
+/**
+ * Write the given characters to the given file. If the operation fails, abort the program with an error message.
+ *
+ * @param chars The characters to write.
+ * @param length The number of characters to write.
+ * @param file The file.
+ * @param callerDescription A description of the caller to be included in the error message. This could be the name of
+ *                          the calling function, plus extra information if useful.
+ */
+void safeFwrite(
+    void const * const chars,
+    size_t const length,
+    FILE * const file,
+    char const * const callerDescription
+) {
+    guard(length == 0 || chars != NULL, "safeFwrite: chars must not be null");
+    guardNotNull(file, "file", "safeFwrite");
+    guardNotNull(callerDescription, "callerDescription", "safeFwrite");
+
+    if (fwrite(chars, 1, length, file) != length) {
+        int const fwriteErrorCode = errno;
+        char const * const fwriteErrorMessage = strerror(fwriteErrorCode);
+
+        abortWithErrorFmt(
+            "%s: Failed to write %zu characters to file using fwrite (error code: %d; error message: \"%s\")",
+            callerDescription,
+            length,
+            fwriteErrorCode,
+            fwriteErrorMessage
+        );
+    }
+}
+
+/**
+ * Close the given file, flushing anything still buffered. If the operation fails, abort the program with an error
+ * message, since buffered writes which fail to flush are only reported here.
+ *
+ * @param file The file.
+ * @param callerDescription A description of the caller to be included in the error message. This could be the name of
+ *                          the calling function, plus extra information if useful.
+ */
+void safeFclose(FILE * const file, char const * const callerDescription) {
+    guardNotNull(file, "file", "safeFclose");
+    guardNotNull(callerDescription, "callerDescription", "safeFclose");
+
+    if (fclose(file) != 0) {
+        int const fcloseErrorCode = errno;
+        char const * const fcloseErrorMessage = strerror(fcloseErrorCode);
+
+        abortWithErrorFmt(
+            "%s: Failed to close file using fclose (error code: %d; error message: \"%s\")",
+            callerDescription,
+            fcloseErrorCode,
+            fcloseErrorMessage
+        );
+    }
+}
+
 /**
  * Read a character from the given file. If the operation fails, abort the program with an error message.
  *
@@ -231,6 +292,45 @@ char *readFileLine(FILE * const file) {
     return line;
 }
 
+/**
+ * Read a line from the file into memory allocated from the arena, the same way as readFileLine. The line is built in
+ * place in the arena, so reading it makes no calls to malloc.
+ *
+ * @param file The file to read from.
+ * @param arena The arena to allocate the line from.
+ *
+ * @returns The line, which lasts until the arena is reset or destroyed, or null if the current file position is EOF.
+ */
+char *readFileLineIntoArena(FILE * const file, Arena const arena) {
+    guardNotNull(file, "file", "readFileLineIntoArena");
+    guardNotNull(arena, "arena", "readFileLineIntoArena");
+
+    char readCharacter;
+    if (!safeFgetc(&readCharacter, file, "readFileLineIntoArena")) {
+        return NULL;
+    }
+
+    size_t capacity = 64;
+    size_t length = 0;
+    char *line = Arena_allocAligned(arena, capacity, 1);
+    do {
+        if (readCharacter == '\n') {
+            break;
+        }
+
+        if (length + 1 == capacity) {
+            line = Arena_grow(arena, line, capacity, capacity * 2);
+            capacity *= 2;
+        }
+        line[length] = readCharacter;
+        length += 1;
+    } while (safeFgetc(&readCharacter, file, "readFileLineIntoArena"));
+    line[length] = '\0';
+
+    // Give the unused capacity back to the arena
+    return Arena_grow(arena, line, capacity, length + 1);
+}
+
 /**
  * Open a text file, read all the text in the file into a string, and then close the file.
  *
@@ -255,6 +355,106 @@ char *readAllFileText(char const * const filePath) {
     return fileText;
 }
 
+/**
+ * Read everything remaining in a file descriptor into memory, e.g. all of a pipe. If the operation fails, abort the
+ * program with an error message.
+ *
+ * @param fileDescriptor The file descriptor. It is not closed.
+ * @param filePath The path the file descriptor was opened from, to be included in the error message.
+ * @param lengthOutPtr The location to store the number of characters read.
+ *
+ * @returns The characters read, which are not null-terminated. The caller is responsible for freeing this memory.
+ */
+char *readAllFileDescriptor(int const fileDescriptor, char const * const filePath, size_t * const lengthOutPtr) {
+    guardNotNull(filePath, "filePath", "readAllFileDescriptor");
+    guardNotNull(lengthOutPtr, "lengthOutPtr", "readAllFileDescriptor");
+
+    size_t capacity = 64 * 1024;
+    char *chars = safeMalloc(capacity, "readAllFileDescriptor");
+    size_t length = 0;
+    while (true) {
+        if (length == capacity) {
+            capacity *= 2;
+            chars = safeRealloc(chars, capacity, "readAllFileDescriptor");
+        }
+
+        ssize_t const readResult = read(fileDescriptor, chars + length, capacity - length);
+        if (readResult < 0) {
+            int const readErrorCode = errno;
+            if (readErrorCode == EINTR) {
+                continue;
+            }
+
+            char const * const readErrorMessage = strerror(readErrorCode);
+            abortWithErrorFmt(
+                "readAllFileDescriptor: Failed to read file \"%s\" using read (error code: %d; error message: \"%s\")",
+                filePath,
+                readErrorCode,
+                readErrorMessage
+            );
+            return NULL;
+        }
+        if (readResult == 0) {
+            break;
+        }
+
+        length += (size_t)readResult;
+    }
+
+    *lengthOutPtr = length;
+    return chars;
+}
+
+/**
+ * Open a file, copy all of its contents to the end of the given output file, and then close it. If the operation fails,
+ * abort the program with an error message.
+ *
+ * @param outFile The file to write to.
+ * @param filePath The path to the file to copy.
+ */
+void appendFileContents(FILE * const outFile, char const * const filePath) {
+    guardNotNull(outFile, "outFile", "appendFileContents");
+    guardNotNull(filePath, "filePath", "appendFileContents");
+
+    size_t const bufferLength = 64 * 1024;
+    char * const buffer = safeMalloc(bufferLength, "appendFileContents");
+
+    FILE * const file = safeFopen(filePath, "r", "appendFileContents");
+    while (true) {
+        size_t const readLength = fread(buffer, 1, bufferLength, file);
+        if (readLength > 0 && fwrite(buffer, 1, readLength, outFile) != readLength) {
+            int const fwriteErrorCode = errno;
+            char const * const fwriteErrorMessage = strerror(fwriteErrorCode);
+
+            abortWithErrorFmt(
+                "appendFileContents: Failed to copy file \"%s\" using fwrite (error code: %d; error message: \"%s\")",
+                filePath,
+                fwriteErrorCode,
+                fwriteErrorMessage
+            );
+        }
+        if (readLength < bufferLength) {
+            break;
+        }
+    }
+
+    bool const freadError = ferror(file);
+    if (freadError) {
+        int const freadErrorCode = errno;
+        char const * const freadErrorMessage = strerror(freadErrorCode);
+
+        abortWithErrorFmt(
+            "appendFileContents: Failed to read file \"%s\" using fread (error code: %d; error message: \"%s\")",
+            filePath,
+            freadErrorCode,
+            freadErrorMessage
+        );
+    }
+
+    fclose(file);
+    free(buffer);
+}
+
 /**
  * Read values from the given file using the given format. Values are stored in the locations pointed to by formatArgs.
  * If the operation fails, abort the program with an error message.
@@ -0,0 +1,686 @@
+#define _GNU_SOURCE
+
+#include "../../include/util/ioUring.h"
+
+#include "../../include/util/memory.h"
+#include "../../include/util/string.h"
+#include "../../include/util/macro.h"
+#include "../../include/util/guard.h"
+#include "../../include/util/error.h"
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdio.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+
+/**
+ * A minimal io_uring instance driven through the raw syscalls: the submission and completion rings shared with the
+ * kernel, plus the count of submissions queued but not yet passed to io_uring_enter.
+ */
+struct Ring {
+    int fileDescriptor;
+
+    void *sqRingMemory;
+    size_t sqRingSize;
+    unsigned int *sqHeadPtr;
+    unsigned int *sqTailPtr;
+    unsigned int sqRingMask;
+    unsigned int sqEntryCount;
+    unsigned int *sqArray;
+    struct io_uring_sqe *sqes;
+    size_t sqesSize;
+
+    void *cqRingMemory;
+    size_t cqRingSize;
+    unsigned int *cqHeadPtr;
+    unsigned int *cqTailPtr;
+    unsigned int cqRingMask;
+    struct io_uring_cqe *cqes;
+
+    unsigned int unsubmittedCount;
+};
+
+static bool Ring_init(struct Ring *ringOutPtr, unsigned int entryCount);
+static void Ring_destroy(struct Ring *ringPtr);
+static bool Ring_supportsOp(struct Ring const *ringPtr, unsigned int op);
+static void Ring_queueReadWrite(
+    struct Ring *ringPtr,
+    uint8_t op,
+    int fileDescriptor,
+    void const *chars,
+    size_t length,
+    uint64_t offset,
+    uint64_t userData
+);
+static void Ring_submit(struct Ring *ringPtr, unsigned int minCompleteCount, char const *callerDescription);
+static bool Ring_reap(struct Ring *ringPtr, struct io_uring_cqe *cqeOutPtr);
+
+/** The number of reads or writes each ring keeps in flight at once. */
+#define IO_URING_QUEUE_DEPTH 8
+
+/**
+ * A write of one output block, in flight until the kernel has written every byte of it. chars is null when the slot is
+ * free.
+ */
+struct PendingWrite {
+    char *chars;
+    size_t length;
+    size_t writtenLength;
+    uint64_t offset;
+};
+
+/**
+ * The stdio cookie behind a file opened with ioUringFopenWrite.
+ */
+struct IoUringWriter {
+    struct Ring ring;
+    int fileDescriptor;
+    char *filePath;
+    uint64_t nextOffset;
+    struct PendingWrite pendingWrites[IO_URING_QUEUE_DEPTH];
+    size_t pendingWriteCount;
+};
+
+static ssize_t IoUringWriter_write(void *writerAsVoidPtr, char const *chars, size_t length);
+static int IoUringWriter_close(void *writerAsVoidPtr);
+static void IoUringWriter_reapCompletions(struct IoUringWriter *writerPtr, unsigned int minCompleteCount);
+
+static size_t const ioUringReadChunkLength = 1024 * 1024;
+static size_t const ioUringWriteBufferLength = 256 * 1024;
+
+/**
+ * Read the entire file at the given path into memory with io_uring, keeping several large reads in flight at once. If
+ * the operation fails, abort the program with an error message.
+ *
+ * @param filePath The file path.
+ * @param lengthOutPtr The location to store the number of characters read.
+ * @param callerDescription A description of the caller to be included in the error message. This could be the name of
+ *                          the calling function, plus extra information if useful.
+ *
+ * @returns The file contents (not null-terminated; the caller is responsible for freeing this memory), or null if
+ *          io_uring is not available, in which case the caller should read the file another way.
+ */
+char *ioUringReadAllFile(
+    char const * const filePath,
+    size_t * const lengthOutPtr,
+    char const * const callerDescription
+) {
+    guardNotNull(filePath, "filePath", "ioUringReadAllFile");
+    guardNotNull(lengthOutPtr, "lengthOutPtr", "ioUringReadAllFile");
+    guardNotNull(callerDescription, "callerDescription", "ioUringReadAllFile");
+
+    struct Ring ring;
+    if (!Ring_init(&ring, IO_URING_QUEUE_DEPTH)) {
+        return NULL;
+    }
+    if (!Ring_supportsOp(&ring, IORING_OP_READ)) {
+        Ring_destroy(&ring);
+        return NULL;
+    }
+
+    int const fileDescriptor = open(filePath, O_RDONLY);
+    if (fileDescriptor == -1) {
+        int const openErrorCode = errno;
+        char const * const openErrorMessage = strerror(openErrorCode);
+
+        abortWithErrorFmt(
+            "%s: Failed to open file \"%s\" using open (error code: %d; error message: \"%s\")",
+            callerDescription,
+            filePath,
+            openErrorCode,
+            openErrorMessage
+        );
+        return NULL;
+    }
+
+    struct stat fileStatus;
+    if (fstat(fileDescriptor, &fileStatus) != 0) {
+        int const fstatErrorCode = errno;
+        char const * const fstatErrorMessage = strerror(fstatErrorCode);
+
+        abortWithErrorFmt(
+            "%s: Failed to get size of file \"%s\" using fstat (error code: %d; error message: \"%s\")",
+            callerDescription,
+            filePath,
+            fstatErrorCode,
+            fstatErrorMessage
+        );
+        return NULL;
+    }
+
+    size_t const length = (size_t)fileStatus.st_size;
+    char * const chars = safeMalloc(length == 0 ? 1 : length, "ioUringReadAllFile");
+
+    // Each slot holds the part of one chunk that is still to be read; a short read is requeued for its remainder
+    struct {
+        size_t offset;
+        size_t length;
+    } reads[IO_URING_QUEUE_DEPTH];
+    size_t inFlightCount = 0;
+    size_t nextOffset = 0;
+
+    for (size_t i = 0; i < ARRAY_LENGTH(reads) && nextOffset < length; i += 1) {
+        size_t const chunkLength = length - nextOffset < ioUringReadChunkLength
+            ? length - nextOffset
+            : ioUringReadChunkLength;
+        reads[i].offset = nextOffset;
+        reads[i].length = chunkLength;
+        Ring_queueReadWrite(&ring, IORING_OP_READ, fileDescriptor, chars + nextOffset, chunkLength, nextOffset, i);
+        nextOffset += chunkLength;
+        inFlightCount += 1;
+    }
+
+    while (inFlightCount > 0) {
+        Ring_submit(&ring, 1, callerDescription);
+
+        struct io_uring_cqe cqe;
+        while (Ring_reap(&ring, &cqe)) {
+            size_t const slot = (size_t)cqe.user_data;
+            if (cqe.res <= 0) {
+                int const readErrorCode = cqe.res == 0 ? EIO : -cqe.res;
+                char const * const readErrorMessage = cqe.res == 0
+                    ? "file ended early"
+                    : strerror(readErrorCode);
+
+                abortWithErrorFmt(
+                    "%s: Failed to read file \"%s\" using io_uring (error code: %d; error message: \"%s\")",
+                    callerDescription,
+                    filePath,
+                    readErrorCode,
+                    readErrorMessage
+                );
+                return NULL;
+            }
+
+            size_t const readLength = (size_t)cqe.res;
+            reads[slot].offset += readLength;
+            reads[slot].length -= readLength;
+
+            if (reads[slot].length == 0 && nextOffset < length) {
+                size_t const chunkLength = length - nextOffset < ioUringReadChunkLength
+                    ? length - nextOffset
+                    : ioUringReadChunkLength;
+                reads[slot].offset = nextOffset;
+                reads[slot].length = chunkLength;
+                nextOffset += chunkLength;
+            }
+
+            if (reads[slot].length > 0) {
+                Ring_queueReadWrite(
+                    &ring,
+                    IORING_OP_READ,
+                    fileDescriptor,
+                    chars + reads[slot].offset,
+                    reads[slot].length,
+                    reads[slot].offset,
+                    slot
+                );
+            } else {
+                inFlightCount -= 1;
+            }
+        }
+    }
+
+    close(fileDescriptor);
+    Ring_destroy(&ring);
+
+    *lengthOutPtr = length;
+    return chars;
+}
+
+/**
+ * Open a file for writing (truncating it) as a stdio stream whose buffered blocks are written with io_uring. Each full
+ * buffer is copied and queued as one write, and the writing thread only waits for the kernel when every write slot is
+ * still in flight. Closing the stream waits for every queued write. The writes are addressed by file offset, so only
+ * regular files are supported; for a pipe, FIFO, or device, null is returned. If the operation fails, abort the program
+ * with an error message.
+ *
+ * @param filePath The file path.
+ * @param callerDescription A description of the caller to be included in the error message. This could be the name of
+ *                          the calling function, plus extra information if useful.
+ *
+ * @returns The stream (the caller is responsible for closing it with fclose), or null if io_uring is not available or
+ *          the path is not a regular file, in which case the caller should open the file another way.
+ */
+FILE *ioUringFopenWrite(char const * const filePath, char const * const callerDescription) {
+    guardNotNull(filePath, "filePath", "ioUringFopenWrite");
+    guardNotNull(callerDescription, "callerDescription", "ioUringFopenWrite");
+
+    // Checked before opening rather than with fstat after, since opening and closing a FIFO ends its reader's input
+    struct stat fileStat;
+    if (stat(filePath, &fileStat) == 0 && !S_ISREG(fileStat.st_mode)) {
+        return NULL;
+    }
+
+    struct IoUringWriter * const writerPtr = safeMalloc(sizeof *writerPtr, "ioUringFopenWrite");
+    if (!Ring_init(&writerPtr->ring, IO_URING_QUEUE_DEPTH)) {
+        free(writerPtr);
+        return NULL;
+    }
+    if (!Ring_supportsOp(&writerPtr->ring, IORING_OP_WRITE)) {
+        Ring_destroy(&writerPtr->ring);
+        free(writerPtr);
+        return NULL;
+    }
+
+    writerPtr->fileDescriptor = open(filePath, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+    if (writerPtr->fileDescriptor == -1) {
+        int const openErrorCode = errno;
+        char const * const openErrorMessage = strerror(openErrorCode);
+
+        abortWithErrorFmt(
+            "%s: Failed to open file \"%s\" using open (error code: %d; error message: \"%s\")",
+            callerDescription,
+            filePath,
+            openErrorCode,
+            openErrorMessage
+        );
+        return NULL;
+    }
+
+    writerPtr->filePath = formatString("%s", filePath);
+    writerPtr->nextOffset = 0;
+    for (size_t i = 0; i < ARRAY_LENGTH(writerPtr->pendingWrites); i += 1) {
+        writerPtr->pendingWrites[i].chars = NULL;
+    }
+    writerPtr->pendingWriteCount = 0;
+
+    FILE * const file = fopencookie(writerPtr, "w", (cookie_io_functions_t){
+        .read = NULL,
+        .write = IoUringWriter_write,
+        .seek = NULL,
+        .close = IoUringWriter_close
+    });
+    if (file == NULL) {
+        int const fopencookieErrorCode = errno;
+        char const * const fopencookieErrorMessage = strerror(fopencookieErrorCode);
+
+        abortWithErrorFmt(
+            "%s: Failed to open stream for file \"%s\" using fopencookie (error code: %d; error message: \"%s\")",
+            callerDescription,
+            filePath,
+            fopencookieErrorCode,
+            fopencookieErrorMessage
+        );
+        return NULL;
+    }
+
+    // Large blocks amortize each submission over many lines
+    setvbuf(file, NULL, _IOFBF, ioUringWriteBufferLength);
+    return file;
+}
+
+/**
+ * Queue a block flushed by stdio as one io_uring write at the end of the file.
+ *
+ * @param writerAsVoidPtr The IoUringWriter.
+ * @param chars The block. It is copied, since stdio reuses its buffer as soon as this returns.
+ * @param length The length of the block.
+ *
+ * @returns The number of characters accepted, which is always length.
+ */
+static ssize_t IoUringWriter_write(void * const writerAsVoidPtr, char const * const chars, size_t const length) {
+    struct IoUringWriter * const writerPtr = writerAsVoidPtr;
+
+    if (length == 0) {
+        return 0;
+    }
+
+    while (writerPtr->pendingWriteCount == ARRAY_LENGTH(writerPtr->pendingWrites)) {
+        IoUringWriter_reapCompletions(writerPtr, 1);
+    }
+
+    size_t slot = 0;
+    while (writerPtr->pendingWrites[slot].chars != NULL) {
+        slot += 1;
+    }
+
+    struct PendingWrite * const pendingWritePtr = &writerPtr->pendingWrites[slot];
+    pendingWritePtr->chars = safeMalloc(length, "IoUringWriter_write");
+    memcpy(pendingWritePtr->chars, chars, length);
+    pendingWritePtr->length = length;
+    pendingWritePtr->writtenLength = 0;
+    pendingWritePtr->offset = writerPtr->nextOffset;
+    writerPtr->nextOffset += length;
+    writerPtr->pendingWriteCount += 1;
+
+    Ring_queueReadWrite(
+        &writerPtr->ring,
+        IORING_OP_WRITE,
+        writerPtr->fileDescriptor,
+        pendingWritePtr->chars,
+        length,
+        pendingWritePtr->offset,
+        slot
+    );
+    IoUringWriter_reapCompletions(writerPtr, 0);
+
+    return (ssize_t)length;
+}
+
+/**
+ * Wait for every queued write, then close the file and free the writer.
+ *
+ * @param writerAsVoidPtr The IoUringWriter.
+ *
+ * @returns 0.
+ */
+static int IoUringWriter_close(void * const writerAsVoidPtr) {
+    struct IoUringWriter * const writerPtr = writerAsVoidPtr;
+
+    while (writerPtr->pendingWriteCount > 0) {
+        IoUringWriter_reapCompletions(writerPtr, 1);
+    }
+
+    close(writerPtr->fileDescriptor);
+    Ring_destroy(&writerPtr->ring);
+    free(writerPtr->filePath);
+    free(writerPtr);
+    return 0;
+}
+
+/**
+ * Submit any queued writes and handle the completed ones, requeueing the remainder of any short write. If a write
+ * fails, abort the program with an error message.
+ *
+ * @param writerPtr The writer.
+ * @param minCompleteCount How many completions to wait for, or 0 to only handle those already available.
+ */
+static void IoUringWriter_reapCompletions(struct IoUringWriter * const writerPtr, unsigned int const minCompleteCount) {
+    Ring_submit(&writerPtr->ring, minCompleteCount, "IoUringWriter_reapCompletions");
+
+    struct io_uring_cqe cqe;
+    while (Ring_reap(&writerPtr->ring, &cqe)) {
+        struct PendingWrite * const pendingWritePtr = &writerPtr->pendingWrites[cqe.user_data];
+        if (cqe.res <= 0) {
+            int const writeErrorCode = cqe.res == 0 ? EIO : -cqe.res;
+            char const * const writeErrorMessage = strerror(writeErrorCode);
+
+            abortWithErrorFmt(
+                "IoUringWriter_reapCompletions: Failed to write file \"%s\" using io_uring"
+                " (error code: %d; error message: \"%s\")",
+                writerPtr->filePath,
+                writeErrorCode,
+                writeErrorMessage
+            );
+            return;
+        }
+
+        pendingWritePtr->writtenLength += (size_t)cqe.res;
+        if (pendingWritePtr->writtenLength < pendingWritePtr->length) {
+            Ring_queueReadWrite(
+                &writerPtr->ring,
+                IORING_OP_WRITE,
+                writerPtr->fileDescriptor,
+                pendingWritePtr->chars + pendingWritePtr->writtenLength,
+                pendingWritePtr->length - pendingWritePtr->writtenLength,
+                pendingWritePtr->offset + pendingWritePtr->writtenLength,
+                cqe.user_data
+            );
+            continue;
+        }
+
+        free(pendingWritePtr->chars);
+        pendingWritePtr->chars = NULL;
+        writerPtr->pendingWriteCount -= 1;
+    }
+}
+
+/**
+ * Set up an io_uring instance and map its rings.
+ *
+ * @param ringOutPtr The location to store the ring.
+ * @param entryCount The number of submission queue entries. The ring never has more operations in flight than this.
+ *
+ * @returns Whether the ring was set up, or false if io_uring is not available (not supported by the kernel, disabled,
+ *          or blocked by a seccomp filter).
+ */
+static bool Ring_init(struct Ring * const ringOutPtr, unsigned int const entryCount) {
+    struct io_uring_params params;
+    memset(&params, 0, sizeof params);
+
+    long const fileDescriptor = syscall(SYS_io_uring_setup, entryCount, &params);
+    if (fileDescriptor < 0) {
+        return false;
+    }
+    ringOutPtr->fileDescriptor = (int)fileDescriptor;
+
+    ringOutPtr->sqRingSize = params.sq_off.array + params.sq_entries * sizeof (unsigned int);
+    ringOutPtr->cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof (struct io_uring_cqe);
+    bool const singleMapping = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (singleMapping && ringOutPtr->cqRingSize > ringOutPtr->sqRingSize) {
+        ringOutPtr->sqRingSize = ringOutPtr->cqRingSize;
+    }
+
+    ringOutPtr->sqRingMemory = mmap(
+        NULL,
+        ringOutPtr->sqRingSize,
+        PROT_READ | PROT_WRITE,
+        MAP_SHARED | MAP_POPULATE,
+        ringOutPtr->fileDescriptor,
+        IORING_OFF_SQ_RING
+    );
+    if (ringOutPtr->sqRingMemory == MAP_FAILED) {
+        close(ringOutPtr->fileDescriptor);
+        return false;
+    }
+
+    if (singleMapping) {
+        ringOutPtr->cqRingMemory = ringOutPtr->sqRingMemory;
+    } else {
+        ringOutPtr->cqRingMemory = mmap(
+            NULL,
+            ringOutPtr->cqRingSize,
+            PROT_READ | PROT_WRITE,
+            MAP_SHARED | MAP_POPULATE,
+            ringOutPtr->fileDescriptor,
+            IORING_OFF_CQ_RING
+        );
+        if (ringOutPtr->cqRingMemory == MAP_FAILED) {
+            munmap(ringOutPtr->sqRingMemory, ringOutPtr->sqRingSize);
+            close(ringOutPtr->fileDescriptor);
+            return false;
+        }
+    }
+
+    ringOutPtr->sqesSize = params.sq_entries * sizeof (struct io_uring_sqe);
+    void * const sqesMemory = mmap(
+        NULL,
+        ringOutPtr->sqesSize,
+        PROT_READ | PROT_WRITE,
+        MAP_SHARED | MAP_POPULATE,
+        ringOutPtr->fileDescriptor,
+        IORING_OFF_SQES
+    );
+    if (sqesMemory == MAP_FAILED) {
+        if (!singleMapping) {
+            munmap(ringOutPtr->cqRingMemory, ringOutPtr->cqRingSize);
+        }
+        munmap(ringOutPtr->sqRingMemory, ringOutPtr->sqRingSize);
+        close(ringOutPtr->fileDescriptor);
+        return false;
+    }
+    ringOutPtr->sqes = sqesMemory;
+
+    char * const sqRing = ringOutPtr->sqRingMemory;
+    ringOutPtr->sqHeadPtr = (unsigned int *)(void *)(sqRing + params.sq_off.head);
+    ringOutPtr->sqTailPtr = (unsigned int *)(void *)(sqRing + params.sq_off.tail);
+    ringOutPtr->sqRingMask = *(unsigned int *)(void *)(sqRing + params.sq_off.ring_mask);
+    ringOutPtr->sqEntryCount = params.sq_entries;
+    ringOutPtr->sqArray = (unsigned int *)(void *)(sqRing + params.sq_off.array);
+
+    char * const cqRing = ringOutPtr->cqRingMemory;
+    ringOutPtr->cqHeadPtr = (unsigned int *)(void *)(cqRing + params.cq_off.head);
+    ringOutPtr->cqTailPtr = (unsigned int *)(void *)(cqRing + params.cq_off.tail);
+    ringOutPtr->cqRingMask = *(unsigned int *)(void *)(cqRing + params.cq_off.ring_mask);
+    ringOutPtr->cqes = (struct io_uring_cqe *)(void *)(cqRing + params.cq_off.cqes);
+
+    ringOutPtr->unsubmittedCount = 0;
+    return true;
+}
+
+/**
+ * Unmap the ring and close its file descriptor. Every queued operation must have completed.
+ *
+ * @param ringPtr The ring.
+ */
+static void Ring_destroy(struct Ring * const ringPtr) {
+    munmap(ringPtr->sqes, ringPtr->sqesSize);
+    if (ringPtr->cqRingMemory != ringPtr->sqRingMemory) {
+        munmap(ringPtr->cqRingMemory, ringPtr->cqRingSize);
+    }
+    munmap(ringPtr->sqRingMemory, ringPtr->sqRingSize);
+    close(ringPtr->fileDescriptor);
+}
+
+/**
+ * Ask the kernel whether it supports the given operation, since the ring itself can predate it.
+ *
+ * @param ringPtr The ring.
+ * @param op The operation, e.g. IORING_OP_READ.
+ *
+ * @returns Whether the operation is supported, or false if the kernel cannot be asked.
+ */
+static bool Ring_supportsOp(struct Ring const * const ringPtr, unsigned int const op) {
+    size_t const opCount = 256;
+    struct io_uring_probe * const probePtr = safeMalloc(
+        sizeof *probePtr + opCount * sizeof probePtr->ops[0],
+        "Ring_supportsOp"
+    );
+    memset(probePtr, 0, sizeof *probePtr + opCount * sizeof probePtr->ops[0]);
+
+    long const registerResult = syscall(
+        SYS_io_uring_register,
+        ringPtr->fileDescriptor,
+        IORING_REGISTER_PROBE,
+        probePtr,
+        (unsigned int)opCount
+    );
+    bool const supported = (
+        registerResult == 0
+        && op <= probePtr->last_op
+        && (probePtr->ops[op].flags & IO_URING_OP_SUPPORTED) != 0
+    );
+
+    free(probePtr);
+    return supported;
+}
+
+/**
+ * Queue a read or write. It is passed to the kernel by the next Ring_submit. The caller must not have more operations
+ * in flight than the ring has entries.
+ *
+ * @param ringPtr The ring.
+ * @param op IORING_OP_READ or IORING_OP_WRITE.
+ * @param fileDescriptor The file to read or write.
+ * @param chars The buffer to read into or write from. It must stay valid until the operation completes.
+ * @param length The number of characters to read or write.
+ * @param offset The file offset at which to read or write.
+ * @param userData A value identifying the operation in its completion.
+ */
+static void Ring_queueReadWrite(
+    struct Ring * const ringPtr,
+    uint8_t const op,
+    int const fileDescriptor,
+    void const * const chars,
+    size_t const length,
+    uint64_t const offset,
+    uint64_t const userData
+) {
+    // This thread is the only producer, so only the kernel-updated head needs synchronizing
+    unsigned int const tail = *ringPtr->sqTailPtr;
+    guard(
+        tail - __atomic_load_n(ringPtr->sqHeadPtr, __ATOMIC_ACQUIRE) < ringPtr->sqEntryCount,
+        "Ring_queueReadWrite: submission queue is full"
+    );
+
+    unsigned int const index = tail & ringPtr->sqRingMask;
+    struct io_uring_sqe * const sqePtr = &ringPtr->sqes[index];
+    memset(sqePtr, 0, sizeof *sqePtr);
+    sqePtr->opcode = op;
+    sqePtr->fd = fileDescriptor;
+    sqePtr->addr = (uint64_t)(uintptr_t)chars;
+    // Longer operations complete short, and the caller requeues the remainder
+    sqePtr->len = length > INT32_MAX ? INT32_MAX : (uint32_t)length;
+    sqePtr->off = offset;
+    sqePtr->user_data = userData;
+
+    ringPtr->sqArray[index] = index;
+    __atomic_store_n(ringPtr->sqTailPtr, tail + 1, __ATOMIC_RELEASE);
+    ringPtr->unsubmittedCount += 1;
+}
+
+/**
+ * Pass the queued operations to the kernel, optionally waiting for some to complete. If the operation fails, abort the
+ * program with an error message.
+ *
+ * @param ringPtr The ring.
+ * @param minCompleteCount How many completions to wait for, or 0 to return without waiting.
+ * @param callerDescription A description of the caller to be included in the error message.
+ */
+static void Ring_submit(
+    struct Ring * const ringPtr,
+    unsigned int const minCompleteCount,
+    char const * const callerDescription
+) {
+    if (ringPtr->unsubmittedCount == 0 && minCompleteCount == 0) {
+        return;
+    }
+
+    while (true) {
+        long const enterResult = syscall(
+            SYS_io_uring_enter,
+            ringPtr->fileDescriptor,
+            ringPtr->unsubmittedCount,
+            minCompleteCount,
+            minCompleteCount > 0 ? IORING_ENTER_GETEVENTS : 0,
+            NULL,
+            0
+        );
+        if (enterResult >= 0) {
+            ringPtr->unsubmittedCount -= (unsigned int)enterResult;
+            return;
+        }
+
+        int const enterErrorCode = errno;
+        if (enterErrorCode == EINTR) {
+            continue;
+        }
+
+        char const * const enterErrorMessage = strerror(enterErrorCode);
+        abortWithErrorFmt(
+            "%s: Failed to submit io_uring operations using io_uring_enter (error code: %d; error message: \"%s\")",
+            callerDescription,
+            enterErrorCode,
+            enterErrorMessage
+        );
+        return;
+    }
+}
+
+/**
+ * Take the next completion, if one is available.
+ *
+ * @param ringPtr The ring.
+ * @param cqeOutPtr The location to store the completion.
+ *
+ * @returns Whether a completion was taken.
+ */
+static bool Ring_reap(struct Ring * const ringPtr, struct io_uring_cqe * const cqeOutPtr) {
+    unsigned int const head = *ringPtr->cqHeadPtr;
+    if (head == __atomic_load_n(ringPtr->cqTailPtr, __ATOMIC_ACQUIRE)) {
+        return false;
+    }
+
+    *cqeOutPtr = ringPtr->cqes[head & ringPtr->cqRingMask];
+    __atomic_store_n(ringPtr->cqHeadPtr, head + 1, __ATOMIC_RELEASE);
+    return true;
+}
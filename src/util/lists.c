@@ -4,3 +4,4 @@
 
 DEFINE_LIST(CharList, char)
 DEFINE_LIST(StringList, char *)
+DEFINE_LIST(SizeList, size_t)
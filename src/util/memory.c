@@ -68,3 +68,44 @@ void *safeRealloc(void * const memory, size_t const newSize, char const * const
 
     return newMemory;
 }
+
+/**
+ * Allocate memory of the given size and alignment using aligned_alloc. If the allocation fails, abort the program with
+ * an error message.
+ *
+ * @param alignment The alignment of the memory, in bytes. Must be a power of two.
+ * @param size The size of the memory, in bytes. Must be a multiple of alignment.
+ * @param callerDescription A description of the caller to be included in the error message. This could be the name of
+ *                          the calling function, plus extra information if useful.
+ *
+ * @returns The allocated memory. Free it with free.
+ */
+void *safeAlignedAlloc(size_t const alignment, size_t const size, char const * const callerDescription) {
+    guardNotNull(callerDescription, "callerDescription", "safeAlignedAlloc");
+    guardFmt(
+        alignment > 0 && (alignment & (alignment - 1)) == 0 && size % alignment == 0,
+        "%s: Cannot allocate %zu bytes aligned to %zu (alignment must be a power of two dividing the size)",
+        callerDescription,
+        size,
+        alignment
+    );
+
+    void * const memory = aligned_alloc(alignment, size);
+    if (memory == NULL) {
+        int const alignedAllocErrorCode = errno;
+        char const * const alignedAllocErrorMessage = strerror(alignedAllocErrorCode);
+
+        abortWithErrorFmt(
+            "%s: Failed to allocate %zu bytes of memory aligned to %zu using aligned_alloc"
+            " (error code: %d; error message: \"%s\")",
+            callerDescription,
+            size,
+            alignment,
+            alignedAllocErrorCode,
+            alignedAllocErrorMessage
+        );
+        return NULL;
+    }
+
+    return memory;
+}
@@ -1,28 +1,211 @@
-#include "../include/util/random.h"
+#include "../../include/util/random.h"
 
-#include "../include/util/time.h"
-#include "../include/util/guard.h"
+#include "../../include/util/time.h"
+#include "../../include/util/guard.h"
 
 #include <stdlib.h>
 #include <stdbool.h>
+#include <stdint.h>
+#include <stdatomic.h>
 
-static bool randomInitialized = false;
+__extension__ typedef unsigned __int128 uint128;
 
-static void ensureRandomInitialized(void);
+/** The seed every thread's randomInt stream is derived from, once baseSeedSet is true. */
+static atomic_uint_fast64_t baseSeed = 0;
+static atomic_bool baseSeedSet = false;
+/**
+ * The stream index given to the next thread which calls randomInt without initializeThreadRandom. These start above any
+ * unsigned int so that they never repeat an index passed to initializeThreadRandom.
+ */
+static atomic_uint_fast64_t nextAutomaticStreamIndex = (uint64_t)UINT32_MAX + 1;
+
+static _Thread_local struct Random threadRandom;
+static _Thread_local bool threadRandomSeeded = false;
+
+static uint64_t splitMix64(uint64_t *statePtr);
+static uint64_t rotateLeft(uint64_t value, int count);
+static uint64_t xoshiro256StarStar(uint64_t state[4]);
+static uint64_t boundedFrom(uint64_t state[4], uint64_t bound, uint64_t rejectionThreshold);
+static uint64_t ensureBaseSeed(void);
+static struct Random *ensureThreadRandom(void);
+
+/** The increment of the splitmix64 generator: 2^64 divided by the golden ratio. */
+static uint64_t const splitMix64Gamma = 0x9E3779B97F4A7C15u;
+
+/**
+ * Seed a generator for one of many independent streams from a shared seed, e.g. one stream per thread indexed by the
+ * thread's number. The state words are consecutive outputs of splitmix64, started past the words of every lower
+ * stream, so that any seed (including 0) gives a well-mixed state and no two streams of a seed start alike.
+ *
+ * @param randomOutPtr The location to store the generator state.
+ * @param seed The seed shared by all the streams.
+ * @param streamIndex The index of this stream.
+ */
+void Random_seed(struct Random * const randomOutPtr, uint64_t const seed, uint64_t const streamIndex) {
+    guardNotNull(randomOutPtr, "randomOutPtr", "Random_seed");
+
+    uint64_t splitMixState = seed + streamIndex * 4 * splitMix64Gamma;
+    for (size_t i = 0; i < 4; i += 1) {
+        randomOutPtr->state[i] = splitMix64(&splitMixState);
+    }
+}
+
+/**
+ * Generate the next 64 random bits.
+ *
+ * @param randomPtr The generator state.
+ *
+ * @returns The random bits.
+ */
+uint64_t Random_next(struct Random * const randomPtr) {
+    guardNotNull(randomPtr, "randomPtr", "Random_next");
+
+    return xoshiro256StarStar(randomPtr->state);
+}
+
+/**
+ * Generate a random integer from [0, bound), with every value equally likely. This uses Lemire's multiply-and-shift
+ * method, which only divides in the rare case that a draw has to be rejected to avoid bias.
+ *
+ * @param randomPtr The generator state.
+ * @param bound The exclusive upper bound. Must be positive.
+ *
+ * @returns The random integer.
+ */
+uint64_t Random_nextBelow(struct Random * const randomPtr, uint64_t const bound) {
+    guardNotNull(randomPtr, "randomPtr", "Random_nextBelow");
+    guard(bound > 0, "Random_nextBelow: bound must be positive");
+
+    return boundedFrom(randomPtr->state, bound, 0);
+}
+
+/**
+ * Generate a random integer from within the given range, with every value equally likely.
+ *
+ * @param randomPtr The generator state.
+ * @param minInclusive The inclusive lower bound of the random number returned.
+ * @param maxExclusive The exclusive upper bound of the random number returned. maxExclusive must be greater than
+ *                     minInclusive.
+ *
+ * @returns The random integer.
+ */
+int Random_nextInt(struct Random * const randomPtr, int const minInclusive, int const maxExclusive) {
+    guardNotNull(randomPtr, "randomPtr", "Random_nextInt");
+    guardFmt(
+        maxExclusive > minInclusive,
+        "Random_nextInt: maxExclusive (%d) must be greater than minInclusive (%d)",
+        maxExclusive,
+        minInclusive
+    );
+
+    uint64_t const offset = boundedFrom(randomPtr->state, (uint64_t)((int64_t)maxExclusive - minInclusive), 0);
+    return (int)(minInclusive + (int64_t)offset);
+}
+
+/**
+ * Generate a random number from [0, 1), using the top 53 bits of a draw so that every representable multiple of 2^-53
+ * is equally likely.
+ *
+ * @param randomPtr The generator state.
+ *
+ * @returns The random number.
+ */
+double Random_nextDouble(struct Random * const randomPtr) {
+    guardNotNull(randomPtr, "randomPtr", "Random_nextDouble");
+
+    uint64_t const bits = xoshiro256StarStar(randomPtr->state);
+    return (double)(bits >> 11) * 0x1.0p-53;
+}
+
+/**
+ * Fill an array with random 64-bit values. The state is kept in registers for the whole array, which makes this faster
+ * than calling Random_next per value.
+ *
+ * @param randomPtr The generator state.
+ * @param valuesOut The array to fill.
+ * @param valueCount The number of values to generate.
+ */
+void Random_fill(struct Random * const randomPtr, uint64_t * const valuesOut, size_t const valueCount) {
+    guardNotNull(randomPtr, "randomPtr", "Random_fill");
+    guard(valueCount == 0 || valuesOut != NULL, "Random_fill: valuesOut must not be null");
+
+    uint64_t state[4] = { randomPtr->state[0], randomPtr->state[1], randomPtr->state[2], randomPtr->state[3] };
+    for (size_t i = 0; i < valueCount; i += 1) {
+        valuesOut[i] = xoshiro256StarStar(state);
+    }
+    for (size_t i = 0; i < 4; i += 1) {
+        randomPtr->state[i] = state[i];
+    }
+}
+
+/**
+ * Fill an array with random integers from within the given range, with every value equally likely. The rejection
+ * threshold for the range is computed once for the whole array rather than per value.
+ *
+ * @param randomPtr The generator state.
+ * @param valuesOut The array to fill.
+ * @param valueCount The number of values to generate.
+ * @param minInclusive The inclusive lower bound of the random numbers.
+ * @param maxExclusive The exclusive upper bound of the random numbers. maxExclusive must be greater than minInclusive.
+ */
+void Random_fillInts(
+    struct Random * const randomPtr,
+    int * const valuesOut,
+    size_t const valueCount,
+    int const minInclusive,
+    int const maxExclusive
+) {
+    guardNotNull(randomPtr, "randomPtr", "Random_fillInts");
+    guard(valueCount == 0 || valuesOut != NULL, "Random_fillInts: valuesOut must not be null");
+    guardFmt(
+        maxExclusive > minInclusive,
+        "Random_fillInts: maxExclusive (%d) must be greater than minInclusive (%d)",
+        maxExclusive,
+        minInclusive
+    );
+
+    uint64_t const bound = (uint64_t)((int64_t)maxExclusive - minInclusive);
+    uint64_t const rejectionThreshold = (0 - bound) % bound;
+
+    uint64_t state[4] = { randomPtr->state[0], randomPtr->state[1], randomPtr->state[2], randomPtr->state[3] };
+    for (size_t i = 0; i < valueCount; i += 1) {
+        uint64_t const offset = boundedFrom(state, bound, rejectionThreshold);
+        valuesOut[i] = (int)(minInclusive + (int64_t)offset);
+    }
+    for (size_t i = 0; i < 4; i += 1) {
+        randomPtr->state[i] = state[i];
+    }
+}
 
 /**
- * Initialize the random number generator using the given seed value. If this is never called, the random number
- * generator will automatically be initialized with the time it is first used.
+ * Set the seed which every thread's randomInt stream is derived from, and restart the calling thread's stream as stream
+ * 0 of it. If this is never called, the seed is taken from the time when randomInt is first used.
  *
- * @param seed A number used to calculate a starting value for the pseudo-random number sequence.
+ * @param seed A number used to calculate a starting value for the pseudo-random number sequences.
  */
 void initializeRandom(unsigned int const seed) {
-    srand(seed);
-    randomInitialized = true;
+    atomic_store_explicit(&baseSeed, seed, memory_order_relaxed);
+    atomic_store_explicit(&baseSeedSet, true, memory_order_release);
+
+    Random_seed(&threadRandom, seed, 0);
+    threadRandomSeeded = true;
+}
+
+/**
+ * Restart the calling thread's randomInt stream as the given stream of the seed set by initializeRandom, so that the
+ * numbers each thread draws are reproducible regardless of how the threads are scheduled. A thread which never calls
+ * this is given a stream of its own when it first uses randomInt.
+ *
+ * @param threadIndex The index of the calling thread's stream. Index 0 is the stream initializeRandom starts.
+ */
+void initializeThreadRandom(unsigned int const threadIndex) {
+    Random_seed(&threadRandom, ensureBaseSeed(), threadIndex);
+    threadRandomSeeded = true;
 }
 
 /**
- * Generate the next random integer from within the given range.
+ * Generate the next random integer from within the given range, from the calling thread's own stream, with every value
+ * equally likely.
  *
  * @param minInclusive The inclusive lower bound of the random number returned.
  * @param maxExclusive The exclusive upper bound of the random number returned. maxExclusive must be greater than
@@ -38,15 +221,78 @@ int randomInt(int const minInclusive, int const maxExclusive) {
         minInclusive
     );
 
-    ensureRandomInitialized();
-    return rand() % (maxExclusive - minInclusive) + minInclusive;
+    return Random_nextInt(ensureThreadRandom(), minInclusive, maxExclusive);
+}
+
+static uint64_t splitMix64(uint64_t * const statePtr) {
+    *statePtr += splitMix64Gamma;
+    uint64_t mixed = *statePtr;
+    mixed = (mixed ^ (mixed >> 30)) * 0xBF58476D1CE4E5B9u;
+    mixed = (mixed ^ (mixed >> 27)) * 0x94D049BB133111EBu;
+    return mixed ^ (mixed >> 31);
+}
+
+static inline __attribute__((always_inline)) uint64_t rotateLeft(uint64_t const value, int const count) {
+    return (value << count) | (value >> (64 - count));
+}
+
+static inline __attribute__((always_inline)) uint64_t xoshiro256StarStar(uint64_t state[4]) {
+    uint64_t const result = rotateLeft(state[1] * 5, 7) * 9;
+    uint64_t const shifted = state[1] << 17;
+
+    state[2] ^= state[0];
+    state[3] ^= state[1];
+    state[1] ^= state[2];
+    state[0] ^= state[3];
+    state[2] ^= shifted;
+    state[3] = rotateLeft(state[3], 45);
+
+    return result;
+}
+
+/**
+ * Draw from [0, bound) without bias: the high half of the 128-bit product of a draw and the bound is uniform unless the
+ * low half falls below 2^64 mod bound, in which case the draw is rejected.
+ *
+ * @param state The generator state.
+ * @param bound The exclusive upper bound. Must be positive.
+ * @param rejectionThreshold 2^64 mod bound, or 0 to compute it only if it is needed.
+ *
+ * @returns The random integer.
+ */
+static inline __attribute__((always_inline)) uint64_t boundedFrom(
+    uint64_t state[4],
+    uint64_t const bound,
+    uint64_t rejectionThreshold
+) {
+    uint128 product = (uint128)xoshiro256StarStar(state) * bound;
+    if ((uint64_t)product < bound) {
+        if (rejectionThreshold == 0) {
+            rejectionThreshold = (0 - bound) % bound;
+        }
+        while ((uint64_t)product < rejectionThreshold) {
+            product = (uint128)xoshiro256StarStar(state) * bound;
+        }
+    }
+    return (uint64_t)(product >> 64);
 }
 
-static void ensureRandomInitialized(void) {
-    if (randomInitialized) {
-        return;
+static uint64_t ensureBaseSeed(void) {
+    if (!atomic_load_explicit(&baseSeedSet, memory_order_acquire)) {
+        // Every thread which races here must end up with the same seed, so only the first to finish may publish one
+        uint64_t expectedSeed = 0;
+        uint64_t const timeSeed = (uint64_t)safeTime("ensureBaseSeed");
+        atomic_compare_exchange_strong(&baseSeed, &expectedSeed, timeSeed);
+        atomic_store_explicit(&baseSeedSet, true, memory_order_release);
     }
+    return atomic_load_explicit(&baseSeed, memory_order_relaxed);
+}
 
-    initializeRandom((unsigned int)safeTime("ensureRandomInitialized"));
-    randomInitialized = true;
+static struct Random *ensureThreadRandom(void) {
+    if (!threadRandomSeeded) {
+        uint64_t const streamIndex = atomic_fetch_add_explicit(&nextAutomaticStreamIndex, 1, memory_order_relaxed);
+        Random_seed(&threadRandom, ensureBaseSeed(), streamIndex);
+        threadRandomSeeded = true;
+    }
+    return &threadRandom;
 }
@@ -1,10 +1,118 @@
+#define _GNU_SOURCE
+
 #include "../include/util/thread.h"
 
 #include "../include/util/guard.h"
 #include "../include/util/error.h"
+#ifdef MUTEX_PROFILING
+#include "../include/util/macro.h"
+#include "../include/util/time.h"
+#endif
 
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
 #include <string.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <sched.h>
 #include <pthread.h>
+#include <stdatomic.h>
+#include <errno.h>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#ifdef MUTEX_PROFILING
+#include <inttypes.h>
+#endif
+
+static bool readCgroupCpuQuota(double *cpuQuotaOutPtr);
+
+static void futexWait(atomic_int *futexPtr, int expectedValue, char const *callerDescription);
+static void futexWakeOne(atomic_int *futexPtr, char const *callerDescription);
+static inline void cpuRelax(void);
+static void spinWait(unsigned int *spinCountPtr);
+
+static unsigned int const minAdaptiveSpinLimit = 4;
+static unsigned int const maxAdaptiveSpinLimit = 4096;
+static unsigned int const maxAdaptiveBackoffPauses = 64;
+static unsigned int const spinsBeforeYield = 128;
+
+/** A queued ThreadPool task: the function to run and its argument. */
+struct ThreadPoolTask {
+    PthreadCreateStartRoutine routine;
+    void *arg;
+};
+
+/**
+ * A fixed set of threads which run submitted tasks, kept alive between batches of work so that creating and joining
+ * threads is paid once rather than per batch. Tasks wait in a bounded ring buffer; submitting to a full queue blocks
+ * until a thread takes a task.
+ */
+struct ThreadPool {
+    pthread_t *threadIds;
+    size_t threadCount;
+
+    pthread_mutex_t mutex;
+    pthread_cond_t taskQueuedCondition;
+    pthread_cond_t taskTakenCondition;
+    pthread_cond_t idleCondition;
+
+    struct ThreadPoolTask *tasks;
+    size_t queueCapacity;
+    size_t queueStart;
+    size_t queueLength;
+    /** The number of tasks taken from the queue which have not returned yet. */
+    size_t runningTaskCount;
+    bool stopping;
+};
+
+static void ThreadPool_enqueue(ThreadPool pool, PthreadCreateStartRoutine task, void *taskArg);
+static void *ThreadPool_threadStart(void *poolAsVoidPtr);
+
+#ifdef MUTEX_PROFILING
+/** The number of buckets in each histogram. Bucket 0 counts 0 ns; bucket i counts [2^(i-1), 2^i) ns. */
+#define MUTEX_PROFILE_BUCKET_COUNT 40
+
+/**
+ * Counters for every mutex locked with the same callerDescription. Registered slots are never removed, and are updated
+ * with relaxed atomics so that recording does not serialize the threads being profiled.
+ */
+struct MutexProfile {
+    _Atomic(char const *) callerDescription;
+    atomic_uint_fast64_t acquisitionCount;
+    atomic_uint_fast64_t contendedAcquisitionCount;
+    atomic_uint_fast64_t waitHistogram[MUTEX_PROFILE_BUCKET_COUNT];
+    atomic_uint_fast64_t holdHistogram[MUTEX_PROFILE_BUCKET_COUNT];
+};
+
+/** A mutex the calling thread holds, with the profile its hold time is recorded in. */
+struct HeldMutex {
+    pthread_mutex_t const *mutexPtr;
+    struct MutexProfile *profilePtr;
+    uint64_t acquireCycles;
+};
+
+static struct MutexProfile *findMutexProfile(char const *callerDescription);
+static void recordMutexAcquired(
+    pthread_mutex_t const *mutexPtr,
+    char const *callerDescription,
+    bool contended,
+    uint64_t waitNanoseconds
+);
+static void recordMutexReleased(pthread_mutex_t const *mutexPtr, bool stillHeld);
+static void restartMutexHold(pthread_mutex_t const *mutexPtr);
+static void addToHistogram(atomic_uint_fast64_t *histogram, uint64_t nanoseconds);
+static void registerMutexProfileDump(void);
+static void dumpMutexProfiles(void);
+static void writeHistogramJson(atomic_uint_fast64_t const *histogram, FILE *outFile);
+
+static struct MutexProfile mutexProfiles[256];
+static pthread_mutex_t mutexProfileRegistrationMutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_once_t mutexProfileDumpOnce = PTHREAD_ONCE_INIT;
+
+static _Thread_local struct HeldMutex heldMutexes[16];
+static _Thread_local size_t heldMutexCount = 0;
+#endif
 
 /**
  * Create a new thread. If the operation fails, abort the program with an error message.
@@ -73,6 +181,288 @@ void *safePthreadJoin(pthread_t const threadId, char const * const callerDescrip
     return threadReturnValue;
 }
 
+/**
+ * Initialize the given thread attributes memory with the default attributes. If the operation fails, abort the program
+ * with an error message.
+ *
+ * @param attributesOutPtr A pointer to the memory where the attributes should be initialized.
+ * @param callerDescription A description of the caller to be included in the error message. This could be the name of
+ *                          the calling function, plus extra information if useful.
+ */
+void safePthreadAttrInit(pthread_attr_t * const attributesOutPtr, char const * const callerDescription) {
+    guardNotNull(attributesOutPtr, "attributesOutPtr", "safePthreadAttrInit");
+    guardNotNull(callerDescription, "callerDescription", "safePthreadAttrInit");
+
+    int const attrInitErrorCode = pthread_attr_init(attributesOutPtr);
+    if (attrInitErrorCode != 0) {
+        char const * const attrInitErrorMessage = strerror(attrInitErrorCode);
+
+        abortWithErrorFmt(
+            "%s: Failed to create thread attributes using pthread_attr_init (error code: %d; error message: \"%s\")",
+            callerDescription,
+            attrInitErrorCode,
+            attrInitErrorMessage
+        );
+    }
+}
+
+/**
+ * Set the given thread attributes to pin the thread to a single CPU. If the operation fails, abort the program with an
+ * error message.
+ *
+ * @param attributesPtr A pointer to the attributes.
+ * @param cpuSlot Which of the CPUs this process may run on to pin to, counting from 0. Slots beyond the number of
+ *                allowed CPUs wrap around, so consecutive slots spread threads across every allowed CPU.
+ * @param callerDescription A description of the caller to be included in the error message. This could be the name of
+ *                          the calling function, plus extra information if useful.
+ */
+void safePthreadAttrSetCpu(
+    pthread_attr_t * const attributesPtr,
+    size_t const cpuSlot,
+    char const * const callerDescription
+) {
+    guardNotNull(attributesPtr, "attributesPtr", "safePthreadAttrSetCpu");
+    guardNotNull(callerDescription, "callerDescription", "safePthreadAttrSetCpu");
+
+    cpu_set_t allowedCpus;
+    CPU_ZERO(&allowedCpus);
+    if (sched_getaffinity(0, sizeof allowedCpus, &allowedCpus) != 0) {
+        abortWithErrorFmt("%s: Failed to get allowed CPUs using sched_getaffinity", callerDescription);
+        return;
+    }
+
+    size_t const allowedCpuCount = (size_t)CPU_COUNT(&allowedCpus);
+    size_t remainingSlot = cpuSlot % allowedCpuCount;
+    size_t cpu = 0;
+    while (!CPU_ISSET(cpu, &allowedCpus) || remainingSlot > 0) {
+        if (CPU_ISSET(cpu, &allowedCpus)) {
+            remainingSlot -= 1;
+        }
+        cpu += 1;
+    }
+
+    cpu_set_t pinnedCpus;
+    CPU_ZERO(&pinnedCpus);
+    CPU_SET(cpu, &pinnedCpus);
+
+    int const setAffinityErrorCode = pthread_attr_setaffinity_np(attributesPtr, sizeof pinnedCpus, &pinnedCpus);
+    if (setAffinityErrorCode != 0) {
+        char const * const setAffinityErrorMessage = strerror(setAffinityErrorCode);
+
+        abortWithErrorFmt(
+            "%s: Failed to pin thread to CPU %zu using pthread_attr_setaffinity_np"
+            " (error code: %d; error message: \"%s\")",
+            callerDescription,
+            cpu,
+            setAffinityErrorCode,
+            setAffinityErrorMessage
+        );
+    }
+}
+
+/**
+ * Set the size of the stack a thread created with the given attributes gets. If the operation fails (e.g. the size is
+ * below PTHREAD_STACK_MIN), abort the program with an error message.
+ *
+ * @param attributesPtr A pointer to the attributes.
+ * @param stackSize The stack size in bytes.
+ * @param callerDescription A description of the caller to be included in the error message. This could be the name of
+ *                          the calling function, plus extra information if useful.
+ */
+void safePthreadAttrSetStackSize(
+    pthread_attr_t * const attributesPtr,
+    size_t const stackSize,
+    char const * const callerDescription
+) {
+    guardNotNull(attributesPtr, "attributesPtr", "safePthreadAttrSetStackSize");
+    guardNotNull(callerDescription, "callerDescription", "safePthreadAttrSetStackSize");
+
+    int const setStackSizeErrorCode = pthread_attr_setstacksize(attributesPtr, stackSize);
+    if (setStackSizeErrorCode != 0) {
+        char const * const setStackSizeErrorMessage = strerror(setStackSizeErrorCode);
+
+        abortWithErrorFmt(
+            "%s: Failed to set thread stack size to %zu bytes using pthread_attr_setstacksize"
+            " (error code: %d; error message: \"%s\")",
+            callerDescription,
+            stackSize,
+            setStackSizeErrorCode,
+            setStackSizeErrorMessage
+        );
+    }
+}
+
+/**
+ * Destroy the given thread attributes. If the operation fails, abort the program with an error message.
+ *
+ * @param attributesPtr A pointer to the attributes.
+ * @param callerDescription A description of the caller to be included in the error message. This could be the name of
+ *                          the calling function, plus extra information if useful.
+ */
+void safePthreadAttrDestroy(pthread_attr_t * const attributesPtr, char const * const callerDescription) {
+    guardNotNull(attributesPtr, "attributesPtr", "safePthreadAttrDestroy");
+    guardNotNull(callerDescription, "callerDescription", "safePthreadAttrDestroy");
+
+    int const attrDestroyErrorCode = pthread_attr_destroy(attributesPtr);
+    if (attrDestroyErrorCode != 0) {
+        char const * const attrDestroyErrorMessage = strerror(attrDestroyErrorCode);
+
+        abortWithErrorFmt(
+            "%s: Failed to destroy thread attributes using pthread_attr_destroy"
+            " (error code: %d; error message: \"%s\")",
+            callerDescription,
+            attrDestroyErrorCode,
+            attrDestroyErrorMessage
+        );
+    }
+}
+
+/**
+ * Get the number of CPUs this process can actually use: the online CPUs it is allowed to run on, further limited by
+ * the cgroup CPU quota (v2 cpu.max or v1 cpu.cfs_quota_us) if one is set, rounded up.
+ *
+ * @returns The number of usable CPUs, at least 1.
+ */
+unsigned int availableCpuCount(void) {
+    long cpuCount = sysconf(_SC_NPROCESSORS_ONLN);
+
+    cpu_set_t allowedCpus;
+    CPU_ZERO(&allowedCpus);
+    if (sched_getaffinity(0, sizeof allowedCpus, &allowedCpus) == 0) {
+        long const allowedCpuCount = CPU_COUNT(&allowedCpus);
+        if (cpuCount < 1 || allowedCpuCount < cpuCount) {
+            cpuCount = allowedCpuCount;
+        }
+    }
+
+    double cpuQuota;
+    if (readCgroupCpuQuota(&cpuQuota)) {
+        long const quotaCpuCount = (long)cpuQuota + ((double)(long)cpuQuota < cpuQuota ? 1 : 0);
+        if (cpuCount < 1 || quotaCpuCount < cpuCount) {
+            cpuCount = quotaCpuCount;
+        }
+    }
+
+    return cpuCount < 1 ? 1 : (unsigned int)cpuCount;
+}
+
+/**
+ * Park the calling thread until the futex is woken, unless it no longer holds the expected value. Spurious wakeups are
+ * possible, so the caller must re-check its condition. If the operation fails, abort the program with an error message.
+ *
+ * @param futexPtr The futex word.
+ * @param expectedValue The value the futex must still hold for the thread to park.
+ * @param callerDescription A description of the caller to be included in the error message.
+ */
+static void futexWait(atomic_int * const futexPtr, int const expectedValue, char const * const callerDescription) {
+    if (syscall(SYS_futex, futexPtr, FUTEX_WAIT_PRIVATE, expectedValue, NULL, NULL, 0) != 0) {
+        int const futexErrorCode = errno;
+        if (futexErrorCode == EAGAIN || futexErrorCode == EINTR) {
+            return;
+        }
+
+        char const * const futexErrorMessage = strerror(futexErrorCode);
+        abortWithErrorFmt(
+            "%s: Failed to wait on futex using FUTEX_WAIT (error code: %d; error message: \"%s\")",
+            callerDescription,
+            futexErrorCode,
+            futexErrorMessage
+        );
+    }
+}
+
+/**
+ * Wake one thread parked on the futex, if any. If the operation fails, abort the program with an error message.
+ *
+ * @param futexPtr The futex word.
+ * @param callerDescription A description of the caller to be included in the error message.
+ */
+static void futexWakeOne(atomic_int * const futexPtr, char const * const callerDescription) {
+    if (syscall(SYS_futex, futexPtr, FUTEX_WAKE_PRIVATE, 1, NULL, NULL, 0) == -1) {
+        int const futexErrorCode = errno;
+        char const * const futexErrorMessage = strerror(futexErrorCode);
+
+        abortWithErrorFmt(
+            "%s: Failed to wake futex waiter using FUTEX_WAKE (error code: %d; error message: \"%s\")",
+            callerDescription,
+            futexErrorCode,
+            futexErrorMessage
+        );
+    }
+}
+
+/**
+ * Hint to the CPU that the calling thread is busy-waiting, so that it can save power and yield resources to a sibling
+ * hyperthread.
+ */
+static inline void cpuRelax(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    __asm__ __volatile__("yield");
+#endif
+}
+
+/**
+ * Pause once in a spin-wait loop. Once the loop has spun for a while, yield the CPU on every call instead, so that a
+ * preempted lock holder or predecessor can run when there are more spinning threads than CPUs.
+ *
+ * @param spinCountPtr The number of times the loop has spun, starting from 0.
+ */
+static void spinWait(unsigned int * const spinCountPtr) {
+    if (*spinCountPtr < spinsBeforeYield) {
+        cpuRelax();
+        *spinCountPtr += 1;
+    } else {
+        sched_yield();
+    }
+}
+
+/**
+ * Read the cgroup CPU quota of this process, trying cgroup v2 and then v1.
+ *
+ * @param cpuQuotaOutPtr The location to store the quota, in CPUs (quota divided by period).
+ *
+ * @returns Whether a quota is set, or false if it is unlimited or no cgroup CPU controller is available.
+ */
+static bool readCgroupCpuQuota(double * const cpuQuotaOutPtr) {
+    long long quota = -1;
+    long long period = 0;
+
+    FILE * const cpuMaxFile = fopen("/sys/fs/cgroup/cpu.max", "r");
+    if (cpuMaxFile != NULL) {
+        // Either "max <period>" (unlimited) or "<quota> <period>"
+        if (fscanf(cpuMaxFile, "%lld %lld", &quota, &period) != 2) {
+            quota = -1;
+        }
+        fclose(cpuMaxFile);
+    } else {
+        FILE * const quotaFile = fopen("/sys/fs/cgroup/cpu/cpu.cfs_quota_us", "r");
+        FILE * const periodFile = fopen("/sys/fs/cgroup/cpu/cpu.cfs_period_us", "r");
+        if (
+            quotaFile == NULL
+            || periodFile == NULL
+            || fscanf(quotaFile, "%lld", &quota) != 1
+            || fscanf(periodFile, "%lld", &period) != 1
+        ) {
+            quota = -1;
+        }
+        if (quotaFile != NULL) {
+            fclose(quotaFile);
+        }
+        if (periodFile != NULL) {
+            fclose(periodFile);
+        }
+    }
+
+    if (quota <= 0 || period <= 0) {
+        return false;
+    }
+
+    *cpuQuotaOutPtr = (double)quota / (double)period;
+    return true;
+}
+
 /**
  * Initialize the given mutex memory. If the operation fails, abort the program with an error message.
  *
@@ -113,7 +503,17 @@ void safeMutexLock(pthread_mutex_t * const mutexPtr, char const * const callerDe
     guardNotNull(mutexPtr, "mutexPtr", "safeMutexLock");
     guardNotNull(callerDescription, "callerDescription", "safeMutexLock");
 
+#ifdef MUTEX_PROFILING
+    uint64_t const requestCycles = cycleCount();
+    bool contended = false;
+    int mutexLockErrorCode = pthread_mutex_trylock(mutexPtr);
+    if (mutexLockErrorCode == EBUSY) {
+        contended = true;
+        mutexLockErrorCode = pthread_mutex_lock(mutexPtr);
+    }
+#else
     int const mutexLockErrorCode = pthread_mutex_lock(mutexPtr);
+#endif
     if (mutexLockErrorCode != 0) {
         char const * const mutexLockErrorMessage = strerror(mutexLockErrorCode);
 
@@ -123,7 +523,12 @@ void safeMutexLock(pthread_mutex_t * const mutexPtr, char const * const callerDe
             mutexLockErrorCode,
             mutexLockErrorMessage
         );
+        return;
     }
+
+#ifdef MUTEX_PROFILING
+    recordMutexAcquired(mutexPtr, callerDescription, contended, elapsedCycleNanoseconds(requestCycles, cycleCount()));
+#endif
 }
 
 /**
@@ -137,6 +542,9 @@ void safeMutexUnlock(pthread_mutex_t * const mutexPtr, char const * const caller
     guardNotNull(mutexPtr, "mutexPtr", "safeMutexUnlock");
     guardNotNull(callerDescription, "callerDescription", "safeMutexUnlock");
 
+#ifdef MUTEX_PROFILING
+    recordMutexReleased(mutexPtr, false);
+#endif
     int const mutexUnlockErrorCode = pthread_mutex_unlock(mutexPtr);
     if (mutexUnlockErrorCode != 0) {
         char const * const mutexUnlockErrorMessage = strerror(mutexUnlockErrorCode);
@@ -174,6 +582,297 @@ void safeMutexDestroy(pthread_mutex_t * const mutexPtr, char const * const calle
     }
 }
 
+/**
+ * Initialize the given adaptive mutex memory, unlocked.
+ *
+ * @param mutexOutPtr A pointer to the memory where the mutex should be initialized. This pointer must be used directly
+ *                    in all adaptive mutex functions (no copies).
+ * @param callerDescription A description of the caller to be included in the error message. This could be the name of
+ *                          the calling function, plus extra information if useful.
+ */
+void safeAdaptiveMutexInit(struct AdaptiveMutex * const mutexOutPtr, char const * const callerDescription) {
+    guardNotNull(mutexOutPtr, "mutexOutPtr", "safeAdaptiveMutexInit");
+    guardNotNull(callerDescription, "callerDescription", "safeAdaptiveMutexInit");
+
+    atomic_init(&mutexOutPtr->state, 0);
+    atomic_init(&mutexOutPtr->spinLimit, 100);
+}
+
+/**
+ * Lock the given adaptive mutex. If it is already locked, spin with exponential backoff for up to about twice as long
+ * as recent contended acquisitions needed, then park on a futex until it is unlocked. The spin limit moves an eighth of
+ * the way toward the spin count of each acquisition that spinning won, so that it settles near the typical critical
+ * section length, and shrinks by an eighth whenever the thread has to park instead, so that it shrinks when spinning
+ * stops paying off. If the operation fails, abort the program with an error message.
+ *
+ * @param mutexPtr A pointer to the mutex.
+ * @param callerDescription A description of the caller to be included in the error message. This could be the name of
+ *                          the calling function, plus extra information if useful.
+ */
+void safeAdaptiveMutexLock(struct AdaptiveMutex * const mutexPtr, char const * const callerDescription) {
+    guardNotNull(mutexPtr, "mutexPtr", "safeAdaptiveMutexLock");
+    guardNotNull(callerDescription, "callerDescription", "safeAdaptiveMutexLock");
+
+    int unlockedState = 0;
+    if (atomic_compare_exchange_strong_explicit(
+        &mutexPtr->state,
+        &unlockedState,
+        1,
+        memory_order_acquire,
+        memory_order_relaxed
+    )) {
+        return;
+    }
+
+    unsigned int const spinLimit = atomic_load_explicit(&mutexPtr->spinLimit, memory_order_relaxed);
+    unsigned int const maxSpinCount = spinLimit * 2 + 10 < maxAdaptiveSpinLimit
+        ? spinLimit * 2 + 10
+        : maxAdaptiveSpinLimit;
+
+    bool acquired = false;
+    unsigned int spinCount = 0;
+    unsigned int backoffPauses = 1;
+    while (spinCount < maxSpinCount) {
+        for (unsigned int i = 0; i < backoffPauses; i += 1) {
+            cpuRelax();
+        }
+        spinCount += 1;
+        if (backoffPauses < maxAdaptiveBackoffPauses) {
+            backoffPauses *= 2;
+        }
+
+        // Read before trying the exchange so that spinning threads do not keep stealing the cache line from the owner
+        unlockedState = 0;
+        if (
+            atomic_load_explicit(&mutexPtr->state, memory_order_relaxed) == 0
+            && atomic_compare_exchange_weak_explicit(
+                &mutexPtr->state,
+                &unlockedState,
+                1,
+                memory_order_acquire,
+                memory_order_relaxed
+            )
+        ) {
+            acquired = true;
+            break;
+        }
+    }
+
+    // A failed spin always runs to maxSpinCount, so it must not pull the limit toward its spin count
+    long long const newSpinLimit = acquired
+        ? (long long)spinLimit + ((long long)spinCount - (long long)spinLimit) / 8
+        : (long long)spinLimit - (long long)spinLimit / 8;
+    atomic_store_explicit(
+        &mutexPtr->spinLimit,
+        newSpinLimit < minAdaptiveSpinLimit ? minAdaptiveSpinLimit : (unsigned int)newSpinLimit,
+        memory_order_relaxed
+    );
+    if (acquired) {
+        return;
+    }
+
+    // Mark the mutex as having a waiter, so that the unlocking thread knows to wake one
+    while (atomic_exchange_explicit(&mutexPtr->state, 2, memory_order_acquire) != 0) {
+        futexWait(&mutexPtr->state, 2, callerDescription);
+    }
+}
+
+/**
+ * Unlock the given adaptive mutex, waking one parked thread if there may be any. If the operation fails, abort the
+ * program with an error message.
+ *
+ * @param mutexPtr A pointer to the mutex. The mutex must be locked by the calling thread.
+ * @param callerDescription A description of the caller to be included in the error message. This could be the name of
+ *                          the calling function, plus extra information if useful.
+ */
+void safeAdaptiveMutexUnlock(struct AdaptiveMutex * const mutexPtr, char const * const callerDescription) {
+    guardNotNull(mutexPtr, "mutexPtr", "safeAdaptiveMutexUnlock");
+    guardNotNull(callerDescription, "callerDescription", "safeAdaptiveMutexUnlock");
+
+    int const previousState = atomic_exchange_explicit(&mutexPtr->state, 0, memory_order_release);
+    if (previousState == 0) {
+        abortWithErrorFmt("%s: Failed to unlock adaptive mutex: it is not locked", callerDescription);
+        return;
+    }
+    if (previousState == 2) {
+        futexWakeOne(&mutexPtr->state, callerDescription);
+    }
+}
+
+/**
+ * Destroy the given adaptive mutex. If it is still locked, abort the program with an error message.
+ *
+ * @param mutexPtr A pointer to the mutex.
+ * @param callerDescription A description of the caller to be included in the error message. This could be the name of
+ *                          the calling function, plus extra information if useful.
+ */
+void safeAdaptiveMutexDestroy(struct AdaptiveMutex * const mutexPtr, char const * const callerDescription) {
+    guardNotNull(mutexPtr, "mutexPtr", "safeAdaptiveMutexDestroy");
+    guardNotNull(callerDescription, "callerDescription", "safeAdaptiveMutexDestroy");
+
+    if (atomic_load_explicit(&mutexPtr->state, memory_order_relaxed) != 0) {
+        abortWithErrorFmt("%s: Failed to destroy adaptive mutex: it is still locked", callerDescription);
+    }
+}
+
+/**
+ * Initialize the given ticket lock memory, unlocked.
+ *
+ * @param lockOutPtr A pointer to the memory where the lock should be initialized. This pointer must be used directly in
+ *                   all TicketLock functions (no copies).
+ */
+void TicketLock_init(struct TicketLock * const lockOutPtr) {
+    guardNotNull(lockOutPtr, "lockOutPtr", "TicketLock_init");
+
+    atomic_init(&lockOutPtr->nextTicket, 0);
+    atomic_init(&lockOutPtr->nowServing, 0);
+}
+
+/**
+ * Lock the given ticket lock, waiting behind every thread that asked for it earlier.
+ *
+ * @param lockPtr A pointer to the lock.
+ */
+void TicketLock_lock(struct TicketLock * const lockPtr) {
+    guardNotNull(lockPtr, "lockPtr", "TicketLock_lock");
+
+    unsigned int const ticket = atomic_fetch_add_explicit(&lockPtr->nextTicket, 1, memory_order_relaxed);
+
+    unsigned int spinCount = 0;
+    while (true) {
+        unsigned int const servingTicket = atomic_load_explicit(&lockPtr->nowServing, memory_order_acquire);
+        if (servingTicket == ticket) {
+            return;
+        }
+
+        // Back off in proportion to the number of threads ahead, so that fewer waiters poll the line at each handoff
+        for (unsigned int i = ticket - servingTicket; i > 1 && spinCount < spinsBeforeYield; i -= 1) {
+            cpuRelax();
+        }
+        spinWait(&spinCount);
+    }
+}
+
+/**
+ * Unlock the given ticket lock, handing it to the thread with the next ticket.
+ *
+ * @param lockPtr A pointer to the lock. The lock must be locked by the calling thread.
+ */
+void TicketLock_unlock(struct TicketLock * const lockPtr) {
+    guardNotNull(lockPtr, "lockPtr", "TicketLock_unlock");
+
+    // Only the owner writes nowServing, so a plain increment of the value it last saw is enough
+    unsigned int const servingTicket = atomic_load_explicit(&lockPtr->nowServing, memory_order_relaxed);
+    atomic_store_explicit(&lockPtr->nowServing, servingTicket + 1, memory_order_release);
+}
+
+/**
+ * Destroy the given ticket lock. If it is still locked or has waiters, abort the program with an error message.
+ *
+ * @param lockPtr A pointer to the lock.
+ * @param callerDescription A description of the caller to be included in the error message. This could be the name of
+ *                          the calling function, plus extra information if useful.
+ */
+void TicketLock_destroy(struct TicketLock * const lockPtr, char const * const callerDescription) {
+    guardNotNull(lockPtr, "lockPtr", "TicketLock_destroy");
+    guardNotNull(callerDescription, "callerDescription", "TicketLock_destroy");
+
+    if (
+        atomic_load_explicit(&lockPtr->nextTicket, memory_order_relaxed)
+        != atomic_load_explicit(&lockPtr->nowServing, memory_order_relaxed)
+    ) {
+        abortWithErrorFmt("%s: Failed to destroy ticket lock: it is still locked", callerDescription);
+    }
+}
+
+/**
+ * Initialize the given MCS lock memory, unlocked.
+ *
+ * @param lockOutPtr A pointer to the memory where the lock should be initialized. This pointer must be used directly in
+ *                   all McsLock functions (no copies).
+ */
+void McsLock_init(struct McsLock * const lockOutPtr) {
+    guardNotNull(lockOutPtr, "lockOutPtr", "McsLock_init");
+
+    atomic_init(&lockOutPtr->tail, NULL);
+}
+
+/**
+ * Lock the given MCS lock, joining the end of the queue of waiting threads.
+ *
+ * @param lockPtr A pointer to the lock.
+ * @param nodePtr The calling thread's queue node. It must not be in use by another lock operation until the matching
+ *                McsLock_unlock returns.
+ */
+void McsLock_lock(struct McsLock * const lockPtr, struct McsLockNode * const nodePtr) {
+    guardNotNull(lockPtr, "lockPtr", "McsLock_lock");
+    guardNotNull(nodePtr, "nodePtr", "McsLock_lock");
+
+    atomic_store_explicit(&nodePtr->next, NULL, memory_order_relaxed);
+    atomic_store_explicit(&nodePtr->locked, true, memory_order_relaxed);
+
+    struct McsLockNode * const predecessorPtr = atomic_exchange_explicit(&lockPtr->tail, nodePtr, memory_order_acq_rel);
+    if (predecessorPtr == NULL) {
+        return;
+    }
+
+    atomic_store_explicit(&predecessorPtr->next, nodePtr, memory_order_release);
+
+    unsigned int spinCount = 0;
+    while (atomic_load_explicit(&nodePtr->locked, memory_order_acquire)) {
+        spinWait(&spinCount);
+    }
+}
+
+/**
+ * Unlock the given MCS lock, handing it to the next thread in the queue if there is one.
+ *
+ * @param lockPtr A pointer to the lock. The lock must be locked by the calling thread.
+ * @param nodePtr The node the calling thread passed to McsLock_lock.
+ */
+void McsLock_unlock(struct McsLock * const lockPtr, struct McsLockNode * const nodePtr) {
+    guardNotNull(lockPtr, "lockPtr", "McsLock_unlock");
+    guardNotNull(nodePtr, "nodePtr", "McsLock_unlock");
+
+    struct McsLockNode *successorPtr = atomic_load_explicit(&nodePtr->next, memory_order_acquire);
+    if (successorPtr == NULL) {
+        struct McsLockNode *expectedTailPtr = nodePtr;
+        if (atomic_compare_exchange_strong_explicit(
+            &lockPtr->tail,
+            &expectedTailPtr,
+            NULL,
+            memory_order_release,
+            memory_order_relaxed
+        )) {
+            return;
+        }
+
+        // A thread has joined the queue but not yet linked itself to this node
+        unsigned int spinCount = 0;
+        while ((successorPtr = atomic_load_explicit(&nodePtr->next, memory_order_acquire)) == NULL) {
+            spinWait(&spinCount);
+        }
+    }
+
+    atomic_store_explicit(&successorPtr->locked, false, memory_order_release);
+}
+
+/**
+ * Destroy the given MCS lock. If it is still locked or has waiters, abort the program with an error message.
+ *
+ * @param lockPtr A pointer to the lock.
+ * @param callerDescription A description of the caller to be included in the error message. This could be the name of
+ *                          the calling function, plus extra information if useful.
+ */
+void McsLock_destroy(struct McsLock * const lockPtr, char const * const callerDescription) {
+    guardNotNull(lockPtr, "lockPtr", "McsLock_destroy");
+    guardNotNull(callerDescription, "callerDescription", "McsLock_destroy");
+
+    if (atomic_load_explicit(&lockPtr->tail, memory_order_relaxed) != NULL) {
+        abortWithErrorFmt("%s: Failed to destroy MCS lock: it is still locked", callerDescription);
+    }
+}
+
 /**
  * Initialize the given condition memory. If the operation fails, abort the program with an error message.
  *
@@ -227,6 +926,30 @@ void safeConditionSignal(pthread_cond_t * const conditionPtr, char const * const
     }
 }
 
+/**
+ * Signal every thread waiting on the given condition. If the operation fails, abort the program with an error message.
+ *
+ * @param conditionPtr A pointer to the condition.
+ * @param callerDescription A description of the caller to be included in the error message. This could be the name of
+ *                          the calling function, plus extra information if useful.
+ */
+void safeConditionBroadcast(pthread_cond_t * const conditionPtr, char const * const callerDescription) {
+    guardNotNull(conditionPtr, "conditionPtr", "safeConditionBroadcast");
+    guardNotNull(callerDescription, "callerDescription", "safeConditionBroadcast");
+
+    int const condBroadcastErrorCode = pthread_cond_broadcast(conditionPtr);
+    if (condBroadcastErrorCode != 0) {
+        char const * const condBroadcastErrorMessage = strerror(condBroadcastErrorCode);
+
+        abortWithErrorFmt(
+            "%s: Failed to broadcast condition using pthread_cond_broadcast (error code: %d; error message: \"%s\")",
+            callerDescription,
+            condBroadcastErrorCode,
+            condBroadcastErrorMessage
+        );
+    }
+}
+
 /**
  * Wait for the given condition. If the operation fails, abort the program with an error message.
  *
@@ -244,7 +967,13 @@ void safeConditionWait(
     guardNotNull(mutexPtr, "mutexPtr", "safeConditionWait");
     guardNotNull(callerDescription, "callerDescription", "safeConditionWait");
 
+#ifdef MUTEX_PROFILING
+    recordMutexReleased(mutexPtr, true);
+#endif
     int const condWaitErrorCode = pthread_cond_wait(conditionPtr, mutexPtr);
+#ifdef MUTEX_PROFILING
+    restartMutexHold(mutexPtr);
+#endif
     if (condWaitErrorCode != 0) {
         char const * const condWaitErrorMessage = strerror(condWaitErrorCode);
 
@@ -280,3 +1009,403 @@ void safeConditionDestroy(pthread_cond_t * const conditionPtr, char const * cons
         );
     }
 }
+
+/**
+ * Create a thread pool and start its threads. If the operation fails, abort the program with an error message.
+ *
+ * @param threadCount The number of threads. Must be positive.
+ * @param queueCapacity The most tasks that can wait for a thread at once. Must be positive.
+ * @param stackSize The stack size of each thread in bytes, or 0 for the default.
+ * @param pinThreads Whether to pin each thread to its own CPU, wrapping around when there are more threads than CPUs.
+ * @param callerDescription A description of the caller to be included in the error message. This could be the name of
+ *                          the calling function, plus extra information if useful.
+ *
+ * @returns The newly allocated ThreadPool. The caller is responsible for destroying it with ThreadPool_destroy.
+ */
+ThreadPool ThreadPool_create(
+    size_t const threadCount,
+    size_t const queueCapacity,
+    size_t const stackSize,
+    bool const pinThreads,
+    char const * const callerDescription
+) {
+    guard(threadCount > 0, "ThreadPool_create: threadCount must be positive");
+    guard(queueCapacity > 0, "ThreadPool_create: queueCapacity must be positive");
+    guardNotNull(callerDescription, "callerDescription", "ThreadPool_create");
+
+    ThreadPool const pool = safeMalloc(sizeof *pool, "ThreadPool_create");
+    pool->threadIds = safeMalloc(sizeof *pool->threadIds * threadCount, "ThreadPool_create");
+    pool->threadCount = threadCount;
+
+    safeMutexInit(&pool->mutex, NULL, "ThreadPool_create");
+    safeConditionInit(&pool->taskQueuedCondition, NULL, "ThreadPool_create");
+    safeConditionInit(&pool->taskTakenCondition, NULL, "ThreadPool_create");
+    safeConditionInit(&pool->idleCondition, NULL, "ThreadPool_create");
+
+    pool->tasks = safeMalloc(sizeof *pool->tasks * queueCapacity, "ThreadPool_create");
+    pool->queueCapacity = queueCapacity;
+    pool->queueStart = 0;
+    pool->queueLength = 0;
+    pool->runningTaskCount = 0;
+    pool->stopping = false;
+
+    for (size_t i = 0; i < threadCount; i += 1) {
+        pthread_attr_t attributes;
+        safePthreadAttrInit(&attributes, callerDescription);
+        if (stackSize > 0) {
+            safePthreadAttrSetStackSize(&attributes, stackSize, callerDescription);
+        }
+        if (pinThreads) {
+            safePthreadAttrSetCpu(&attributes, i, callerDescription);
+        }
+
+        pool->threadIds[i] = safePthreadCreate(&attributes, ThreadPool_threadStart, pool, callerDescription);
+        safePthreadAttrDestroy(&attributes, callerDescription);
+    }
+
+    return pool;
+}
+
+/**
+ * Wait for every submitted task to finish, then stop the pool's threads and free the memory associated with the
+ * ThreadPool.
+ *
+ * @param pool The ThreadPool instance.
+ */
+void ThreadPool_destroy(ThreadPool const pool) {
+    guardNotNull(pool, "pool", "ThreadPool_destroy");
+
+    safeMutexLock(&pool->mutex, "ThreadPool_destroy");
+    pool->stopping = true;
+    safeConditionBroadcast(&pool->taskQueuedCondition, "ThreadPool_destroy");
+    safeMutexUnlock(&pool->mutex, "ThreadPool_destroy");
+
+    for (size_t i = 0; i < pool->threadCount; i += 1) {
+        safePthreadJoin(pool->threadIds[i], "ThreadPool_destroy");
+    }
+
+    safeConditionDestroy(&pool->idleCondition, "ThreadPool_destroy");
+    safeConditionDestroy(&pool->taskTakenCondition, "ThreadPool_destroy");
+    safeConditionDestroy(&pool->taskQueuedCondition, "ThreadPool_destroy");
+    safeMutexDestroy(&pool->mutex, "ThreadPool_destroy");
+    free(pool->tasks);
+    free(pool->threadIds);
+    free(pool);
+}
+
+/**
+ * Get the number of threads in the pool, which is the most tasks that can run at once.
+ *
+ * @param pool The ThreadPool instance.
+ */
+size_t ThreadPool_threadCount(ConstThreadPool const pool) {
+    guardNotNull(pool, "pool", "ThreadPool_threadCount");
+    return pool->threadCount;
+}
+
+/**
+ * Queue a task to be run by one of the pool's threads, first waiting for room if the queue is full. Tasks are started
+ * in the order they were submitted.
+ *
+ * @param pool The ThreadPool instance.
+ * @param task The function to run. Its return value is ignored.
+ * @param taskArg The argument to pass to task.
+ */
+void ThreadPool_submit(ThreadPool const pool, PthreadCreateStartRoutine const task, void * const taskArg) {
+    guardNotNull(pool, "pool", "ThreadPool_submit");
+    guard(task != NULL, "ThreadPool_submit: task must not be null");
+
+    safeMutexLock(&pool->mutex, "ThreadPool_submit");
+    ThreadPool_enqueue(pool, task, taskArg);
+    safeMutexUnlock(&pool->mutex, "ThreadPool_submit");
+}
+
+/**
+ * Queue one task per element of an array of arguments, holding the queue's lock for the whole batch except while
+ * waiting for room. This is the equivalent of launching a thread per element.
+ *
+ * @param pool The ThreadPool instance.
+ * @param task The function to run for each argument. Its return value is ignored.
+ * @param taskArgs The array of arguments. Task i is passed a pointer to element i.
+ * @param taskArgSize The size of each element of taskArgs.
+ * @param taskCount The number of elements of taskArgs.
+ */
+void ThreadPool_submitBatch(
+    ThreadPool const pool,
+    PthreadCreateStartRoutine const task,
+    void * const taskArgs,
+    size_t const taskArgSize,
+    size_t const taskCount
+) {
+    guardNotNull(pool, "pool", "ThreadPool_submitBatch");
+    guard(task != NULL, "ThreadPool_submitBatch: task must not be null");
+    guard(taskArgs != NULL || taskCount == 0, "ThreadPool_submitBatch: taskArgs must not be null unless count is 0");
+
+    char * const taskArgBytes = taskArgs;
+    safeMutexLock(&pool->mutex, "ThreadPool_submitBatch");
+    for (size_t i = 0; i < taskCount; i += 1) {
+        ThreadPool_enqueue(pool, task, taskArgBytes + i * taskArgSize);
+    }
+    safeMutexUnlock(&pool->mutex, "ThreadPool_submitBatch");
+}
+
+/**
+ * Wait until every submitted task has finished, including tasks submitted by other threads while waiting.
+ *
+ * @param pool The ThreadPool instance.
+ */
+void ThreadPool_waitAll(ThreadPool const pool) {
+    guardNotNull(pool, "pool", "ThreadPool_waitAll");
+
+    safeMutexLock(&pool->mutex, "ThreadPool_waitAll");
+    while (pool->queueLength > 0 || pool->runningTaskCount > 0) {
+        safeConditionWait(&pool->idleCondition, &pool->mutex, "ThreadPool_waitAll");
+    }
+    safeMutexUnlock(&pool->mutex, "ThreadPool_waitAll");
+}
+
+/**
+ * Add a task to the back of the queue, first waiting for room if it is full. The mutex must be held.
+ *
+ * @param pool The ThreadPool instance.
+ * @param task The function to run.
+ * @param taskArg The argument to pass to task.
+ */
+static void ThreadPool_enqueue(ThreadPool const pool, PthreadCreateStartRoutine const task, void * const taskArg) {
+    while (pool->queueLength == pool->queueCapacity) {
+        safeConditionWait(&pool->taskTakenCondition, &pool->mutex, "ThreadPool_enqueue");
+    }
+
+    size_t const taskIndex = (pool->queueStart + pool->queueLength) % pool->queueCapacity;
+    pool->tasks[taskIndex] = (struct ThreadPoolTask){ .routine = task, .arg = taskArg };
+    pool->queueLength += 1;
+    safeConditionSignal(&pool->taskQueuedCondition, "ThreadPool_enqueue");
+}
+
+/**
+ * Run tasks from the front of the queue until the pool is stopping and the queue is empty.
+ */
+static void *ThreadPool_threadStart(void * const poolAsVoidPtr) {
+    ThreadPool const pool = poolAsVoidPtr;
+
+    safeMutexLock(&pool->mutex, "ThreadPool_threadStart");
+    while (true) {
+        while (pool->queueLength == 0 && !pool->stopping) {
+            safeConditionWait(&pool->taskQueuedCondition, &pool->mutex, "ThreadPool_threadStart");
+        }
+        if (pool->queueLength == 0) {
+            break;
+        }
+
+        struct ThreadPoolTask const task = pool->tasks[pool->queueStart];
+        pool->queueStart = (pool->queueStart + 1) % pool->queueCapacity;
+        pool->queueLength -= 1;
+        pool->runningTaskCount += 1;
+        safeConditionSignal(&pool->taskTakenCondition, "ThreadPool_threadStart");
+
+        safeMutexUnlock(&pool->mutex, "ThreadPool_threadStart");
+        task.routine(task.arg);
+        safeMutexLock(&pool->mutex, "ThreadPool_threadStart");
+
+        pool->runningTaskCount -= 1;
+        if (pool->queueLength == 0 && pool->runningTaskCount == 0) {
+            safeConditionBroadcast(&pool->idleCondition, "ThreadPool_threadStart");
+        }
+    }
+    safeMutexUnlock(&pool->mutex, "ThreadPool_threadStart");
+
+    return NULL;
+}
+
+#ifdef MUTEX_PROFILING
+/**
+ * Find the profile for the given callerDescription, registering it if it has not been seen yet.
+ *
+ * @param callerDescription The description passed to safeMutexLock.
+ *
+ * @returns The profile, or null if every profile slot is taken by other descriptions.
+ */
+static struct MutexProfile *findMutexProfile(char const * const callerDescription) {
+    // FNV-1a
+    uint64_t hash = 14695981039346656037u;
+    for (char const *c = callerDescription; *c != '\0'; c += 1) {
+        hash = (hash ^ (unsigned char)*c) * 1099511628211u;
+    }
+
+    for (size_t probe = 0; probe < ARRAY_LENGTH(mutexProfiles); probe += 1) {
+        struct MutexProfile * const profilePtr = &mutexProfiles[(hash + probe) % ARRAY_LENGTH(mutexProfiles)];
+
+        char const *slotDescription = atomic_load_explicit(&profilePtr->callerDescription, memory_order_acquire);
+        if (slotDescription == NULL) {
+            pthread_mutex_lock(&mutexProfileRegistrationMutex);
+            slotDescription = atomic_load_explicit(&profilePtr->callerDescription, memory_order_relaxed);
+            if (slotDescription == NULL) {
+                // The caller's string may not outlive the program, and the dump runs at exit
+                slotDescription = strdup(callerDescription);
+                if (slotDescription == NULL) {
+                    pthread_mutex_unlock(&mutexProfileRegistrationMutex);
+                    return NULL;
+                }
+                atomic_store_explicit(&profilePtr->callerDescription, slotDescription, memory_order_release);
+                pthread_once(&mutexProfileDumpOnce, registerMutexProfileDump);
+            }
+            pthread_mutex_unlock(&mutexProfileRegistrationMutex);
+        }
+
+        if (strcmp(slotDescription, callerDescription) == 0) {
+            return profilePtr;
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * Count an acquisition of the given mutex and start timing how long the calling thread holds it.
+ *
+ * @param mutexPtr The mutex, now held by the calling thread.
+ * @param callerDescription The description passed to safeMutexLock, which keys the profile.
+ * @param contended Whether the mutex was already locked when the thread first tried to take it.
+ * @param waitNanoseconds How long the thread took to acquire the mutex.
+ */
+static void recordMutexAcquired(
+    pthread_mutex_t const * const mutexPtr,
+    char const * const callerDescription,
+    bool const contended,
+    uint64_t const waitNanoseconds
+) {
+    struct MutexProfile * const profilePtr = findMutexProfile(callerDescription);
+    if (profilePtr == NULL) {
+        return;
+    }
+
+    atomic_fetch_add_explicit(&profilePtr->acquisitionCount, 1, memory_order_relaxed);
+    if (contended) {
+        atomic_fetch_add_explicit(&profilePtr->contendedAcquisitionCount, 1, memory_order_relaxed);
+    }
+    addToHistogram(profilePtr->waitHistogram, waitNanoseconds);
+
+    // Deeper nesting than this is not timed
+    if (heldMutexCount < ARRAY_LENGTH(heldMutexes)) {
+        heldMutexes[heldMutexCount] = (struct HeldMutex){
+            .mutexPtr = mutexPtr,
+            .profilePtr = profilePtr,
+            .acquireCycles = cycleCount()
+        };
+        heldMutexCount += 1;
+    }
+}
+
+/**
+ * Count how long the calling thread held the given mutex.
+ *
+ * @param mutexPtr The mutex, about to be released by the calling thread.
+ * @param stillHeld Whether the thread will hold the mutex again afterward (a condition wait), in which case timing
+ *                  resumes with restartMutexHold.
+ */
+static void recordMutexReleased(pthread_mutex_t const * const mutexPtr, bool const stillHeld) {
+    for (size_t i = heldMutexCount; i > 0; i -= 1) {
+        struct HeldMutex * const heldMutexPtr = &heldMutexes[i - 1];
+        if (heldMutexPtr->mutexPtr != mutexPtr) {
+            continue;
+        }
+
+        addToHistogram(
+            heldMutexPtr->profilePtr->holdHistogram,
+            elapsedCycleNanoseconds(heldMutexPtr->acquireCycles, cycleCount())
+        );
+        if (!stillHeld) {
+            memmove(heldMutexPtr, heldMutexPtr + 1, (heldMutexCount - i) * sizeof *heldMutexPtr);
+            heldMutexCount -= 1;
+        }
+        return;
+    }
+}
+
+/**
+ * Resume timing how long the calling thread holds the given mutex, after a condition wait has reacquired it.
+ *
+ * @param mutexPtr The mutex.
+ */
+static void restartMutexHold(pthread_mutex_t const * const mutexPtr) {
+    for (size_t i = heldMutexCount; i > 0; i -= 1) {
+        if (heldMutexes[i - 1].mutexPtr == mutexPtr) {
+            heldMutexes[i - 1].acquireCycles = cycleCount();
+            return;
+        }
+    }
+}
+
+/**
+ * Count a duration in its power-of-two histogram bucket.
+ *
+ * @param histogram The histogram, MUTEX_PROFILE_BUCKET_COUNT buckets long.
+ * @param nanoseconds The duration.
+ */
+static void addToHistogram(atomic_uint_fast64_t * const histogram, uint64_t const nanoseconds) {
+    size_t bucket = nanoseconds == 0 ? 0 : (size_t)(64 - __builtin_clzll(nanoseconds));
+    if (bucket >= MUTEX_PROFILE_BUCKET_COUNT) {
+        bucket = MUTEX_PROFILE_BUCKET_COUNT - 1;
+    }
+    atomic_fetch_add_explicit(&histogram[bucket], 1, memory_order_relaxed);
+}
+
+/**
+ * Arrange for the profiles to be dumped when the program exits.
+ */
+static void registerMutexProfileDump(void) {
+    atexit(dumpMutexProfiles);
+}
+
+/**
+ * Write every mutex profile to stderr as a JSON object, one profile per line.
+ */
+static void dumpMutexProfiles(void) {
+    fprintf(stderr, "{\"mutexProfiles\": [");
+
+    bool first = true;
+    for (size_t i = 0; i < ARRAY_LENGTH(mutexProfiles); i += 1) {
+        struct MutexProfile const * const profilePtr = &mutexProfiles[i];
+        char const * const callerDescription = atomic_load(&profilePtr->callerDescription);
+        if (callerDescription == NULL) {
+            continue;
+        }
+
+        fprintf(
+            stderr,
+            "%s\n  {\"callerDescription\": \"%s\", \"acquisitions\": %" PRIuFAST64
+            ", \"contendedAcquisitions\": %" PRIuFAST64 ", \"waitNanosecondsHistogram\": ",
+            first ? "" : ",",
+            callerDescription,
+            atomic_load(&profilePtr->acquisitionCount),
+            atomic_load(&profilePtr->contendedAcquisitionCount)
+        );
+        writeHistogramJson(profilePtr->waitHistogram, stderr);
+        fprintf(stderr, ", \"holdNanosecondsHistogram\": ");
+        writeHistogramJson(profilePtr->holdHistogram, stderr);
+        fprintf(stderr, "}");
+        first = false;
+    }
+
+    fprintf(stderr, "\n]}\n");
+}
+
+/**
+ * Write a histogram as a JSON array of bucket counts, omitting the empty buckets at the end.
+ *
+ * @param histogram The histogram, MUTEX_PROFILE_BUCKET_COUNT buckets long.
+ * @param outFile The file to write to.
+ */
+static void writeHistogramJson(atomic_uint_fast64_t const * const histogram, FILE * const outFile) {
+    size_t bucketCount = MUTEX_PROFILE_BUCKET_COUNT;
+    while (bucketCount > 0 && atomic_load(&histogram[bucketCount - 1]) == 0) {
+        bucketCount -= 1;
+    }
+
+    fprintf(outFile, "[");
+    for (size_t i = 0; i < bucketCount; i += 1) {
+        fprintf(outFile, "%s%" PRIuFAST64, i == 0 ? "" : ", ", atomic_load(&histogram[i]));
+    }
+    fprintf(outFile, "]");
+}
+#endif
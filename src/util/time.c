@@ -2,9 +2,32 @@
 
 #include "../include/util/error.h"
 
+#include <stdint.h>
+#include <stdbool.h>
 #include <string.h>
 #include <time.h>
 #include <errno.h>
+#include <pthread.h>
+#include <sys/time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#include <cpuid.h>
+#endif
+
+__extension__ typedef unsigned __int128 uint128;
+
+static void calibrateCycleCounterOnce(void);
+static bool hasInvariantTsc(void);
+
+static pthread_once_t cycleCounterCalibrateOnce = PTHREAD_ONCE_INIT;
+/** Whether cycleCount reads the time stamp counter, rather than falling back to the monotonic clock. */
+static bool cycleCounterUsesTsc = false;
+/** Nanoseconds per cycle, as a fixed-point number with 32 fractional bits. */
+static uint64_t nanosecondsPerCycleFixed = (uint64_t)1 << 32;
+
+/** How long calibrateCycleCounter compares the time stamp counter against the monotonic clock. */
+static uint64_t const cycleCounterCalibrationNanoseconds = 2 * 1000 * 1000;
 
 /**
  * Get the current time. If the operation fails, abort the program with an error message.
@@ -31,3 +54,229 @@ time_t safeTime(char const * const callerDescription) {
 
     return timeResult;
 }
+
+/**
+ * Get the current time of the given clock. If the operation fails, abort the program with an error message.
+ *
+ * @param clockId The clock, e.g. CLOCK_MONOTONIC.
+ * @param callerDescription A description of the caller to be included in the error message. This could be the name of
+ *                          the calling function, plus extra information if useful.
+ *
+ * @returns The current time of the clock.
+ */
+struct timespec safeClockGettime(clockid_t const clockId, char const * const callerDescription) {
+    struct timespec time;
+    if (clock_gettime(clockId, &time) != 0) {
+        int const clockGettimeErrorCode = errno;
+        char const * const clockGettimeErrorMessage = strerror(clockGettimeErrorCode);
+
+        abortWithErrorFmt(
+            "%s: Failed to get time of clock %d using clock_gettime (error code: %d; error message: \"%s\")",
+            callerDescription,
+            (int)clockId,
+            clockGettimeErrorCode,
+            clockGettimeErrorMessage
+        );
+        return (struct timespec){ .tv_sec = -1, .tv_nsec = -1 };
+    }
+
+    return time;
+}
+
+/**
+ * Sleep until the given clock reaches the given time, resuming the sleep if a signal interrupts it. If the operation
+ * fails, abort the program with an error message.
+ *
+ * @param clockId The clock, e.g. CLOCK_MONOTONIC.
+ * @param wakeTime The absolute time of the clock at which to wake. If it has already passed, this returns immediately.
+ * @param callerDescription A description of the caller to be included in the error message. This could be the name of
+ *                          the calling function, plus extra information if useful.
+ */
+void safeClockNanosleepUntil(
+    clockid_t const clockId,
+    struct timespec const wakeTime,
+    char const * const callerDescription
+) {
+    int clockNanosleepErrorCode;
+    do {
+        clockNanosleepErrorCode = clock_nanosleep(clockId, TIMER_ABSTIME, &wakeTime, NULL);
+    } while (clockNanosleepErrorCode == EINTR);
+
+    if (clockNanosleepErrorCode != 0) {
+        char const * const clockNanosleepErrorMessage = strerror(clockNanosleepErrorCode);
+
+        abortWithErrorFmt(
+            "%s: Failed to sleep on clock %d using clock_nanosleep (error code: %d; error message: \"%s\")",
+            callerDescription,
+            (int)clockId,
+            clockNanosleepErrorCode,
+            clockNanosleepErrorMessage
+        );
+    }
+}
+
+/**
+ * Get the current time of the monotonic clock as a single count. glibc answers this from the vDSO, without a system
+ * call. If the operation fails, abort the program with an error message.
+ *
+ * @returns The time in nanoseconds.
+ */
+uint64_t monotonicNanoseconds(void) {
+    return timespecToNanoseconds(safeClockGettime(CLOCK_MONOTONIC, "monotonicNanoseconds"));
+}
+
+/**
+ * Get the CPU time the calling thread has used so far. If the operation fails, abort the program with an error
+ * message.
+ *
+ * @returns The time in nanoseconds.
+ */
+uint64_t threadCpuNanoseconds(void) {
+    return timespecToNanoseconds(safeClockGettime(CLOCK_THREAD_CPUTIME_ID, "threadCpuNanoseconds"));
+}
+
+/**
+ * Convert a timespec, either a time of a clock or a duration, to a single count.
+ *
+ * @param time The time. Must not be negative.
+ *
+ * @returns The time in nanoseconds.
+ */
+uint64_t timespecToNanoseconds(struct timespec const time) {
+    return (uint64_t)time.tv_sec * 1000 * 1000 * 1000 + (uint64_t)time.tv_nsec;
+}
+
+/**
+ * Convert a timeval, such as a CPU time from getrusage, to a single count.
+ *
+ * @param time The time. Must not be negative.
+ *
+ * @returns The time in nanoseconds.
+ */
+uint64_t timevalToNanoseconds(struct timeval const time) {
+    return (uint64_t)time.tv_sec * 1000 * 1000 * 1000 + (uint64_t)time.tv_usec * 1000;
+}
+
+/**
+ * Get the time between two readings of the same clock.
+ *
+ * @param startTime The earlier reading.
+ * @param endTime The later reading.
+ *
+ * @returns The time in nanoseconds, or 0 if endTime is before startTime.
+ */
+uint64_t elapsedNanoseconds(struct timespec const startTime, struct timespec const endTime) {
+    int64_t const nanoseconds = (
+        (int64_t)(endTime.tv_sec - startTime.tv_sec) * 1000 * 1000 * 1000
+        + (int64_t)(endTime.tv_nsec - startTime.tv_nsec)
+    );
+    return nanoseconds < 0 ? 0 : (uint64_t)nanoseconds;
+}
+
+/**
+ * Convert a count of nanoseconds to seconds, e.g. for display.
+ *
+ * @param nanoseconds The time in nanoseconds.
+ *
+ * @returns The time in seconds.
+ */
+double nanosecondsToSeconds(uint64_t const nanoseconds) {
+    return (double)nanoseconds / (1000 * 1000 * 1000);
+}
+
+/**
+ * Measure the rate of the cycle counter against the monotonic clock, if this has not been done yet. This busy-waits for
+ * a couple of milliseconds, so a program should call it before starting anything it times; otherwise the first call to
+ * cycleCount does it.
+ *
+ * The cycle counter is the x86 time stamp counter when the CPU reports that it ticks at a constant rate regardless of
+ * frequency scaling and sleep states (an invariant TSC). On any other CPU, the cycle counter is the monotonic clock
+ * itself, counting nanoseconds.
+ */
+void calibrateCycleCounter(void) {
+    pthread_once(&cycleCounterCalibrateOnce, calibrateCycleCounterOnce);
+}
+
+/**
+ * Read the cycle counter. This is a single unserialized instruction with an invariant TSC, several times cheaper than
+ * even the vDSO clock_gettime, so it suits timing short spans such as lock waits in the hot path. Cycles only measure
+ * durations: take the difference of two readings on the same thread and convert it with cyclesToNanoseconds.
+ *
+ * @returns The cycle count.
+ */
+uint64_t cycleCount(void) {
+    calibrateCycleCounter();
+
+#if defined(__x86_64__) || defined(__i386__)
+    if (cycleCounterUsesTsc) {
+        return __rdtsc();
+    }
+#endif
+    return monotonicNanoseconds();
+}
+
+/**
+ * Convert a number of cycles, as measured with cycleCount, to nanoseconds.
+ *
+ * @param cycles The number of cycles.
+ *
+ * @returns The number of nanoseconds.
+ */
+uint64_t cyclesToNanoseconds(uint64_t const cycles) {
+    calibrateCycleCounter();
+
+    return (uint64_t)(((uint128)cycles * nanosecondsPerCycleFixed) >> 32);
+}
+
+/**
+ * Get the time between two readings of cycleCount.
+ *
+ * @param startCycles The earlier reading.
+ * @param endCycles The later reading.
+ *
+ * @returns The time in nanoseconds, or 0 if endCycles is before startCycles (as can happen if the thread moved between
+ *          CPUs whose counters are slightly out of step).
+ */
+uint64_t elapsedCycleNanoseconds(uint64_t const startCycles, uint64_t const endCycles) {
+    return endCycles <= startCycles ? 0 : cyclesToNanoseconds(endCycles - startCycles);
+}
+
+static void calibrateCycleCounterOnce(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    if (!hasInvariantTsc()) {
+        return;
+    }
+
+    uint64_t const startNanoseconds = monotonicNanoseconds();
+    uint64_t const startCycles = __rdtsc();
+    uint64_t endNanoseconds;
+    uint64_t endCycles;
+    do {
+        endNanoseconds = monotonicNanoseconds();
+        endCycles = __rdtsc();
+    } while (endNanoseconds - startNanoseconds < cycleCounterCalibrationNanoseconds);
+
+    if (endCycles <= startCycles) {
+        return;
+    }
+    uint128 const scaledNanoseconds = (uint128)(endNanoseconds - startNanoseconds) << 32;
+    nanosecondsPerCycleFixed = (uint64_t)(scaledNanoseconds / (endCycles - startCycles));
+    cycleCounterUsesTsc = true;
+#endif
+}
+
+static bool hasInvariantTsc(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    unsigned int eax;
+    unsigned int ebx;
+    unsigned int ecx;
+    unsigned int edx;
+    // CPUID leaf 0x80000007 (advanced power management) reports an invariant TSC in EDX bit 8
+    if (__get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx) == 0) {
+        return false;
+    }
+    return (edx & (1u << 8)) != 0;
+#else
+    return false;
+#endif
+}
@@ -0,0 +1,208 @@
+#include "../../include/util/workStealing.h"
+
+#include "../../include/util/memory.h"
+#include "../../include/util/thread.h"
+#include "../../include/util/guard.h"
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include <assert.h>
+
+/**
+ * One worker's deque of chunks. Since chunks are assigned as contiguous runs, the deque is the range of chunk indexes
+ * [frontChunk, backChunk). The owner takes chunks from the front, in input order, and thieves take the back half.
+ */
+struct WorkStealingDeque {
+    pthread_mutex_t mutex;
+    size_t frontChunk;
+    size_t backChunk;
+};
+
+struct WorkStealingWorkerThreadStartArg {
+    unsigned int workerIndex;
+    struct WorkStealingDeque *deques;
+    unsigned int workerCount;
+    size_t itemCount;
+    size_t chunkSize;
+    void *state;
+    WorkStealingRangeCallback callback;
+};
+static void *workStealingWorkerThreadStart(void *argAsVoidPtr);
+
+static bool takeOwnChunk(struct WorkStealingDeque *dequePtr, size_t *chunkOutPtr);
+static bool stealChunks(struct WorkStealingDeque *deques, unsigned int workerCount, unsigned int thiefIndex);
+
+/**
+ * Process items 0 to itemCount - 1 on a set of worker threads using work stealing. The items are split into chunks, and
+ * each worker starts with an equal contiguous run of chunks in its own deque. A worker whose deque runs dry steals the
+ * back half of another worker's remaining chunks, so that every worker stays busy until the last chunk is claimed even
+ * when some chunks or workers are slower than others. Returns once every item has been processed.
+ *
+ * @param itemCount The number of items.
+ * @param chunkSize The number of items per chunk. Must be positive.
+ * @param workerCount The number of worker threads to run. Must be positive.
+ * @param workerAttributes The attributes to create each worker thread with (an array of workerCount), or null to use
+ *                         the default attributes.
+ * @param workerPool The thread pool to run the workers on instead of creating threads for them, or null. It must have
+ *                   at least workerCount threads free, since the workers wait on each other. workerAttributes is not
+ *                   used with a pool.
+ * @param state The state to pass to the callback.
+ * @param callback The function to call for each chunk, with the state, the index of the worker running it, and the
+ *                 chunk's start (inclusive) and end (exclusive) item indexes. Called concurrently from every worker.
+ */
+void runWorkStealing(
+    size_t const itemCount,
+    size_t const chunkSize,
+    unsigned int const workerCount,
+    pthread_attr_t const * const workerAttributes,
+    ThreadPool const workerPool,
+    void * const state,
+    WorkStealingRangeCallback const callback
+) {
+    guard(chunkSize > 0, "runWorkStealing: chunkSize must be positive");
+    guard(workerCount > 0, "runWorkStealing: workerCount must be positive");
+    guard(callback != NULL, "runWorkStealing: callback must not be null");
+    guard(
+        workerPool == NULL || ThreadPool_threadCount(workerPool) >= workerCount,
+        "runWorkStealing: workerPool must have at least workerCount threads"
+    );
+
+    size_t const chunkCount = (itemCount + chunkSize - 1) / chunkSize;
+
+    struct WorkStealingDeque * const deques = safeMalloc(sizeof *deques * workerCount, "runWorkStealing");
+    for (unsigned int i = 0; i < workerCount; i += 1) {
+        struct WorkStealingDeque * const dequePtr = &deques[i];
+
+        safeMutexInit(&dequePtr->mutex, NULL, "runWorkStealing");
+        dequePtr->frontChunk = chunkCount * i / workerCount;
+        dequePtr->backChunk = chunkCount * (i + 1) / workerCount;
+    }
+
+    struct WorkStealingWorkerThreadStartArg * const threadStartArgs = (
+        safeMalloc(sizeof *threadStartArgs * workerCount, "runWorkStealing")
+    );
+    for (unsigned int i = 0; i < workerCount; i += 1) {
+        struct WorkStealingWorkerThreadStartArg * const threadStartArgPtr = &threadStartArgs[i];
+
+        threadStartArgPtr->workerIndex = i;
+        threadStartArgPtr->deques = deques;
+        threadStartArgPtr->workerCount = workerCount;
+        threadStartArgPtr->itemCount = itemCount;
+        threadStartArgPtr->chunkSize = chunkSize;
+        threadStartArgPtr->state = state;
+        threadStartArgPtr->callback = callback;
+    }
+
+    if (workerPool != NULL) {
+        ThreadPool_submitBatch(
+            workerPool,
+            workStealingWorkerThreadStart,
+            threadStartArgs,
+            sizeof *threadStartArgs,
+            workerCount
+        );
+        ThreadPool_waitAll(workerPool);
+    } else {
+        pthread_t * const threadIds = safeMalloc(sizeof *threadIds * workerCount, "runWorkStealing");
+        for (unsigned int i = 0; i < workerCount; i += 1) {
+            threadIds[i] = safePthreadCreate(
+                workerAttributes == NULL ? NULL : &workerAttributes[i],
+                workStealingWorkerThreadStart,
+                &threadStartArgs[i],
+                "runWorkStealing"
+            );
+        }
+        for (unsigned int i = 0; i < workerCount; i += 1) {
+            safePthreadJoin(threadIds[i], "runWorkStealing");
+        }
+        free(threadIds);
+    }
+
+    for (unsigned int i = 0; i < workerCount; i += 1) {
+        safeMutexDestroy(&deques[i].mutex, "runWorkStealing");
+    }
+    free(threadStartArgs);
+    free(deques);
+}
+
+static void *workStealingWorkerThreadStart(void * const argAsVoidPtr) {
+    assert(argAsVoidPtr != NULL);
+    struct WorkStealingWorkerThreadStartArg * const argPtr = argAsVoidPtr;
+    struct WorkStealingDeque * const ownDequePtr = &argPtr->deques[argPtr->workerIndex];
+
+    while (true) {
+        size_t chunk;
+        if (!takeOwnChunk(ownDequePtr, &chunk)) {
+            // No chunks are ever added after the start, so once every deque is empty the work is done
+            if (!stealChunks(argPtr->deques, argPtr->workerCount, argPtr->workerIndex)) {
+                break;
+            }
+            continue;
+        }
+
+        size_t const itemStart = chunk * argPtr->chunkSize;
+        size_t const itemEnd = itemStart + argPtr->chunkSize < argPtr->itemCount
+            ? itemStart + argPtr->chunkSize
+            : argPtr->itemCount;
+        argPtr->callback(argPtr->state, argPtr->workerIndex, itemStart, itemEnd);
+    }
+
+    return NULL;
+}
+
+/**
+ * Take the front chunk of the worker's own deque.
+ *
+ * @returns Whether a chunk was taken, or false if the deque is empty.
+ */
+static bool takeOwnChunk(struct WorkStealingDeque * const dequePtr, size_t * const chunkOutPtr) {
+    safeMutexLock(&dequePtr->mutex, "runWorkStealing takeOwnChunk");
+
+    bool const taken = dequePtr->frontChunk < dequePtr->backChunk;
+    if (taken) {
+        *chunkOutPtr = dequePtr->frontChunk;
+        dequePtr->frontChunk += 1;
+    }
+
+    safeMutexUnlock(&dequePtr->mutex, "runWorkStealing takeOwnChunk");
+    return taken;
+}
+
+/**
+ * Move the back half (rounded up) of the first non-empty victim deque into the thief's own deque, which must be empty.
+ * Victims are tried in order starting after the thief so that thieves spread out across victims.
+ *
+ * @returns Whether any chunks were stolen, or false if every other deque is empty.
+ */
+static bool stealChunks(
+    struct WorkStealingDeque * const deques,
+    unsigned int const workerCount,
+    unsigned int const thiefIndex
+) {
+    for (unsigned int offset = 1; offset < workerCount; offset += 1) {
+        struct WorkStealingDeque * const victimDequePtr = &deques[(thiefIndex + offset) % workerCount];
+
+        safeMutexLock(&victimDequePtr->mutex, "runWorkStealing stealChunks");
+
+        size_t const remainingChunkCount = victimDequePtr->backChunk - victimDequePtr->frontChunk;
+        size_t const stolenFrontChunk = victimDequePtr->backChunk - (remainingChunkCount + 1) / 2;
+        size_t const stolenBackChunk = victimDequePtr->backChunk;
+        victimDequePtr->backChunk = stolenFrontChunk;
+
+        safeMutexUnlock(&victimDequePtr->mutex, "runWorkStealing stealChunks");
+
+        if (stolenFrontChunk < stolenBackChunk) {
+            struct WorkStealingDeque * const thiefDequePtr = &deques[thiefIndex];
+
+            safeMutexLock(&thiefDequePtr->mutex, "runWorkStealing stealChunks");
+            thiefDequePtr->frontChunk = stolenFrontChunk;
+            thiefDequePtr->backChunk = stolenBackChunk;
+            safeMutexUnlock(&thiefDequePtr->mutex, "runWorkStealing stealChunks");
+
+            return true;
+        }
+    }
+
+    return false;
+}